@@ -0,0 +1,51 @@
+#ifndef __BENCHMARK_COMMON_HPP__
+#define __BENCHMARK_COMMON_HPP__
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+// statistics and output shared by every benchmark executable
+
+// the init functions are chatty, this keeps their output from drowning the numbers while it's in scope
+class QuietCout {
+public:
+    QuietCout(bool quiet = true) : m_buffer(quiet ? std::cout.rdbuf(nullptr) : std::cout.rdbuf()) {}
+    ~QuietCout() {
+        std::cout.rdbuf(m_buffer);
+        std::cout.clear();
+    }
+
+private:
+    QuietCout(const QuietCout& other) = delete;
+    QuietCout& operator=(const QuietCout& other) = delete;
+
+    std::streambuf* m_buffer{ nullptr };
+};
+
+// nearest rank, so p99 of fewer than 100 samples is just the max
+inline double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+// writes the fields of a stats object, every key but samples ends in _unit. with_first adds the first sample as it came
+// in, before sorting, which is the cold run for anything that warms up
+inline void write_stats(std::ostream& out, const std::vector<double>& samples, const char* unit, bool with_first = false) {
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+
+    out << "\"samples\":" << sorted.size();
+    if (sorted.empty()) {
+        return;
+    }
+
+    if (with_first) {
+        out << ",\"first_" << unit << "\":" << samples.front();
+    }
+    out << ",\"min_" << unit << "\":" << sorted.front() << ",\"median_" << unit << "\":" << percentile(sorted, 0.5)
+        << ",\"p99_" << unit << "\":" << percentile(sorted, 0.99) << ",\"max_" << unit << "\":" << sorted.back();
+}
+
+#endif // __BENCHMARK_COMMON_HPP__
@@ -0,0 +1,181 @@
+#include "vulkan_device.hpp"
+#include "vulkan_dispatch.hpp"
+#include "queue_timeline.hpp"
+#include "profiler.hpp"
+#include "benchmark_common.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+// times the same vulkan calls through the loader's exported trampolines and through the device dispatch table, so the per
+// call overhead the table saves shows up on its own. run it against a software icd, e.g.
+// VK_ICD_FILENAMES=.../lvp_icd.x86_64.json, the driver side of these calls is cheap there so the loader cost isn't hidden
+
+struct BenchmarkOptions {
+    uint32_t iterations{ 50 };
+    uint32_t calls{ 100000 };
+    std::string output_path{}; // json goes to stdout when empty
+};
+
+struct FunctionSamples {
+    const char* name{ nullptr };
+    std::vector<double> loader_ns{};
+    std::vector<double> dispatch_ns{};
+};
+
+static BenchmarkOptions parse_options(int argc, char** argv) {
+    BenchmarkOptions options{};
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            options.iterations = std::max(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)), 1u);
+        }
+        else if (std::strcmp(argv[i], "--calls") == 0 && i + 1 < argc) {
+            options.calls = std::max(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)), 1u);
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            options.output_path = argv[++i];
+        }
+        else {
+            std::cerr << "unknown argument: " << argv[i] << ", usage: [--iterations <count>] [--calls <count>] [--output <path>]\n";
+            std::exit(-1);
+        }
+    }
+
+    return options;
+}
+
+// average cost of one call in ns over `calls` calls of fn
+template<typename Fn>
+static double time_calls(uint32_t calls, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < calls; i++) {
+        fn();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options = parse_options(argc, argv);
+
+    vlk::VulkanDevice* device = nullptr;
+    {
+        QuietCout quiet{};
+        device = new vlk::VulkanDevice(vlk::HeadlessInfo{});
+    }
+
+    const vlk::VulkanDeviceDispatch& dispatch = device->get_dispatch();
+    VkSemaphore semaphore = device->get_timeline(vlk::QueueType::Graphics)->get_semaphore();
+
+    VkCommandPoolCreateInfo pool_create_info{};
+    pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_create_info.queueFamilyIndex = device->get_queue_family(vlk::QueueType::Graphics);
+
+    VkCommandPool command_pool = nullptr;
+    if (vkCreateCommandPool(device->get_device(), &pool_create_info, device->get_allocation_callbacks(), &command_pool) != VK_SUCCESS) {
+        std::cerr << "failed to create benchmark command pool\n";
+        return -1;
+    }
+
+    VkCommandBufferAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocate_info.commandPool = command_pool;
+    allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocate_info.commandBufferCount = 1;
+
+    VkCommandBuffer command_buffer = nullptr;
+    if (vkAllocateCommandBuffers(device->get_device(), &allocate_info, &command_buffer) != VK_SUCCESS) {
+        std::cerr << "failed to allocate benchmark command buffer\n";
+        return -1;
+    }
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VkViewport viewport{ 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f };
+    VkRect2D scissor{ { 0, 0 }, { 1280, 720 } };
+    uint64_t counter_value = 0;
+
+    FunctionSamples set_viewport{ "vkCmdSetViewport" };
+    FunctionSamples set_scissor{ "vkCmdSetScissor" };
+    FunctionSamples semaphore_counter{ "vkGetSemaphoreCounterValue" };
+
+    for (uint32_t iteration = 0; iteration < options.iterations; iteration++) {
+        // alternate which path goes first so neither one always gets the warm caches
+        bool loader_first = (iteration % 2) == 0;
+
+        for (uint32_t pass = 0; pass < 2; pass++) {
+            bool loader = (pass == 0) == loader_first;
+
+            // reset between passes so the recorded command stream doesn't keep growing across samples
+            dispatch.vkResetCommandPool(device->get_device(), command_pool, 0);
+            dispatch.vkBeginCommandBuffer(command_buffer, &begin_info);
+
+            if (loader) {
+                set_viewport.loader_ns.push_back(time_calls(options.calls, [&]() { vkCmdSetViewport(command_buffer, 0, 1, &viewport); }));
+                set_scissor.loader_ns.push_back(time_calls(options.calls, [&]() { vkCmdSetScissor(command_buffer, 0, 1, &scissor); }));
+                semaphore_counter.loader_ns.push_back(time_calls(options.calls, [&]() {
+                    vkGetSemaphoreCounterValue(device->get_device(), semaphore, &counter_value);
+                }));
+            }
+            else {
+                set_viewport.dispatch_ns.push_back(time_calls(options.calls, [&]() { dispatch.vkCmdSetViewport(command_buffer, 0, 1, &viewport); }));
+                set_scissor.dispatch_ns.push_back(time_calls(options.calls, [&]() { dispatch.vkCmdSetScissor(command_buffer, 0, 1, &scissor); }));
+                semaphore_counter.dispatch_ns.push_back(time_calls(options.calls, [&]() {
+                    dispatch.vkGetSemaphoreCounterValue(device->get_device(), semaphore, &counter_value);
+                }));
+            }
+
+            dispatch.vkEndCommandBuffer(command_buffer);
+        }
+    }
+
+    std::string device_name = device->get_physical_device_properties().deviceName;
+
+    vkDestroyCommandPool(device->get_device(), command_pool, device->get_allocation_callbacks());
+
+    {
+        QuietCout quiet{};
+        delete device;
+    }
+
+    std::ofstream file{};
+    if (!options.output_path.empty()) {
+        file.open(options.output_path, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "failed to open benchmark output " << options.output_path << "\n";
+            return -1;
+        }
+    }
+    std::ostream& out = options.output_path.empty() ? std::cout : file;
+
+    const FunctionSamples* functions[] = { &set_viewport, &set_scissor, &semaphore_counter };
+    const size_t function_count = sizeof(functions) / sizeof(functions[0]);
+
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"benchmark\":\"dispatch\",\n  \"device\":";
+    vlk::write_json_string(out, device_name.c_str());
+    out << ",\n  \"iterations\":" << options.iterations
+        << ",\n  \"calls_per_sample\":" << options.calls << ",\n  \"functions\":[\n";
+
+    for (size_t i = 0; i < function_count; i++) {
+        out << "    {\"name\":\"" << functions[i]->name << "\",\"loader\":{";
+        write_stats(out, functions[i]->loader_ns, "ns");
+        out << "},\"dispatch\":{";
+        write_stats(out, functions[i]->dispatch_ns, "ns");
+        out << "}}" << (i + 1 < function_count ? "," : "") << "\n";
+    }
+
+    out << "  ]\n}\n";
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include "vulkan_device.hpp"
+#include "vulkan_pipeline.hpp"
+#include "vulkan_pipeline_cache.hpp"
+#include "uniform_ring.hpp"
+#include "profiler.hpp"
+#include "benchmark_common.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+// constructs and destroys a headless VulkanDevice and VulkanPipeline over and over, timing each init phase through the
+// profiler scopes already in those classes. run it against a software icd, e.g. VK_ICD_FILENAMES=.../lvp_icd.x86_64.json,
+// so numbers are comparable between machines
+
+struct BenchmarkOptions {
+    uint32_t iterations{ 20 };
+    std::string output_path{}; // json goes to stdout when empty
+    bool cold_pipeline_cache{ false };
+    bool verbose{ false };
+};
+
+// a phase can map to more than one scope, the swapchain is replaced by device owned images when there is no surface
+struct Phase {
+    const char* name{ nullptr };
+    std::vector<const char*> scopes{};
+    std::vector<double> samples_ms{};
+};
+
+static BenchmarkOptions parse_options(int argc, char** argv) {
+    BenchmarkOptions options{};
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            options.iterations = std::max(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)), 1u);
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            options.output_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--cold-pipeline-cache") == 0) {
+            options.cold_pipeline_cache = true;
+        }
+        else if (std::strcmp(argv[i], "--verbose") == 0) {
+            options.verbose = true;
+        }
+        else {
+            std::cerr << "unknown argument: " << argv[i] << ", usage: [--iterations <count>] [--output <path>] [--cold-pipeline-cache] [--verbose]\n";
+            std::exit(-1);
+        }
+    }
+
+    return options;
+}
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options = parse_options(argc, argv);
+
+    std::vector<Phase> phases = {
+        { "instance", { "VulkanDevice::_init_instance" } },
+        { "debug_messenger", { "VulkanDevice::_init_debug_manager" } },
+        { "surface", { "VulkanDevice::_init_surface" } },
+        { "physical_device", { "VulkanDevice::_init_physical_device" } },
+        { "logical_device", { "VulkanDevice::_init_logical_device", "VulkanDevice::_init_timelines" } },
+        { "allocator", { "VulkanDevice::_init_allocator" } },
+        { "swapchain", { "VulkanDevice::_init_swapchain" } },
+        { "image_views", { "VulkanDevice::_init_swapchain_images", "VulkanDevice::_init_offscreen_images" } },
+        { "depth_image", { "VulkanDevice::_init_depth_image" } },
+        { "render_pass", { "VulkanDevice::_init_render_pass" } },
+        { "framebuffers", { "VulkanDevice::_init_framebuffers" } },
+        { "pipeline_cache", { "VulkanDevice::_init_pipeline_cache" } },
+        { "bindless_descriptors", { "VulkanDevice::_init_bindless_descriptors" } },
+        { "pipeline_layout", { "VulkanPipeline::_init_pipeline_layout" } },
+        { "pipeline", { "VulkanPipeline::_init_pipeline" } },
+    };
+    std::vector<double> total_ms{};
+    std::string device_name{};
+
+    vlk::Profiler& profiler = vlk::Profiler::get();
+
+    for (uint32_t iteration = 0; iteration < options.iterations; iteration++) {
+        if (options.cold_pipeline_cache) {
+            std::error_code error{};
+            std::filesystem::remove(vlk::VulkanPipelineCache::DEFAULT_PATH, error);
+        }
+
+        {
+            QuietCout quiet(!options.verbose);
+
+            profiler.begin_session("");
+            auto start = std::chrono::steady_clock::now();
+
+            vlk::VulkanDevice* device = new vlk::VulkanDevice(vlk::HeadlessInfo{});
+            vlk::UniformRing* uniforms = new vlk::UniformRing(device, 1);
+            vlk::VulkanPipeline* pipeline = new vlk::VulkanPipeline(device, uniforms->get_set_layout());
+
+            total_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            profiler.end_session();
+
+            if (device_name.empty()) {
+                device_name = device->get_physical_device_properties().deviceName;
+            }
+
+            delete pipeline;
+            delete uniforms;
+            delete device;
+        }
+
+        // a phase's scopes run one after another, e.g. the logical device and then its timelines, so they add up to one
+        // sample. phases none of whose scopes ran get no sample at all
+        std::vector<vlk::TraceEvent> events = profiler.take_events();
+        for (Phase& phase : phases) {
+            double phase_ms = 0.0;
+            bool ran = false;
+            for (const vlk::TraceEvent& event : events) {
+                auto matches = [&](const char* scope) { return std::strcmp(scope, event.name) == 0; };
+                if (std::any_of(phase.scopes.begin(), phase.scopes.end(), matches)) {
+                    phase_ms += event.duration_us / 1000.0;
+                    ran = true;
+                }
+            }
+
+            if (ran) {
+                phase.samples_ms.push_back(phase_ms);
+            }
+        }
+    }
+
+    std::ofstream file{};
+    if (!options.output_path.empty()) {
+        file.open(options.output_path, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "failed to open benchmark output " << options.output_path << "\n";
+            return -1;
+        }
+    }
+    std::ostream& out = options.output_path.empty() ? std::cout : file;
+
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"benchmark\":\"startup\",\n  \"device\":";
+    vlk::write_json_string(out, device_name.c_str());
+    out << ",\n  \"iterations\":" << options.iterations
+        << ",\n  \"cold_pipeline_cache\":" << (options.cold_pipeline_cache ? "true" : "false") << ",\n  \"phases\":[\n";
+
+    // phases that never ran, like the swapchain on a device without a surface, report zero samples
+    for (size_t i = 0; i < phases.size(); i++) {
+        out << "    {\"name\":\"" << phases[i].name << "\",";
+        write_stats(out, phases[i].samples_ms, "ms", true);
+        out << "}" << (i + 1 < phases.size() ? "," : "") << "\n";
+    }
+
+    out << "  ],\n  \"total\":{";
+    write_stats(out, total_ms, "ms", true);
+    out << "}\n}\n";
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+# turns a spir-v binary into a header holding its words as a constexpr uint32_t array
+#
+# usage: cmake -DINPUT=<file.spv> -DOUTPUT=<file.hpp> -DVARIABLE=<name> -P embed_spirv.cmake
+
+file (READ ${INPUT} spirv_hex HEX)
+string (LENGTH "${spirv_hex}" spirv_hex_length)
+math (EXPR spirv_remainder "${spirv_hex_length} % 8")
+
+if (spirv_hex_length EQUAL 0 OR NOT spirv_remainder EQUAL 0)
+    message (FATAL_ERROR "${INPUT} is not a whole number of 32 bit words")
+endif ()
+
+# spir-v is written in the host's byte order, which is little endian on every platform we build for
+string (REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u, " spirv_words "${spirv_hex}")
+
+# cmake regexes have no {n} quantifier, so spell out 8 words per line
+set (spirv_line_pattern "")
+foreach (i RANGE 1 7)
+    set (spirv_line_pattern "${spirv_line_pattern}0x[0-9a-f]+u, ")
+endforeach ()
+string (REGEX REPLACE "(${spirv_line_pattern}0x[0-9a-f]+u,) " "\\1\n        " spirv_words "${spirv_words}")
+string (STRIP "${spirv_words}" spirv_words)
+
+string (TOUPPER "__SHADERS_${VARIABLE}_HPP__" header_guard)
+
+file (
+    WRITE ${OUTPUT}
+
+    "// generated from ${INPUT}, do not edit\n"
+    "#ifndef ${header_guard}\n"
+    "#define ${header_guard}\n\n"
+    "#include <cstdint>\n\n"
+    "namespace vlk::shaders {\n\n"
+    "    inline constexpr uint32_t ${VARIABLE}[] = {\n"
+    "        ${spirv_words}\n"
+    "    };\n\n"
+    "}\n\n"
+    "#endif // ${header_guard}\n"
+)
@@ -1,8 +1,25 @@
-#version 450
-
-layout (location = 0) in vec3 frag_color;
-layout (location = 0) out vec4 frag_out_color;
-
-void main() {
-    frag_out_color = vec4(frag_color.xyz, 1.0);
-}
\ No newline at end of file
+#version 450
+
+// 0 is the vertex color, 1 is linear view depth. a specialization constant, so each mode is its own pipeline built from
+// the same spir-v with the other branch compiled out
+layout (constant_id = 0) const uint SHADING_MODE = 0;
+
+layout (set = 1, binding = 0) uniform FrameUniforms {
+    mat4 view_projection;
+    float near_plane;
+    float far_plane;
+} frame;
+
+layout (location = 0) in vec3 frag_color;
+layout (location = 0) out vec4 frag_out_color;
+
+void main() {
+    if (SHADING_MODE == 1) {
+        // undoes the [0, 1] perspective depth mapping from Camera::get_projection
+        float depth = frame.near_plane * frame.far_plane / (frame.far_plane - gl_FragCoord.z * (frame.far_plane - frame.near_plane));
+        frag_out_color = vec4(vec3(1.0 - depth / frame.far_plane), 1.0);
+    }
+    else {
+        frag_out_color = vec4(frag_color.xyz, 1.0);
+    }
+}
@@ -1,20 +1,32 @@
-#version 450
-
-layout (location = 0) out vec3 frag_color;
-
-vec2 positions[3] = vec2[] (
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
-
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
-
-void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    frag_color = colors[gl_VertexIndex];
-}
\ No newline at end of file
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+struct DrawInstance {
+    vec4 position_scale;
+};
+
+// the storage buffer array of the global bindless set, the culling pass writes the instances that survived into the
+// one picked by push_constants.draw_instance_buffer
+layout (set = 0, binding = 2) readonly buffer DrawInstances {
+    DrawInstance instances[];
+} storage_buffers[];
+
+// allocated from the renderer's uniform ring every frame, bound with a dynamic offset
+layout (set = 1, binding = 0) uniform FrameUniforms {
+    mat4 view_projection;
+} frame;
+
+layout (push_constant) uniform PushConstants {
+    uint draw_instance_buffer;
+} push_constants;
+
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec3 in_color;
+
+layout (location = 0) out vec3 frag_color;
+
+void main() {
+    vec4 position_scale = storage_buffers[push_constants.draw_instance_buffer].instances[gl_InstanceIndex].position_scale;
+    gl_Position = frame.view_projection * vec4(in_position * position_scale.w + position_scale.xyz, 1.0);
+    frag_color = in_color;
+}
@@ -1,22 +1,421 @@
-#include "application.hpp"
-
-#include <iostream>
-
-namespace vlk {
-
-    Application::Application() 
-        : m_window(Window(WINDOW_WIDTH, WINDOW_HEIGHT, "Learning Vulkan")), 
-          m_device(new VulkanDevice(&m_window)), m_pipeline(new VulkanPipeline(m_device)) {}
-
-    Application::~Application() {
-        delete m_pipeline;
-        delete m_device;
-    }
-
-    void Application::run() {
-        while (!m_window.should_close()) {
-            glfwPollEvents();
-        }
-    }
-
-}
\ No newline at end of file
+#include "application.hpp"
+#include "bindless_descriptors.hpp"
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+namespace vlk {
+
+    // a box centered on its origin, every face wound clockwise seen from the outside to match the pipeline's front face
+    static void make_box(const float half_extents[3], const float color[3], Vertex vertices[8], uint32_t indices[36]) {
+        // corner i has bit 0 set for +x, bit 1 for +y and bit 2 for +z
+        for (uint32_t i = 0; i < 8; i++) {
+            vertices[i].position[0] = (i & 1) ? half_extents[0] : -half_extents[0];
+            vertices[i].position[1] = (i & 2) ? half_extents[1] : -half_extents[1];
+            vertices[i].position[2] = (i & 4) ? half_extents[2] : -half_extents[2];
+
+            // darker towards the bottom so the faces can be told apart without lighting
+            float shade = (i & 2) ? 1.0f : 0.6f;
+            vertices[i].color[0] = color[0] * shade;
+            vertices[i].color[1] = color[1] * shade;
+            vertices[i].color[2] = color[2] * shade;
+        }
+
+        const uint32_t faces[6][4] = {
+            { 4, 6, 7, 5 }, // +z
+            { 1, 3, 2, 0 }, // -z
+            { 5, 7, 3, 1 }, // +x
+            { 0, 2, 6, 4 }, // -x
+            { 6, 2, 3, 7 }, // +y
+            { 0, 4, 5, 1 }, // -y
+        };
+
+        for (uint32_t face = 0; face < 6; face++) {
+            const uint32_t* quad = faces[face];
+            uint32_t* face_indices = indices + face * 6;
+
+            face_indices[0] = quad[0];
+            face_indices[1] = quad[1];
+            face_indices[2] = quad[2];
+            face_indices[3] = quad[2];
+            face_indices[4] = quad[3];
+            face_indices[5] = quad[0];
+        }
+    }
+
+    static bool parse_present_policy(const char* name, PresentPolicy& policy) {
+        if (std::strcmp(name, "low-latency") == 0) {
+            policy = PresentPolicy::LowLatency;
+        }
+        else if (std::strcmp(name, "balanced") == 0) {
+            policy = PresentPolicy::Balanced;
+        }
+        else if (std::strcmp(name, "throughput") == 0) {
+            policy = PresentPolicy::Throughput;
+        }
+        else {
+            return false;
+        }
+
+        return true;
+    }
+
+    static bool parse_shading_mode(const char* name, ShadingMode& shading) {
+        if (std::strcmp(name, "color") == 0) {
+            shading = ShadingMode::VertexColor;
+        }
+        else if (std::strcmp(name, "depth") == 0) {
+            shading = ShadingMode::Depth;
+        }
+        else {
+            return false;
+        }
+
+        return true;
+    }
+
+    ApplicationOptions ApplicationOptions::parse(int argc, char** argv) {
+        ApplicationOptions options{};
+
+        for (int i = 1; i < argc; i++) {
+            if (std::strcmp(argv[i], "--headless") == 0) {
+                options.headless = true;
+            }
+            else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+                options.frame_count = std::strtoull(argv[++i], nullptr, 10);
+            }
+            else if (std::strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) {
+                options.frames_in_flight = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else if (std::strcmp(argv[i], "--record-threads") == 0 && i + 1 < argc) {
+                options.record_threads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+                options.trace_path = argv[++i];
+            }
+            else if (std::strcmp(argv[i], "--present-policy") == 0 && i + 1 < argc && parse_present_policy(argv[i + 1], options.present_policy)) {
+                i++;
+            }
+            else if (std::strcmp(argv[i], "--fps-limit") == 0 && i + 1 < argc) {
+                options.fps_limit = std::strtod(argv[++i], nullptr);
+            }
+            else if (std::strcmp(argv[i], "--grid-size") == 0 && i + 1 < argc) {
+                options.grid_size = std::max(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)), 1u);
+            }
+            else if (std::strcmp(argv[i], "--shading") == 0 && i + 1 < argc && parse_shading_mode(argv[i + 1], options.shading)) {
+                i++;
+            }
+            else {
+                std::cout << "unknown argument: " << argv[i] << ", usage: [--headless] [--frames <count>] [--frames-in-flight <1-" 
+                    << Renderer::MAX_FRAMES_IN_FLIGHT << ">] [--record-threads <count>] [--trace <path>] "
+                    << "[--present-policy <low-latency|balanced|throughput>] [--fps-limit <fps>] [--grid-size <cubes per side>] [--shading <color|depth>]\n";
+                std::exit(-1);
+            }
+        }
+
+        // low latency keeps a single frame in flight so input is sampled right before recording, throughput queues deep
+        if (options.frames_in_flight == 0) {
+            switch (options.present_policy) {
+                case PresentPolicy::LowLatency:
+                    options.frames_in_flight = 1;
+                    break;
+                case PresentPolicy::Throughput:
+                    options.frames_in_flight = Renderer::MAX_FRAMES_IN_FLIGHT;
+                    break;
+                default:
+                    options.frames_in_flight = Renderer::DEFAULT_FRAMES_IN_FLIGHT;
+                    break;
+            }
+        }
+
+        if (options.headless && options.frame_count == 0) {
+            std::cout << "running headless without --frames, there is no window to close so it will run forever\n";
+        }
+
+        return options;
+    }
+
+    Application::Application(const ApplicationOptions& options) : m_options(options) {
+        // started before anything else so device creation shows up in the trace
+        if (!m_options.trace_path.empty()) {
+            Profiler::get().set_thread_name("main");
+            Profiler::get().begin_session(m_options.trace_path);
+        }
+
+        if (m_options.headless) {
+            HeadlessInfo headless_info{};
+            headless_info.extent = { static_cast<uint32_t>(WINDOW_WIDTH), static_cast<uint32_t>(WINDOW_HEIGHT) };
+            m_device = new VulkanDevice(headless_info, m_options.present_policy);
+        }
+        else {
+            m_window = new Window(WINDOW_WIDTH, WINDOW_HEIGHT, "Learning Vulkan");
+            m_device = new VulkanDevice(m_window, m_options.present_policy);
+        }
+
+        m_renderer = new Renderer(m_device, m_options.frames_in_flight);
+
+        // anything but the default shading compiles off the main thread, the scene is drawn with vertex colors until it's
+        // ready instead of the first frame waiting on the driver
+        VkDescriptorSetLayout uniform_set_layout = m_renderer->get_uniform_ring()->get_set_layout();
+        if (m_options.shading != ShadingMode::VertexColor) {
+            m_compile_pool = new ThreadPool(std::max(ThreadPool::default_thread_count() / 2, 1u));
+            m_fallback_pipeline = new VulkanPipeline(m_device, uniform_set_layout);
+        }
+        m_pipeline = new VulkanPipeline(m_device, uniform_set_layout, m_options.shading, m_compile_pool, m_fallback_pipeline);
+        m_uploader = new VulkanUploader(m_device);
+        m_frame_pacer = new FramePacer(m_options.fps_limit);
+
+        _init_scene();
+
+        if (m_options.record_threads > 0) {
+            m_thread_pool = new ThreadPool(m_options.record_threads);
+            m_recorder = new ParallelRecorder(m_device, m_thread_pool, m_renderer->get_frames_in_flight());
+        }
+
+        _init_render_graph();
+
+        if (Profiler::get().is_active()) {
+            m_gpu_profiler = new GpuProfiler(m_device, m_renderer->get_frames_in_flight());
+        }
+    }
+
+    Application::~Application() {
+        delete m_render_graph;
+        delete m_culler;
+        delete m_hi_z;
+        delete m_mesh_buffer;
+        delete m_frame_pacer;
+        delete m_gpu_profiler;
+        delete m_recorder;
+        delete m_thread_pool;
+        delete m_uploader;
+        delete m_compile_pool;
+        delete m_pipeline;
+        delete m_fallback_pipeline;
+        delete m_renderer;
+        delete m_device;
+        delete m_window;
+
+        // after the device is gone so its teardown is traced too
+        Profiler::get().end_session();
+    }
+
+    void Application::run() {
+        uint64_t frame = 0;
+        while (!_should_close(frame)) {
+            VLK_PROFILE_SCOPE("Application::frame");
+
+            {
+                // pacing and the wait on the gpu both happen before input is sampled, so whatever is polled next is as
+                // fresh as it can be when recording starts
+                VLK_PROFILE_SCOPE("Application::pace");
+                m_frame_pacer->wait();
+                m_renderer->wait_for_frame();
+            }
+
+            if (m_window != nullptr) {
+                VLK_PROFILE_SCOPE("Application::poll_events");
+                glfwPollEvents();
+            }
+            m_frame_pacer->mark_input();
+
+            {
+                // uploads queued since last frame go out as one batch, ahead of the frame that might use them
+                VLK_PROFILE_SCOPE("Application::flush_uploads");
+                m_uploader->flush();
+            }
+
+            VkCommandBuffer command_buffer = nullptr;
+            {
+                VLK_PROFILE_SCOPE("Application::begin_frame");
+                command_buffer = m_renderer->begin_frame();
+            }
+
+            // nothing to render into while minimized, sleep until the window comes back instead of spinning
+            if (command_buffer == nullptr && m_window != nullptr && m_window->is_minimized()) {
+                glfwWaitEvents();
+            }
+
+            if (command_buffer != nullptr) {
+                {
+                    VLK_PROFILE_SCOPE("Application::record");
+
+                    if (m_gpu_profiler != nullptr) {
+                        m_gpu_profiler->begin_frame(command_buffer, m_renderer->get_frame_index());
+                    }
+                    VLK_PROFILE_GPU_SCOPE(m_gpu_profiler, command_buffer, "frame");
+
+                    m_renderer->add_wait(m_uploader->record_acquire_barriers(command_buffer));
+
+                    _update_camera(frame);
+                    m_pipeline->resolve();
+                    m_frame_uniform_offset = m_renderer->get_uniform_ring()->push(m_frame_uniforms);
+
+                    // both follow the swapchain extent, new images start over from the undefined layout
+                    m_hi_z->prepare(m_renderer->get_frame_number());
+                    m_render_graph->set_image(m_depth_resource, m_device->get_depth_image());
+                    m_render_graph->set_image(m_hi_z_resource, m_hi_z->get_image());
+
+                    m_render_graph->execute(command_buffer, m_gpu_profiler);
+                }
+
+                VLK_PROFILE_SCOPE("Application::end_frame");
+                m_renderer->end_frame();
+                m_frame_pacer->mark_present();
+            }
+
+            frame++;
+        }
+
+        m_renderer->wait_idle();
+        m_frame_pacer->print_stats();
+        m_render_graph->print_stats();
+
+        if (m_gpu_profiler != nullptr) {
+            m_gpu_profiler->collect_all();
+        }
+    }
+
+    void Application::_record_draws(VkCommandBuffer command_buffer, uint32_t begin, uint32_t end) {
+        // state isn't shared between secondary command buffers, so every slice binds for itself
+        if (!m_pipeline->bind(command_buffer)) {
+            return;
+        }
+        m_renderer->get_uniform_ring()->bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline->get_layout(), 1, m_frame_uniform_offset);
+        m_pipeline->push_constants(command_buffer, m_draw_constants);
+        m_mesh_buffer->bind(command_buffer);
+        m_culler->draw(command_buffer, begin, end);
+    }
+
+    void Application::_update_camera(uint64_t frame) {
+        // circles the field low down, so the walls hide most of what is behind them
+        float field_size = static_cast<float>(m_options.grid_size) * SCENE_CUBE_SPACING;
+        float angle = static_cast<float>(frame) * 0.002f;
+
+        m_camera.position[0] = std::cos(angle) * field_size * 0.6f;
+        m_camera.position[1] = 4.0f;
+        m_camera.position[2] = std::sin(angle) * field_size * 0.6f;
+        m_camera.far_plane = field_size * 2.0f;
+        m_frame_uniforms.near_plane = m_camera.near_plane;
+        m_frame_uniforms.far_plane = m_camera.far_plane;
+
+        const VkExtent2D& extent = m_device->get_swapchain_extent();
+        m_camera.get_view_projection(static_cast<float>(extent.width) / static_cast<float>(extent.height), m_frame_uniforms.view_projection);
+    }
+
+    void Application::_init_scene() {
+        m_mesh_buffer = new MeshBuffer(m_device, m_uploader);
+        m_hi_z = new HiZPyramid(m_device);
+        m_culler = new GpuCuller(m_device, m_uploader, m_hi_z, m_renderer->get_uniform_ring());
+
+        Vertex vertices[8];
+        uint32_t indices[36];
+
+        const float cube_half_extents[] = { 0.5f, 0.5f, 0.5f };
+        const float cube_color[] = { 0.2f, 0.6f, 0.9f };
+        make_box(cube_half_extents, cube_color, vertices, indices);
+        uint32_t cube_draw = m_culler->add_draw(m_mesh_buffer->add_mesh(vertices, 8, indices, 36));
+
+        const float wall_half_extents[] = { 8.0f, 3.0f, 0.25f };
+        const float wall_color[] = { 0.8f, 0.4f, 0.2f };
+        make_box(wall_half_extents, wall_color, vertices, indices);
+        uint32_t wall_draw = m_culler->add_draw(m_mesh_buffer->add_mesh(vertices, 8, indices, 36));
+
+        const uint32_t grid_size = m_options.grid_size;
+        const float grid_offset = static_cast<float>(grid_size - 1) * 0.5f;
+        for (uint32_t z = 0; z < grid_size; z++) {
+            for (uint32_t x = 0; x < grid_size; x++) {
+                float position[] = { (x - grid_offset) * SCENE_CUBE_SPACING, 0.5f, (z - grid_offset) * SCENE_CUBE_SPACING };
+                m_culler->add_instance(cube_draw, position, 1.0f);
+
+                // rows of walls standing between the cubes to give the occlusion test something to do
+                if (x % 24 == 12 && z % 16 == 8) {
+                    float wall_position[] = { position[0], wall_half_extents[1], position[2] };
+                    m_culler->add_instance(wall_draw, wall_position, 1.0f);
+                }
+            }
+        }
+
+        m_culler->upload();
+        m_draw_constants.draw_instance_buffer = m_device->get_bindless_descriptors()->add_storage_buffer(m_culler->get_draw_instance_buffer());
+
+        // a loading screen would keep rendering here, there is nothing to show until the meshes are in
+        m_uploader->flush();
+        m_uploader->wait(m_mesh_buffer->get_last_upload());
+        m_uploader->wait(m_culler->get_last_upload());
+
+        std::cout << "successfully uploaded " << m_culler->get_draw_count() << " meshes (" << m_mesh_buffer->get_vertex_count()
+            << " vertices, " << m_mesh_buffer->get_index_count() << " indices) and " << m_culler->get_instance_count() << " instances\n";
+    }
+
+    void Application::_init_render_graph() {
+        m_render_graph = new RenderGraph(m_device, m_renderer);
+
+        // the uploader hands every buffer over to the graphics queue with the first frame's acquire barriers
+        RenderGraphResource instances = m_render_graph->import_buffer("instances", m_culler->get_instance_buffer());
+        RenderGraphResource draw_template = m_render_graph->import_buffer("draw_template", m_culler->get_template_buffer());
+        RenderGraphResource indirect = m_render_graph->import_buffer("indirect", m_culler->get_indirect_buffer());
+        RenderGraphResource draw_instances = m_render_graph->import_buffer("draw_instances", m_culler->get_draw_instance_buffer());
+
+        VkImageAspectFlags depth_aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        if (m_device->get_depth_format() != VK_FORMAT_D32_SFLOAT) {
+            depth_aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+        }
+        m_depth_resource = m_render_graph->import_image("depth", m_device->get_depth_image(), depth_aspect);
+        m_hi_z_resource = m_render_graph->import_image("hi_z", m_hi_z->get_image(), VK_IMAGE_ASPECT_COLOR_BIT);
+
+        // tests against last frame's pyramid, so it never waits on this frame's graphics work and can run on the async
+        // compute queue. it still waits on last frame's, which builds the pyramid and draws from the culling results
+        m_render_graph->add_pass("cull", QueueType::Compute, [this](VkCommandBuffer command_buffer) {
+            m_culler->record(command_buffer, m_frame_uniforms.view_projection);
+        })
+            .read(m_hi_z_resource, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL)
+            .read(instances, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT)
+            .read(draw_template, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT)
+            .write(indirect, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT)
+            .write(draw_instances, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+        // the pass's profiler zone sits outside the render pass, secondary only passes can't contain timestamp writes
+        m_render_graph->add_pass("scene", QueueType::Graphics, [this](VkCommandBuffer command_buffer) {
+            const uint32_t draw_count = m_culler->get_draw_count();
+            if (m_recorder != nullptr) {
+                m_renderer->begin_render_pass(command_buffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                m_recorder->record(m_renderer, command_buffer, draw_count, [this](VkCommandBuffer secondary, uint32_t begin, uint32_t end) {
+                    _record_draws(secondary, begin, end);
+                });
+            }
+            else {
+                m_renderer->begin_render_pass(command_buffer);
+                _record_draws(command_buffer, 0, draw_count);
+            }
+            m_renderer->end_render_pass(command_buffer);
+        })
+            .read(indirect, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT)
+            .read(draw_instances, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT)
+            .write(m_depth_resource, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+            .set_side_effect();
+
+        // next frame's occlusion test reads this frame's depth
+        m_render_graph->add_pass("hi_z", QueueType::Compute, [this](VkCommandBuffer command_buffer) {
+            m_hi_z->build(command_buffer);
+        })
+            .read(m_depth_resource, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
+            .write(m_hi_z_resource, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL);
+
+        m_render_graph->compile();
+    }
+
+    bool Application::_should_close(uint64_t frame) const {
+        if (m_options.frame_count != 0 && frame >= m_options.frame_count) {
+            return true;
+        }
+
+        return m_window != nullptr && m_window->should_close();
+    }
+
+}
@@ -1,28 +1,86 @@
-#ifndef __APPLICATION_HPP__
-#define __APPLICATION_HPP__
-
-#include "window.hpp"
-#include "vulkan_pipeline.hpp"
-#include "vulkan_device.hpp"
-
-namespace vlk {
-
-    class Application {
-    public:
-        static constexpr int WINDOW_WIDTH = 800;
-        static constexpr int WINDOW_HEIGHT = 600;
-
-        Application();
-        ~Application();
-
-        void run();
-
-    private:
-        Window m_window;
-        VulkanDevice* m_device{ nullptr };
-        VulkanPipeline* m_pipeline{ nullptr };
-    };
-
-}
-
-#endif // __APPLICATION_HPP__
\ No newline at end of file
+#ifndef __APPLICATION_HPP__
+#define __APPLICATION_HPP__
+
+#include "window.hpp"
+#include "vulkan_pipeline.hpp"
+#include "vulkan_device.hpp"
+#include "renderer.hpp"
+#include "vulkan_uploader.hpp"
+#include "thread_pool.hpp"
+#include "parallel_recorder.hpp"
+#include "profiler.hpp"
+#include "frame_pacer.hpp"
+#include "mesh_buffer.hpp"
+#include "hi_z_pyramid.hpp"
+#include "gpu_culler.hpp"
+#include "render_graph.hpp"
+#include "camera.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace vlk {
+
+    struct ApplicationOptions {
+        bool headless{ false };
+        uint64_t frame_count{ 0 }; // number of frames to run before exiting, 0 runs until the window is closed
+        uint32_t frames_in_flight{ 0 }; // 0 picks a depth to suit the present policy
+        PresentPolicy present_policy{ PresentPolicy::Balanced };
+        double fps_limit{ 0.0 }; // 0 leaves the frame rate uncapped
+        uint32_t record_threads{ ThreadPool::default_thread_count() }; // 0 records everything inline on the main thread
+        std::string trace_path{}; // chrome trace json output, empty disables profiling
+        uint32_t grid_size{ 128 }; // the test scene is a grid_size by grid_size field of cubes
+        ShadingMode shading{ ShadingMode::VertexColor };
+
+        static ApplicationOptions parse(int argc, char** argv);
+    };
+
+    class Application {
+    public:
+        static constexpr int WINDOW_WIDTH = 800;
+        static constexpr int WINDOW_HEIGHT = 600;
+        static constexpr float SCENE_CUBE_SPACING = 2.0f;
+
+        Application(const ApplicationOptions& options = {});
+        ~Application();
+
+        void run();
+
+    private:
+        void _init_scene();
+        void _init_render_graph();
+        bool _should_close(uint64_t frame) const;
+        void _record_draws(VkCommandBuffer command_buffer, uint32_t begin, uint32_t end);
+        void _update_camera(uint64_t frame);
+
+        ApplicationOptions m_options{};
+        Window* m_window{ nullptr };
+        VulkanDevice* m_device{ nullptr };
+        VulkanPipeline* m_pipeline{ nullptr };
+        VulkanPipeline* m_fallback_pipeline{ nullptr }; // only while m_pipeline may still be compiling in the background
+        ThreadPool* m_compile_pool{ nullptr };
+        Renderer* m_renderer{ nullptr };
+        VulkanUploader* m_uploader{ nullptr };
+        ThreadPool* m_thread_pool{ nullptr };
+        ParallelRecorder* m_recorder{ nullptr };
+        GpuProfiler* m_gpu_profiler{ nullptr };
+        FramePacer* m_frame_pacer{ nullptr };
+        MeshBuffer* m_mesh_buffer{ nullptr };
+        HiZPyramid* m_hi_z{ nullptr };
+        GpuCuller* m_culler{ nullptr };
+        RenderGraph* m_render_graph{ nullptr };
+
+        // images the graph tracks that get recreated, handed to it again every frame
+        RenderGraphResource m_depth_resource{};
+        RenderGraphResource m_hi_z_resource{};
+
+        Camera m_camera{};
+        // written before recording starts, only read by the recording threads
+        FrameUniforms m_frame_uniforms{};
+        uint32_t m_frame_uniform_offset{ 0 };
+        DrawPushConstants m_draw_constants{};
+    };
+
+}
+
+#endif // __APPLICATION_HPP__
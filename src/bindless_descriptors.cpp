@@ -0,0 +1,215 @@
+#include "bindless_descriptors.hpp"
+#include "vulkan_device.hpp"
+#include "profiler.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+namespace vlk {
+
+    BindlessDescriptors::BindlessDescriptors(VulkanDevice* device) : m_device(device), m_dispatch(&device->get_dispatch()) {
+        VLK_PROFILE_SCOPE("BindlessDescriptors::BindlessDescriptors");
+
+        const VkPhysicalDeviceDescriptorIndexingFeaturesEXT& features = m_device->get_descriptor_indexing_features();
+        if (!features.runtimeDescriptorArray || !features.descriptorBindingPartiallyBound ||
+            !features.descriptorBindingSampledImageUpdateAfterBind || !features.descriptorBindingStorageBufferUpdateAfterBind ||
+            !features.descriptorBindingUpdateUnusedWhilePending) {
+            std::cout << "failed to create bindless descriptors, device is missing descriptor indexing features\n";
+            std::exit(-1);
+        }
+
+        VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexing_properties{};
+        indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+        VkPhysicalDeviceProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties.pNext = &indexing_properties;
+        vkGetPhysicalDeviceProperties2(m_device->get_physical_device(), &properties);
+
+        // every binding is visible to every stage, so the per stage limits apply to the whole array and all three
+        // arrays share the per stage resource budget
+        uint32_t resource_budget = indexing_properties.maxPerStageUpdateAfterBindResources / 3;
+        m_sampled_images.capacity = std::min({ MAX_SAMPLED_IMAGES, resource_budget,
+            indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages });
+        m_samplers.capacity = std::min({ MAX_SAMPLERS, resource_budget,
+            indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+            indexing_properties.maxDescriptorSetUpdateAfterBindSamplers });
+        m_storage_buffers.capacity = std::min({ MAX_STORAGE_BUFFERS, resource_budget,
+            indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+            indexing_properties.maxDescriptorSetUpdateAfterBindStorageBuffers });
+
+        VkDescriptorSetLayoutBinding bindings[3]{};
+        bindings[0].binding = SAMPLED_IMAGE_BINDING;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        bindings[0].descriptorCount = m_sampled_images.capacity;
+        bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+        bindings[1].binding = SAMPLER_BINDING;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        bindings[1].descriptorCount = m_samplers.capacity;
+        bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+        bindings[2].binding = STORAGE_BUFFER_BINDING;
+        bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[2].descriptorCount = m_storage_buffers.capacity;
+        bindings[2].stageFlags = VK_SHADER_STAGE_ALL;
+
+        // slots are written while earlier frames that never touch them are still in flight, and most of every array is
+        // empty at any one time
+        VkDescriptorBindingFlagsEXT binding_flag = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+            VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
+        VkDescriptorBindingFlagsEXT binding_flags[3] = { binding_flag, binding_flag, binding_flag };
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_create_info{};
+        binding_flags_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+        binding_flags_create_info.bindingCount = 3;
+        binding_flags_create_info.pBindingFlags = binding_flags;
+
+        VkDescriptorSetLayoutCreateInfo layout_create_info{};
+        layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_create_info.pNext = &binding_flags_create_info;
+        layout_create_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+        layout_create_info.bindingCount = 3;
+        layout_create_info.pBindings = bindings;
+
+        if (vkCreateDescriptorSetLayout(m_device->get_device(), &layout_create_info, m_device->get_allocation_callbacks(), &m_set_layout) != VK_SUCCESS) {
+            std::cout << "failed to create bindless descriptor set layout\n";
+            std::exit(-1);
+        }
+
+        VkDescriptorPoolSize pool_sizes[3]{};
+        pool_sizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        pool_sizes[0].descriptorCount = m_sampled_images.capacity;
+        pool_sizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+        pool_sizes[1].descriptorCount = m_samplers.capacity;
+        pool_sizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pool_sizes[2].descriptorCount = m_storage_buffers.capacity;
+
+        VkDescriptorPoolCreateInfo pool_create_info{};
+        pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+        pool_create_info.maxSets = 1;
+        pool_create_info.poolSizeCount = 3;
+        pool_create_info.pPoolSizes = pool_sizes;
+
+        if (vkCreateDescriptorPool(m_device->get_device(), &pool_create_info, m_device->get_allocation_callbacks(), &m_pool) != VK_SUCCESS) {
+            std::cout << "failed to create bindless descriptor pool\n";
+            std::exit(-1);
+        }
+
+        VkDescriptorSetAllocateInfo allocate_info{};
+        allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocate_info.descriptorPool = m_pool;
+        allocate_info.descriptorSetCount = 1;
+        allocate_info.pSetLayouts = &m_set_layout;
+
+        if (vkAllocateDescriptorSets(m_device->get_device(), &allocate_info, &m_set) != VK_SUCCESS) {
+            std::cout << "failed to allocate bindless descriptor set\n";
+            std::exit(-1);
+        }
+
+        std::cout << "successfully created bindless descriptor set (" << m_sampled_images.capacity << " images, " <<
+            m_samplers.capacity << " samplers, " << m_storage_buffers.capacity << " storage buffers)\n";
+    }
+
+    BindlessDescriptors::~BindlessDescriptors() {
+        vkDestroyDescriptorPool(m_device->get_device(), m_pool, m_device->get_allocation_callbacks());
+        vkDestroyDescriptorSetLayout(m_device->get_device(), m_set_layout, m_device->get_allocation_callbacks());
+    }
+
+    void BindlessDescriptors::bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout layout) const {
+        m_dispatch->vkCmdBindDescriptorSets(command_buffer, bind_point, layout, 0, 1, &m_set, 0, nullptr);
+    }
+
+    uint32_t BindlessDescriptors::add_sampled_image(VkImageView image_view, VkImageLayout layout) {
+        VkDescriptorImageInfo image_info{};
+        image_info.imageView = image_view;
+        image_info.imageLayout = layout;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint32_t slot = _allocate_slot(m_sampled_images, "sampled image");
+        _write(SAMPLED_IMAGE_BINDING, slot, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, &image_info, nullptr);
+        return slot;
+    }
+
+    uint32_t BindlessDescriptors::add_sampler(VkSampler sampler) {
+        VkDescriptorImageInfo image_info{};
+        image_info.sampler = sampler;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint32_t slot = _allocate_slot(m_samplers, "sampler");
+        _write(SAMPLER_BINDING, slot, VK_DESCRIPTOR_TYPE_SAMPLER, &image_info, nullptr);
+        return slot;
+    }
+
+    uint32_t BindlessDescriptors::add_storage_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+        VkDescriptorBufferInfo buffer_info{};
+        buffer_info.buffer = buffer;
+        buffer_info.offset = offset;
+        buffer_info.range = range;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint32_t slot = _allocate_slot(m_storage_buffers, "storage buffer");
+        _write(STORAGE_BUFFER_BINDING, slot, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &buffer_info);
+        return slot;
+    }
+
+    void BindlessDescriptors::free_sampled_image(uint32_t slot, uint64_t retire_frame_number) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        _free_slot(m_sampled_images, slot, retire_frame_number);
+    }
+
+    void BindlessDescriptors::free_sampler(uint32_t slot, uint64_t retire_frame_number) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        _free_slot(m_samplers, slot, retire_frame_number);
+    }
+
+    void BindlessDescriptors::free_storage_buffer(uint32_t slot, uint64_t retire_frame_number) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        _free_slot(m_storage_buffers, slot, retire_frame_number);
+    }
+
+    void BindlessDescriptors::collect(uint64_t completed_frame_count) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (SlotList* slots : { &m_sampled_images, &m_samplers, &m_storage_buffers }) {
+            while (!slots->retired.empty() && slots->retired.front().first <= completed_frame_count) {
+                slots->free.push_back(slots->retired.front().second);
+                slots->retired.pop_front();
+            }
+        }
+    }
+
+    uint32_t BindlessDescriptors::_allocate_slot(SlotList& slots, const char* name) {
+        if (!slots.free.empty()) {
+            uint32_t slot = slots.free.back();
+            slots.free.pop_back();
+            return slot;
+        }
+
+        if (slots.next >= slots.capacity) {
+            std::cout << "failed to allocate bindless " << name << " slot, all " << slots.capacity << " are in use\n";
+            std::exit(-1);
+        }
+
+        return slots.next++;
+    }
+
+    void BindlessDescriptors::_free_slot(SlotList& slots, uint32_t slot, uint64_t retire_frame_number) {
+        slots.retired.emplace_back(retire_frame_number, slot);
+    }
+
+    void BindlessDescriptors::_write(uint32_t binding, uint32_t slot, VkDescriptorType type, const VkDescriptorImageInfo* image_info,
+        const VkDescriptorBufferInfo* buffer_info) {
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_set;
+        write.dstBinding = binding;
+        write.dstArrayElement = slot;
+        write.descriptorCount = 1;
+        write.descriptorType = type;
+        write.pImageInfo = image_info;
+        write.pBufferInfo = buffer_info;
+
+        m_dispatch->vkUpdateDescriptorSets(m_device->get_device(), 1, &write, 0, nullptr);
+    }
+
+}
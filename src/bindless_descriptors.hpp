@@ -0,0 +1,90 @@
+#ifndef __BINDLESS_DESCRIPTORS_HPP__
+#define __BINDLESS_DESCRIPTORS_HPP__
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <cstdint>
+
+namespace vlk {
+
+    class VulkanDevice;
+
+    // one global descriptor set of large update after bind arrays, bound once per command buffer and indexed with push
+    // constants, so draws never switch descriptor sets. resources are registered into slots that are recycled through a
+    // free list instead of allocating sets every frame. shaders declare the arrays as
+    //
+    //     layout (set = 0, binding = 0) uniform texture2D textures[];
+    //     layout (set = 0, binding = 1) uniform sampler samplers[];
+    //     layout (set = 0, binding = 2) buffer ... storage_buffers[];
+    //
+    // needs VK_EXT_descriptor_indexing with partially bound, update after bind, update unused while pending and runtime
+    // descriptor array support
+    class BindlessDescriptors {
+    public:
+        static constexpr uint32_t SAMPLED_IMAGE_BINDING = 0;
+        static constexpr uint32_t SAMPLER_BINDING = 1;
+        static constexpr uint32_t STORAGE_BUFFER_BINDING = 2;
+
+        static constexpr uint32_t MAX_SAMPLED_IMAGES = 16384;
+        static constexpr uint32_t MAX_SAMPLERS = 256;
+        static constexpr uint32_t MAX_STORAGE_BUFFERS = 16384;
+
+        BindlessDescriptors(VulkanDevice* device);
+        ~BindlessDescriptors();
+
+        inline VkDescriptorSetLayout get_set_layout() const { return m_set_layout; }
+        inline VkDescriptorSet get_set() const { return m_set; }
+
+        // every pipeline layout made with get_set_layout as set 0 stays compatible, so this is needed once per command buffer
+        void bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout layout) const;
+
+        // return the slot to index the array with, the descriptor is written straight away and may be used by the next
+        // command buffer submitted
+        uint32_t add_sampled_image(VkImageView image_view, VkImageLayout layout);
+        uint32_t add_sampler(VkSampler sampler);
+        uint32_t add_storage_buffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+        // frames already submitted may still index the slot, so it is only handed out again once every frame before
+        // retire_frame_number (normally the frame being recorded) has finished
+        void free_sampled_image(uint32_t slot, uint64_t retire_frame_number);
+        void free_sampler(uint32_t slot, uint64_t retire_frame_number);
+        void free_storage_buffer(uint32_t slot, uint64_t retire_frame_number);
+
+        // makes retired slots available again, called once a frame with the renderer's completed frame count
+        void collect(uint64_t completed_frame_count);
+
+    private:
+        struct SlotList {
+            uint32_t capacity{ 0 };
+            uint32_t next{ 0 };                                  // every slot from here up has never been handed out
+            std::vector<uint32_t> free{};
+            std::deque<std::pair<uint64_t, uint32_t>> retired{}; // retire frame number and slot, oldest first
+        };
+
+        uint32_t _allocate_slot(SlotList& slots, const char* name);
+        void _free_slot(SlotList& slots, uint32_t slot, uint64_t retire_frame_number);
+        void _write(uint32_t binding, uint32_t slot, VkDescriptorType type, const VkDescriptorImageInfo* image_info,
+            const VkDescriptorBufferInfo* buffer_info);
+
+        BindlessDescriptors(const BindlessDescriptors& other) = delete;
+        BindlessDescriptors& operator=(const BindlessDescriptors& other) = delete;
+
+        VulkanDevice* m_device{ nullptr };
+        const VulkanDeviceDispatch* m_dispatch{ nullptr };
+        VkDescriptorSetLayout m_set_layout{ nullptr };
+        VkDescriptorPool m_pool{ nullptr };
+        VkDescriptorSet m_set{ nullptr };
+
+        std::mutex m_mutex{};
+        SlotList m_sampled_images{};
+        SlotList m_samplers{};
+        SlotList m_storage_buffers{};
+    };
+
+}
+
+#endif // __BINDLESS_DESCRIPTORS_HPP__
@@ -0,0 +1,94 @@
+#include "camera.hpp"
+
+#include <cmath>
+
+namespace vlk {
+
+    static void normalize(float v[3]) {
+        float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (length > 0.0f) {
+            v[0] /= length;
+            v[1] /= length;
+            v[2] /= length;
+        }
+    }
+
+    static void cross(const float a[3], const float b[3], float out[3]) {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    static float dot(const float a[3], const float b[3]) {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    void Camera::get_view(float out[16]) const {
+        float forward[3] = { target[0] - position[0], target[1] - position[1], target[2] - position[2] };
+        normalize(forward);
+
+        float right[3];
+        cross(forward, up, right);
+        normalize(right);
+
+        float camera_up[3];
+        cross(right, forward, camera_up);
+
+        // rows are right, up and -forward, the camera looks down -z in view space
+        out[0] = right[0];
+        out[1] = camera_up[0];
+        out[2] = -forward[0];
+        out[3] = 0.0f;
+
+        out[4] = right[1];
+        out[5] = camera_up[1];
+        out[6] = -forward[1];
+        out[7] = 0.0f;
+
+        out[8] = right[2];
+        out[9] = camera_up[2];
+        out[10] = -forward[2];
+        out[11] = 0.0f;
+
+        out[12] = -dot(right, position);
+        out[13] = -dot(camera_up, position);
+        out[14] = dot(forward, position);
+        out[15] = 1.0f;
+    }
+
+    void Camera::get_projection(float aspect, float out[16]) const {
+        float focal_length = 1.0f / std::tan(fov_y * 0.5f);
+
+        for (int i = 0; i < 16; i++) {
+            out[i] = 0.0f;
+        }
+
+        out[0] = focal_length / aspect;
+        out[5] = -focal_length; // vulkan's clip space y points down
+        out[10] = far_plane / (near_plane - far_plane);
+        out[11] = -1.0f;
+        out[14] = near_plane * far_plane / (near_plane - far_plane);
+    }
+
+    void Camera::get_view_projection(float aspect, float out[16]) const {
+        float view[16];
+        float projection[16];
+        get_view(view);
+        get_projection(aspect, projection);
+
+        multiply_matrices(projection, view, out);
+    }
+
+    void multiply_matrices(const float a[16], const float b[16], float out[16]) {
+        for (int column = 0; column < 4; column++) {
+            for (int row = 0; row < 4; row++) {
+                float sum = 0.0f;
+                for (int k = 0; k < 4; k++) {
+                    sum += a[k * 4 + row] * b[column * 4 + k];
+                }
+                out[column * 4 + row] = sum;
+            }
+        }
+    }
+
+}
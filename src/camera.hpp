@@ -0,0 +1,26 @@
+#ifndef __CAMERA_HPP__
+#define __CAMERA_HPP__
+
+namespace vlk {
+
+    // a perspective camera looking at a target. matrices are column major to match glsl, and the projection flips y and
+    // maps depth to [0, 1] for vulkan's clip space, so world space stays right handed with y up
+    struct Camera {
+        float position[3]{ 0.0f, 0.0f, 5.0f };
+        float target[3]{ 0.0f, 0.0f, 0.0f };
+        float up[3]{ 0.0f, 1.0f, 0.0f };
+        float fov_y{ 1.0471976f }; // radians
+        float near_plane{ 0.1f };
+        float far_plane{ 1000.0f };
+
+        void get_view(float out[16]) const;
+        void get_projection(float aspect, float out[16]) const;
+        void get_view_projection(float aspect, float out[16]) const;
+    };
+
+    // out = a * b, out may not alias either input
+    void multiply_matrices(const float a[16], const float b[16], float out[16]);
+
+}
+
+#endif // __CAMERA_HPP__
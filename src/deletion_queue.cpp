@@ -0,0 +1,144 @@
+#include "deletion_queue.hpp"
+#include "profiler.hpp"
+
+#include <iostream>
+
+namespace vlk {
+
+    // handles are pointers on 64 bit platforms and uint64_t everywhere else, a c style cast covers both
+    template<typename T>
+    static inline uint64_t to_handle(T object) {
+        return (uint64_t)object;
+    }
+
+    template<typename T>
+    static inline T from_handle(uint64_t handle) {
+        return (T)handle;
+    }
+
+    DeletionQueue::DeletionQueue(VkDevice device, const VkAllocationCallbacks* allocation_callbacks, VulkanAllocator* allocator)
+        : m_device(device), m_allocation_callbacks(allocation_callbacks), m_allocator(allocator) {
+    }
+
+    DeletionQueue::~DeletionQueue() {
+        flush();
+    }
+
+    size_t DeletionQueue::get_pending_count() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+
+    void DeletionQueue::destroy_buffer(VkBuffer buffer, const VulkanAllocation& allocation, uint64_t retire_frame_number) {
+        _push(VK_OBJECT_TYPE_BUFFER, to_handle(buffer), retire_frame_number, allocation);
+    }
+
+    void DeletionQueue::destroy_image(VkImage image, const VulkanAllocation& allocation, uint64_t retire_frame_number) {
+        _push(VK_OBJECT_TYPE_IMAGE, to_handle(image), retire_frame_number, allocation);
+    }
+
+    void DeletionQueue::destroy_image_view(VkImageView image_view, uint64_t retire_frame_number) {
+        _push(VK_OBJECT_TYPE_IMAGE_VIEW, to_handle(image_view), retire_frame_number);
+    }
+
+    void DeletionQueue::destroy_framebuffer(VkFramebuffer framebuffer, uint64_t retire_frame_number) {
+        _push(VK_OBJECT_TYPE_FRAMEBUFFER, to_handle(framebuffer), retire_frame_number);
+    }
+
+    void DeletionQueue::destroy_swapchain(VkSwapchainKHR swapchain, uint64_t retire_frame_number) {
+        _push(VK_OBJECT_TYPE_SWAPCHAIN_KHR, to_handle(swapchain), retire_frame_number);
+    }
+
+    void DeletionQueue::destroy_descriptor_pool(VkDescriptorPool descriptor_pool, uint64_t retire_frame_number) {
+        _push(VK_OBJECT_TYPE_DESCRIPTOR_POOL, to_handle(descriptor_pool), retire_frame_number);
+    }
+
+    void DeletionQueue::destroy_sampler(VkSampler sampler, uint64_t retire_frame_number) {
+        _push(VK_OBJECT_TYPE_SAMPLER, to_handle(sampler), retire_frame_number);
+    }
+
+    void DeletionQueue::destroy_pipeline(VkPipeline pipeline, uint64_t retire_frame_number) {
+        _push(VK_OBJECT_TYPE_PIPELINE, to_handle(pipeline), retire_frame_number);
+    }
+
+    void DeletionQueue::destroy_semaphore(VkSemaphore semaphore, uint64_t retire_frame_number) {
+        _push(VK_OBJECT_TYPE_SEMAPHORE, to_handle(semaphore), retire_frame_number);
+    }
+
+    void DeletionQueue::collect(uint64_t completed_frame_count) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_entries.empty() || m_entries.front().retire_frame_number > completed_frame_count) {
+            return;
+        }
+
+        VLK_PROFILE_SCOPE("DeletionQueue::collect");
+
+        // entries are queued with the frame being recorded, which only goes up, so everything that has retired is at the
+        // front. one queued out of order just waits for the ones ahead of it
+        while (!m_entries.empty() && m_entries.front().retire_frame_number <= completed_frame_count) {
+            _destroy(m_entries.front());
+            m_entries.pop_front();
+        }
+    }
+
+    void DeletionQueue::flush() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (Entry& entry : m_entries) {
+            _destroy(entry);
+        }
+        m_entries.clear();
+    }
+
+    void DeletionQueue::_push(VkObjectType type, uint64_t handle, uint64_t retire_frame_number, const VulkanAllocation& allocation) {
+        if (handle == 0) {
+            return;
+        }
+
+        Entry entry{};
+        entry.retire_frame_number = retire_frame_number;
+        entry.type = type;
+        entry.handle = handle;
+        entry.allocation = allocation;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.push_back(entry);
+    }
+
+    void DeletionQueue::_destroy(Entry& entry) {
+        switch (entry.type) {
+            case VK_OBJECT_TYPE_BUFFER:
+                m_allocator->destroy_buffer(from_handle<VkBuffer>(entry.handle), entry.allocation);
+                break;
+            case VK_OBJECT_TYPE_IMAGE:
+                m_allocator->destroy_image(from_handle<VkImage>(entry.handle), entry.allocation);
+                break;
+            case VK_OBJECT_TYPE_IMAGE_VIEW:
+                vkDestroyImageView(m_device, from_handle<VkImageView>(entry.handle), m_allocation_callbacks);
+                break;
+            case VK_OBJECT_TYPE_FRAMEBUFFER:
+                vkDestroyFramebuffer(m_device, from_handle<VkFramebuffer>(entry.handle), m_allocation_callbacks);
+                break;
+            case VK_OBJECT_TYPE_SWAPCHAIN_KHR:
+                vkDestroySwapchainKHR(m_device, from_handle<VkSwapchainKHR>(entry.handle), m_allocation_callbacks);
+                break;
+            case VK_OBJECT_TYPE_DESCRIPTOR_POOL:
+                vkDestroyDescriptorPool(m_device, from_handle<VkDescriptorPool>(entry.handle), m_allocation_callbacks);
+                break;
+            case VK_OBJECT_TYPE_SAMPLER:
+                vkDestroySampler(m_device, from_handle<VkSampler>(entry.handle), m_allocation_callbacks);
+                break;
+            case VK_OBJECT_TYPE_PIPELINE:
+                vkDestroyPipeline(m_device, from_handle<VkPipeline>(entry.handle), m_allocation_callbacks);
+                break;
+            case VK_OBJECT_TYPE_SEMAPHORE:
+                vkDestroySemaphore(m_device, from_handle<VkSemaphore>(entry.handle), m_allocation_callbacks);
+                break;
+            default:
+                std::cout << "deletion queue doesn't know how to destroy object type " << entry.type << "\n";
+                std::exit(-1);
+        }
+
+        m_destroyed_count++;
+    }
+
+}
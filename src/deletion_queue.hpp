@@ -0,0 +1,65 @@
+#ifndef __DELETION_QUEUE_HPP__
+#define __DELETION_QUEUE_HPP__
+
+#include "vulkan_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <mutex>
+#include <cstdint>
+
+namespace vlk {
+
+    // vulkan objects that frames already submitted may still be using, kept until every frame before their
+    // retire_frame_number (normally the frame being recorded when they were replaced) has finished. collect is called once
+    // a frame with the renderer's completed frame count and destroys everything that retired in one batch, so resources
+    // can be dropped at any point without waiting on the device. objects are destroyed in the order they were queued
+    class DeletionQueue {
+    public:
+        DeletionQueue(VkDevice device, const VkAllocationCallbacks* allocation_callbacks, VulkanAllocator* allocator);
+        ~DeletionQueue();
+
+        size_t get_pending_count() const;
+        inline uint64_t get_destroyed_count() const { return m_destroyed_count; }
+
+        void destroy_buffer(VkBuffer buffer, const VulkanAllocation& allocation, uint64_t retire_frame_number);
+        void destroy_image(VkImage image, const VulkanAllocation& allocation, uint64_t retire_frame_number);
+        void destroy_image_view(VkImageView image_view, uint64_t retire_frame_number);
+        void destroy_framebuffer(VkFramebuffer framebuffer, uint64_t retire_frame_number);
+        void destroy_swapchain(VkSwapchainKHR swapchain, uint64_t retire_frame_number);
+        void destroy_descriptor_pool(VkDescriptorPool descriptor_pool, uint64_t retire_frame_number);
+        void destroy_sampler(VkSampler sampler, uint64_t retire_frame_number);
+        void destroy_pipeline(VkPipeline pipeline, uint64_t retire_frame_number);
+        void destroy_semaphore(VkSemaphore semaphore, uint64_t retire_frame_number);
+
+        void collect(uint64_t completed_frame_count);
+        // destroys everything regardless of frame, only once the device is idle
+        void flush();
+
+    private:
+        struct Entry {
+            uint64_t retire_frame_number{ 0 };
+            VkObjectType type{ VK_OBJECT_TYPE_UNKNOWN };
+            uint64_t handle{ 0 };           // non-dispatchable handles are 64 bit on every platform
+            VulkanAllocation allocation{};  // buffers and images only
+        };
+
+        void _push(VkObjectType type, uint64_t handle, uint64_t retire_frame_number, const VulkanAllocation& allocation = {});
+        void _destroy(Entry& entry);
+
+        DeletionQueue(const DeletionQueue& other) = delete;
+        DeletionQueue& operator=(const DeletionQueue& other) = delete;
+
+        VkDevice m_device{ nullptr };
+        const VkAllocationCallbacks* m_allocation_callbacks{ nullptr };
+        VulkanAllocator* m_allocator{ nullptr };
+
+        mutable std::mutex m_mutex{};
+        std::deque<Entry> m_entries{};
+        uint64_t m_destroyed_count{ 0 };
+    };
+
+}
+
+#endif // __DELETION_QUEUE_HPP__
@@ -0,0 +1,69 @@
+#include "frame_pacer.hpp"
+
+#include <iostream>
+#include <thread>
+#include <algorithm>
+
+namespace vlk {
+
+    // os sleeps overshoot by up to a scheduler tick, so the last stretch before the deadline is spent yielding instead
+    static constexpr std::chrono::microseconds SPIN_THRESHOLD{ 1500 };
+
+    FramePacer::FramePacer(double target_fps) {
+        if (target_fps > 0.0) {
+            m_frame_interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / target_fps));
+        }
+        m_next_frame = Clock::now();
+    }
+
+    void FramePacer::wait() {
+        if (m_frame_interval == Clock::duration::zero()) {
+            return;
+        }
+
+        Clock::time_point now = Clock::now();
+        if (m_next_frame - now > SPIN_THRESHOLD) {
+            std::this_thread::sleep_until(m_next_frame - SPIN_THRESHOLD);
+        }
+
+        while (Clock::now() < m_next_frame) {
+            std::this_thread::yield();
+        }
+
+        // fell more than a whole frame behind, start pacing again from here rather than bursting
+        now = Clock::now();
+        m_next_frame += m_frame_interval;
+        if (m_next_frame < now) {
+            m_next_frame = now + m_frame_interval;
+        }
+    }
+
+    void FramePacer::mark_input() {
+        m_input_time = Clock::now();
+        m_input_marked = true;
+    }
+
+    void FramePacer::mark_present() {
+        if (!m_input_marked) {
+            return;
+        }
+
+        double latency_ms = std::chrono::duration<double, std::milli>(Clock::now() - m_input_time).count();
+        m_input_marked = false;
+
+        m_latency.min_ms = m_latency.samples == 0 ? latency_ms : std::min(m_latency.min_ms, latency_ms);
+        m_latency.max_ms = std::max(m_latency.max_ms, latency_ms);
+        m_latency.total_ms += latency_ms;
+        m_latency.samples++;
+    }
+
+    void FramePacer::print_stats() const {
+        if (m_latency.samples == 0) {
+            return;
+        }
+
+        std::cout << "input to present latency over " << m_latency.samples << " frames: avg " << m_latency.average_ms()
+            << " ms, min " << m_latency.min_ms << " ms, max " << m_latency.max_ms << " ms\n";
+    }
+
+}
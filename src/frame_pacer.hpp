@@ -0,0 +1,48 @@
+#ifndef __FRAME_PACER_HPP__
+#define __FRAME_PACER_HPP__
+
+#include <chrono>
+#include <cstdint>
+
+namespace vlk {
+
+    struct LatencyStats {
+        uint64_t samples{ 0 };
+        double total_ms{ 0.0 };
+        double min_ms{ 0.0 };
+        double max_ms{ 0.0 };
+
+        inline double average_ms() const { return samples == 0 ? 0.0 : total_ms / samples; }
+    };
+
+    // caps the frame rate and measures how long sampled input takes to reach vkQueuePresentKHR. the measurement ends at
+    // the present call, not at scan out, the time spent in the presentation engine isn't visible without present timing
+    // extensions
+    class FramePacer {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // 0 leaves the frame rate uncapped
+        FramePacer(double target_fps = 0.0);
+
+        inline const LatencyStats& get_latency_stats() const { return m_latency; }
+
+        // sleeps until the next frame is due. a frame that ran late doesn't make the following ones rush to catch up
+        void wait();
+
+        void mark_input();
+        void mark_present();
+
+        void print_stats() const;
+
+    private:
+        Clock::duration m_frame_interval{ 0 };
+        Clock::time_point m_next_frame{};
+        Clock::time_point m_input_time{};
+        bool m_input_marked{ false };
+        LatencyStats m_latency{};
+    };
+
+}
+
+#endif // __FRAME_PACER_HPP__
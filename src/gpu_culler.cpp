@@ -0,0 +1,312 @@
+#include "gpu_culler.hpp"
+#include "profiler.hpp"
+
+#include <shaders/cull_instances_comp.hpp>
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace vlk {
+
+    // matches the std140 uniform block in cull_instances.comp
+    struct CullParams {
+        float occlusion_view_projection[16]{};
+        float frustum_planes[6][4]{};
+        float hi_z_size[2]{};
+        uint32_t instance_count{ 0 };
+        uint32_t hi_z_level_count{ 0 };
+        uint32_t occlusion_enabled{ 0 };
+        uint32_t padding[3]{};
+    };
+
+    // planes point inwards and are normalized, so dot(plane.xyz, p) + plane.w is the signed distance to p. depth is [0, 1],
+    // which makes the near plane the third row on its own instead of the fourth plus the third
+    static void extract_frustum_planes(const float m[16], float planes[6][4]) {
+        // column major, so column i holds component i of every row
+        for (int i = 0; i < 4; i++) {
+            float row0 = m[i * 4 + 0];
+            float row1 = m[i * 4 + 1];
+            float row2 = m[i * 4 + 2];
+            float row3 = m[i * 4 + 3];
+
+            planes[0][i] = row3 + row0;     // left
+            planes[1][i] = row3 - row0;     // right
+            planes[2][i] = row3 + row1;     // top, y points down in clip space
+            planes[3][i] = row3 - row1;     // bottom
+            planes[4][i] = row2;            // near
+            planes[5][i] = row3 - row2;     // far
+        }
+
+        for (int i = 0; i < 6; i++) {
+            float length = std::sqrt(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+            for (int j = 0; j < 4; j++) {
+                planes[i][j] /= length;
+            }
+        }
+    }
+
+    GpuCuller::GpuCuller(VulkanDevice* device, VulkanUploader* uploader, HiZPyramid* hi_z, UniformRing* uniforms)
+        : m_device(device), m_dispatch(&device->get_dispatch()), m_uploader(uploader), m_hi_z(hi_z), m_uniforms(uniforms) {
+        VLK_PROFILE_SCOPE("GpuCuller::GpuCuller");
+
+        // every draw's instances start at its firstInstance, without this feature it has to be 0
+        if (m_device->get_physical_device_features().drawIndirectFirstInstance != VK_TRUE) {
+            std::cout << "failed to create gpu culler, drawIndirectFirstInstance isn't supported\n";
+            std::exit(-1);
+        }
+
+        _init_pipeline();
+    }
+
+    GpuCuller::~GpuCuller() {
+        VulkanAllocator* allocator = m_device->get_allocator();
+
+        vkDestroyPipeline(m_device->get_device(), m_pipeline, m_device->get_allocation_callbacks());
+        vkDestroyPipelineLayout(m_device->get_device(), m_pipeline_layout, m_device->get_allocation_callbacks());
+        vkDestroyDescriptorPool(m_device->get_device(), m_descriptor_pool, m_device->get_allocation_callbacks());
+        vkDestroyDescriptorSetLayout(m_device->get_device(), m_descriptor_set_layout, m_device->get_allocation_callbacks());
+
+        if (m_uploaded) {
+            allocator->destroy_buffer(m_indirect_buffer, m_indirect_allocation);
+            allocator->destroy_buffer(m_template_buffer, m_template_allocation);
+            allocator->destroy_buffer(m_draw_instance_buffer, m_draw_instance_allocation);
+            allocator->destroy_buffer(m_instance_buffer, m_instance_allocation);
+        }
+    }
+
+    uint32_t GpuCuller::add_draw(const Mesh& mesh) {
+        if (m_uploaded) {
+            std::cout << "failed to add draw, the gpu culler has already been uploaded\n";
+            std::exit(-1);
+        }
+
+        VkDrawIndexedIndirectCommand command{};
+        command.indexCount = mesh.index_count;
+        command.instanceCount = 0;
+        command.firstIndex = mesh.first_index;
+        command.vertexOffset = mesh.vertex_offset;
+        command.firstInstance = 0;
+        m_commands.push_back(command);
+        m_mesh_radii.push_back(mesh.radius);
+
+        return static_cast<uint32_t>(m_commands.size() - 1);
+    }
+
+    void GpuCuller::add_instance(uint32_t draw_index, const float position[3], float scale) {
+        if (m_uploaded || draw_index >= m_commands.size()) {
+            std::cout << "failed to add instance, the gpu culler has already been uploaded or the draw doesn't exist\n";
+            std::exit(-1);
+        }
+
+        CullInstance instance{};
+        instance.position[0] = position[0];
+        instance.position[1] = position[1];
+        instance.position[2] = position[2];
+        instance.scale = scale;
+        instance.radius = m_mesh_radii[draw_index] * scale;
+        instance.draw_index = draw_index;
+        m_instances.push_back(instance);
+
+        // the instance's slot in the draw's range is only known on the gpu, this just sizes the range
+        m_commands[draw_index].instanceCount++;
+    }
+
+    void GpuCuller::upload() {
+        VLK_PROFILE_SCOPE("GpuCuller::upload");
+
+        if (m_uploaded || m_instances.empty()) {
+            std::cout << "failed to upload gpu culler, it is empty or has already been uploaded\n";
+            std::exit(-1);
+        }
+
+        // each draw gets a range of the DrawInstance buffer as big as its instance count, and starts every frame empty
+        uint32_t first_instance = 0;
+        for (VkDrawIndexedIndirectCommand& command : m_commands) {
+            command.firstInstance = first_instance;
+            first_instance += command.instanceCount;
+            command.instanceCount = 0;
+        }
+
+        VulkanAllocator* allocator = m_device->get_allocator();
+        VkDeviceSize instances_size = m_instances.size() * sizeof(CullInstance);
+        VkDeviceSize draw_instances_size = m_instances.size() * sizeof(DrawInstance);
+        VkDeviceSize commands_size = m_commands.size() * sizeof(VkDrawIndexedIndirectCommand);
+
+        m_instance_buffer = allocator->create_buffer(instances_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_instance_allocation);
+        m_draw_instance_buffer = allocator->create_buffer(draw_instances_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_draw_instance_allocation);
+        m_template_buffer = allocator->create_buffer(commands_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_template_allocation);
+        m_indirect_buffer = allocator->create_buffer(commands_size,
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_indirect_allocation);
+
+        m_uploader->upload_buffer(m_instance_buffer, 0, m_instances.data(), instances_size, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+        m_last_upload = m_uploader->upload_buffer(m_template_buffer, 0, m_commands.data(), commands_size, VK_ACCESS_TRANSFER_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        m_uploaded = true;
+        _init_descriptor_set();
+
+        std::cout << "successfully uploaded " << m_instances.size() << " instances across " << m_commands.size() << " draws for gpu culling\n";
+    }
+
+    void GpuCuller::record(VkCommandBuffer command_buffer, const float view_projection[16]) {
+        VLK_PROFILE_SCOPE("GpuCuller::record");
+
+        CullParams params{};
+        std::memcpy(params.occlusion_view_projection, m_previous_view_projection, sizeof(params.occlusion_view_projection));
+        extract_frustum_planes(view_projection, params.frustum_planes);
+        params.hi_z_size[0] = static_cast<float>(m_hi_z->get_extent().width);
+        params.hi_z_size[1] = static_cast<float>(m_hi_z->get_extent().height);
+        params.instance_count = get_instance_count();
+        params.hi_z_level_count = m_hi_z->get_level_count();
+        params.occlusion_enabled = m_hi_z->is_valid() ? 1 : 0;
+
+        uint32_t params_offset = m_uniforms->push(params);
+
+        std::memcpy(m_previous_view_projection, view_projection, sizeof(m_previous_view_projection));
+
+        VkBufferCopy copy{};
+        copy.size = m_commands.size() * sizeof(VkDrawIndexedIndirectCommand);
+        m_dispatch->vkCmdCopyBuffer(command_buffer, m_template_buffer, m_indirect_buffer, 1, &copy);
+
+        // the only hazard inside the pass, the ones with last frame and the draws are the render graph's
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        m_dispatch->vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        VkDescriptorSet descriptor_sets[] = { m_descriptor_set, m_hi_z->get_read_set() };
+        m_dispatch->vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+        m_dispatch->vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 2, descriptor_sets, 1, &params_offset);
+
+        // a million instances is more workgroups than one dimension is guaranteed to hold, the rest spill into y
+        uint32_t group_count = (get_instance_count() + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+        uint32_t max_groups_x = m_device->get_physical_device_properties().limits.maxComputeWorkGroupCount[0];
+        uint32_t groups_x = std::min(group_count, max_groups_x);
+        uint32_t groups_y = (group_count + groups_x - 1) / groups_x;
+        m_dispatch->vkCmdDispatch(command_buffer, groups_x, groups_y, 1);
+    }
+
+    void GpuCuller::draw(VkCommandBuffer command_buffer, uint32_t begin, uint32_t end) const {
+        const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+        // every feature the device has is enabled, so this decides whether a range is one command or one per draw
+        uint32_t max_draw_count = 1;
+        if (m_device->get_physical_device_features().multiDrawIndirect == VK_TRUE) {
+            max_draw_count = std::max(m_device->get_physical_device_properties().limits.maxDrawIndirectCount, 1u);
+        }
+
+        for (uint32_t first = begin; first < end; first += max_draw_count) {
+            uint32_t count = std::min(end - first, max_draw_count);
+            m_dispatch->vkCmdDrawIndexedIndirect(command_buffer, m_indirect_buffer, static_cast<VkDeviceSize>(first) * stride,
+                count, stride);
+        }
+    }
+
+    void GpuCuller::_init_pipeline() {
+        VkDescriptorSetLayoutBinding bindings[4]{};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        // instances in, draw commands in and out, visible instances out
+        for (uint32_t i = 1; i < 4; i++) {
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layout_create_info{};
+        layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_create_info.bindingCount = 4;
+        layout_create_info.pBindings = bindings;
+
+        if (vkCreateDescriptorSetLayout(m_device->get_device(), &layout_create_info, m_device->get_allocation_callbacks(), &m_descriptor_set_layout) != VK_SUCCESS) {
+            std::cout << "failed to create culling descriptor set layout\n";
+            std::exit(-1);
+        }
+
+        VkDescriptorSetLayout set_layouts[] = { m_descriptor_set_layout, m_hi_z->get_read_set_layout() };
+
+        VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+        pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_create_info.setLayoutCount = 2;
+        pipeline_layout_create_info.pSetLayouts = set_layouts;
+
+        if (vkCreatePipelineLayout(m_device->get_device(), &pipeline_layout_create_info, m_device->get_allocation_callbacks(), &m_pipeline_layout) != VK_SUCCESS) {
+            std::cout << "failed to create culling pipeline layout\n";
+            std::exit(-1);
+        }
+
+        VkComputePipelineCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        create_info.stage.module = m_device->get_shader_module_cache()->get_or_create(
+            shaders::cull_instances_comp, sizeof(shaders::cull_instances_comp), "cull_instances.comp");
+        create_info.stage.pName = "main";
+        create_info.layout = m_pipeline_layout;
+
+        if (m_device->get_pipeline_cache()->create_compute_pipelines(1, &create_info, &m_pipeline) != VK_SUCCESS) {
+            std::cout << "failed to create culling pipeline\n";
+            std::exit(-1);
+        }
+    }
+
+    void GpuCuller::_init_descriptor_set() {
+        VkDescriptorPoolSize pool_sizes[2]{};
+        pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        pool_sizes[0].descriptorCount = 1;
+        pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pool_sizes[1].descriptorCount = 3;
+
+        VkDescriptorPoolCreateInfo pool_create_info{};
+        pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_create_info.maxSets = 1;
+        pool_create_info.poolSizeCount = 2;
+        pool_create_info.pPoolSizes = pool_sizes;
+
+        if (vkCreateDescriptorPool(m_device->get_device(), &pool_create_info, m_device->get_allocation_callbacks(), &m_descriptor_pool) != VK_SUCCESS) {
+            std::cout << "failed to create culling descriptor pool\n";
+            std::exit(-1);
+        }
+
+        VkDescriptorSetAllocateInfo allocate_info{};
+        allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocate_info.descriptorPool = m_descriptor_pool;
+        allocate_info.descriptorSetCount = 1;
+        allocate_info.pSetLayouts = &m_descriptor_set_layout;
+
+        if (vkAllocateDescriptorSets(m_device->get_device(), &allocate_info, &m_descriptor_set) != VK_SUCCESS) {
+            std::cout << "failed to allocate culling descriptor set\n";
+            std::exit(-1);
+        }
+
+        VkDescriptorBufferInfo buffer_infos[4]{};
+        buffer_infos[0] = { m_uniforms->get_buffer(), 0, sizeof(CullParams) };
+        buffer_infos[1] = { m_instance_buffer, 0, VK_WHOLE_SIZE };
+        buffer_infos[2] = { m_indirect_buffer, 0, VK_WHOLE_SIZE };
+        buffer_infos[3] = { m_draw_instance_buffer, 0, VK_WHOLE_SIZE };
+
+        VkWriteDescriptorSet writes[4]{};
+        for (uint32_t i = 0; i < 4; i++) {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = m_descriptor_set;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo = &buffer_infos[i];
+        }
+
+        m_dispatch->vkUpdateDescriptorSets(m_device->get_device(), 4, writes, 0, nullptr);
+    }
+
+}
@@ -0,0 +1,109 @@
+#ifndef __GPU_CULLER_HPP__
+#define __GPU_CULLER_HPP__
+
+#include "vulkan_device.hpp"
+#include "vulkan_allocator.hpp"
+#include "vulkan_uploader.hpp"
+#include "mesh_buffer.hpp"
+#include "hi_z_pyramid.hpp"
+#include "uniform_ring.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace vlk {
+
+    // what the culling pass reads for every instance, laid out to match the std430 struct in cull_instances.comp
+    struct CullInstance {
+        float position[3]{};
+        float scale{ 1.0f };
+        float radius{ 0.0f };       // world space bounding sphere, the mesh's radius times scale
+        uint32_t draw_index{ 0 };
+        uint32_t padding[2]{};
+    };
+
+    // what the culling pass writes for every visible instance, read by the vertex shader through gl_InstanceIndex
+    struct DrawInstance {
+        float position[3]{};
+        float scale{ 1.0f };
+    };
+
+    // culls instances on the gpu against the camera frustum and last frame's hi-z pyramid. every mesh is one indexed
+    // indirect draw whose instanceCount is zeroed each frame, a compute shader appends each visible instance to its draw's
+    // range of the DrawInstance buffer and bumps the count. the cpu records the same handful of commands whatever the
+    // instance count is. needs the drawIndirectFirstInstance feature
+    class GpuCuller {
+    public:
+        static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+        // the culling parameters are allocated from uniforms every frame
+        GpuCuller(VulkanDevice* device, VulkanUploader* uploader, HiZPyramid* hi_z, UniformRing* uniforms);
+        ~GpuCuller();
+
+        inline uint32_t get_draw_count() const { return static_cast<uint32_t>(m_commands.size()); }
+        inline uint32_t get_instance_count() const { return static_cast<uint32_t>(m_instances.size()); }
+        // the DrawInstance buffer the vertex shader reads through the bindless set, only valid after upload
+        inline VkBuffer get_draw_instance_buffer() const { return m_draw_instance_buffer; }
+        // the rest of what record touches, for declaring the culling pass's accesses. all of them only valid after upload
+        inline VkBuffer get_instance_buffer() const { return m_instance_buffer; }
+        inline VkBuffer get_template_buffer() const { return m_template_buffer; }
+        inline VkBuffer get_indirect_buffer() const { return m_indirect_buffer; }
+        inline UploadTicket get_last_upload() const { return m_last_upload; }
+
+        // returns the draw index instances of this mesh are added with
+        uint32_t add_draw(const Mesh& mesh);
+        void add_instance(uint32_t draw_index, const float position[3], float scale);
+
+        // creates the gpu buffers and queues their contents on the uploader, nothing can be added afterwards
+        void upload();
+
+        // records the culling dispatch, outside of a render pass and after HiZPyramid::prepare. the frustum comes from this
+        // frame's view_projection, the pyramid is tested with the one passed last frame, which is the camera it was built with.
+        // only orders its own copy before the dispatch, barriers against last frame and the draws are up to the caller. the
+        // commands work on a compute only queue as well
+        void record(VkCommandBuffer command_buffer, const float view_projection[16]);
+
+        // issues draws [begin, end) in as few vkCmdDrawIndexedIndirect calls as the device allows, the mesh buffer and a
+        // pipeline reading the DrawInstance buffer must already be bound
+        void draw(VkCommandBuffer command_buffer, uint32_t begin, uint32_t end) const;
+
+    private:
+        void _init_pipeline();
+        void _init_descriptor_set();
+
+        GpuCuller(const GpuCuller& other) = delete;
+        GpuCuller& operator=(const GpuCuller& other) = delete;
+
+        VulkanDevice* m_device{ nullptr };
+        const VulkanDeviceDispatch* m_dispatch{ nullptr };
+        VulkanUploader* m_uploader{ nullptr };
+        HiZPyramid* m_hi_z{ nullptr };
+        UniformRing* m_uniforms{ nullptr };
+
+        std::vector<VkDrawIndexedIndirectCommand> m_commands{};
+        std::vector<CullInstance> m_instances{};
+        std::vector<float> m_mesh_radii{};
+        bool m_uploaded{ false };
+        UploadTicket m_last_upload{};
+
+        VkBuffer m_instance_buffer{ nullptr };
+        VulkanAllocation m_instance_allocation{};
+        VkBuffer m_draw_instance_buffer{ nullptr };
+        VulkanAllocation m_draw_instance_allocation{};
+        VkBuffer m_template_buffer{ nullptr };      // the draws with every instanceCount at 0, copied over the indirect buffer each frame
+        VulkanAllocation m_template_allocation{};
+        VkBuffer m_indirect_buffer{ nullptr };
+        VulkanAllocation m_indirect_allocation{};
+
+        VkDescriptorSetLayout m_descriptor_set_layout{ nullptr };
+        VkDescriptorPool m_descriptor_pool{ nullptr };
+        VkDescriptorSet m_descriptor_set{ nullptr };
+        VkPipelineLayout m_pipeline_layout{ nullptr };
+        VkPipeline m_pipeline{ nullptr };
+
+        float m_previous_view_projection[16]{};
+    };
+
+}
+
+#endif // __GPU_CULLER_HPP__
@@ -0,0 +1,330 @@
+#include "hi_z_pyramid.hpp"
+#include "profiler.hpp"
+
+#include <shaders/hi_z_build_comp.hpp>
+
+#include <iostream>
+#include <algorithm>
+
+namespace vlk {
+
+    struct HiZBuildPushConstants {
+        int32_t source_size[2]{};
+        int32_t destination_size[2]{};
+    };
+
+    static uint32_t previous_power_of_two(uint32_t value) {
+        uint32_t result = 1;
+        while (result * 2 <= value) {
+            result *= 2;
+        }
+
+        return result;
+    }
+
+    HiZPyramid::HiZPyramid(VulkanDevice* device) : m_device(device), m_dispatch(&device->get_dispatch()) {
+        VLK_PROFILE_SCOPE("HiZPyramid::HiZPyramid");
+
+        // only ever read with texelFetch or at exact texel centers, nearest keeps every value a real depth
+        VkSamplerCreateInfo sampler_create_info{};
+        sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        sampler_create_info.magFilter = VK_FILTER_NEAREST;
+        sampler_create_info.minFilter = VK_FILTER_NEAREST;
+        sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler_create_info.minLod = 0.0f;
+        sampler_create_info.maxLod = VK_LOD_CLAMP_NONE;
+
+        if (vkCreateSampler(m_device->get_device(), &sampler_create_info, m_device->get_allocation_callbacks(), &m_sampler) != VK_SUCCESS) {
+            std::cout << "failed to create hi-z sampler\n";
+            std::exit(-1);
+        }
+
+        _init_pipeline();
+    }
+
+    HiZPyramid::~HiZPyramid() {
+        _destroy_pyramid(m_current);
+
+        vkDestroyPipeline(m_device->get_device(), m_pipeline, m_device->get_allocation_callbacks());
+        vkDestroyPipelineLayout(m_device->get_device(), m_pipeline_layout, m_device->get_allocation_callbacks());
+        vkDestroyDescriptorSetLayout(m_device->get_device(), m_read_set_layout, m_device->get_allocation_callbacks());
+        vkDestroyDescriptorSetLayout(m_device->get_device(), m_build_set_layout, m_device->get_allocation_callbacks());
+        vkDestroySampler(m_device->get_device(), m_sampler, m_device->get_allocation_callbacks());
+    }
+
+    void HiZPyramid::prepare(uint64_t frame_number) {
+        if (m_current.depth_image_view == m_device->get_depth_image_view()) {
+            return;
+        }
+
+        _retire_pyramid(m_current, frame_number);
+
+        _create_pyramid(m_current);
+    }
+
+    void HiZPyramid::build(VkCommandBuffer command_buffer) {
+        VLK_PROFILE_SCOPE("HiZPyramid::build");
+
+        m_dispatch->vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+
+        VkExtent2D source_extent = m_device->get_swapchain_extent();
+        VkExtent2D destination_extent = m_current.extent;
+
+        for (uint32_t level = 0; level < m_current.level_count; level++) {
+            if (level > 0) {
+                VkMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+                m_dispatch->vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+            }
+
+            HiZBuildPushConstants constants{};
+            constants.source_size[0] = static_cast<int32_t>(source_extent.width);
+            constants.source_size[1] = static_cast<int32_t>(source_extent.height);
+            constants.destination_size[0] = static_cast<int32_t>(destination_extent.width);
+            constants.destination_size[1] = static_cast<int32_t>(destination_extent.height);
+
+            m_dispatch->vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &m_current.build_sets[level], 0, nullptr);
+            m_dispatch->vkCmdPushConstants(command_buffer, m_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HiZBuildPushConstants), &constants);
+            m_dispatch->vkCmdDispatch(command_buffer, (destination_extent.width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+                (destination_extent.height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+
+            source_extent = destination_extent;
+            destination_extent = { std::max(destination_extent.width / 2, 1u), std::max(destination_extent.height / 2, 1u) };
+        }
+
+        m_current.built = true;
+    }
+
+    void HiZPyramid::_init_pipeline() {
+        VkDescriptorSetLayoutBinding build_bindings[2]{};
+        build_bindings[0].binding = 0;
+        build_bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        build_bindings[0].descriptorCount = 1;
+        build_bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        build_bindings[1].binding = 1;
+        build_bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        build_bindings[1].descriptorCount = 1;
+        build_bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutCreateInfo layout_create_info{};
+        layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_create_info.bindingCount = 2;
+        layout_create_info.pBindings = build_bindings;
+
+        if (vkCreateDescriptorSetLayout(m_device->get_device(), &layout_create_info, m_device->get_allocation_callbacks(), &m_build_set_layout) != VK_SUCCESS) {
+            std::cout << "failed to create hi-z build descriptor set layout\n";
+            std::exit(-1);
+        }
+
+        VkDescriptorSetLayoutBinding read_binding = build_bindings[0];
+        layout_create_info.bindingCount = 1;
+        layout_create_info.pBindings = &read_binding;
+
+        if (vkCreateDescriptorSetLayout(m_device->get_device(), &layout_create_info, m_device->get_allocation_callbacks(), &m_read_set_layout) != VK_SUCCESS) {
+            std::cout << "failed to create hi-z read descriptor set layout\n";
+            std::exit(-1);
+        }
+
+        VkPushConstantRange push_constant_range{};
+        push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        push_constant_range.offset = 0;
+        push_constant_range.size = sizeof(HiZBuildPushConstants);
+
+        VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+        pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_create_info.setLayoutCount = 1;
+        pipeline_layout_create_info.pSetLayouts = &m_build_set_layout;
+        pipeline_layout_create_info.pushConstantRangeCount = 1;
+        pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+        if (vkCreatePipelineLayout(m_device->get_device(), &pipeline_layout_create_info, m_device->get_allocation_callbacks(), &m_pipeline_layout) != VK_SUCCESS) {
+            std::cout << "failed to create hi-z pipeline layout\n";
+            std::exit(-1);
+        }
+
+        VkComputePipelineCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        create_info.stage.module = m_device->get_shader_module_cache()->get_or_create(
+            shaders::hi_z_build_comp, sizeof(shaders::hi_z_build_comp), "hi_z_build.comp");
+        create_info.stage.pName = "main";
+        create_info.layout = m_pipeline_layout;
+
+        if (m_device->get_pipeline_cache()->create_compute_pipelines(1, &create_info, &m_pipeline) != VK_SUCCESS) {
+            std::cout << "failed to create hi-z pipeline\n";
+            std::exit(-1);
+        }
+    }
+
+    void HiZPyramid::_create_pyramid(Pyramid& pyramid) {
+        VLK_PROFILE_SCOPE("HiZPyramid::_create_pyramid");
+
+        // level 0 is the largest power of two that fits in the depth, so every level below is exactly half the one above
+        const VkExtent2D& depth_extent = m_device->get_swapchain_extent();
+        pyramid.depth_image_view = m_device->get_depth_image_view();
+        pyramid.extent = { previous_power_of_two(depth_extent.width), previous_power_of_two(depth_extent.height) };
+        pyramid.level_count = 1;
+        while (pyramid.level_count < MAX_LEVELS && (std::max(pyramid.extent.width, pyramid.extent.height) >> pyramid.level_count) > 0) {
+            pyramid.level_count++;
+        }
+
+        VkImageCreateInfo image_create_info{};
+        image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_create_info.imageType = VK_IMAGE_TYPE_2D;
+        image_create_info.format = VK_FORMAT_R32_SFLOAT;
+        image_create_info.extent = { pyramid.extent.width, pyramid.extent.height, 1 };
+        image_create_info.mipLevels = pyramid.level_count;
+        image_create_info.arrayLayers = 1;
+        image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_create_info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        pyramid.image = m_device->get_allocator()->create_image(image_create_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &pyramid.allocation);
+
+        VkImageViewCreateInfo view_create_info{};
+        view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_create_info.image = pyramid.image;
+        view_create_info.format = VK_FORMAT_R32_SFLOAT;
+        view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_create_info.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+        view_create_info.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, pyramid.level_count, 0, 1 };
+
+        if (vkCreateImageView(m_device->get_device(), &view_create_info, m_device->get_allocation_callbacks(), &pyramid.view) != VK_SUCCESS) {
+            std::cout << "failed to create hi-z image view\n";
+            std::exit(-1);
+        }
+
+        pyramid.level_views.resize(pyramid.level_count);
+        for (uint32_t level = 0; level < pyramid.level_count; level++) {
+            view_create_info.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+
+            if (vkCreateImageView(m_device->get_device(), &view_create_info, m_device->get_allocation_callbacks(), &pyramid.level_views[level]) != VK_SUCCESS) {
+                std::cout << "failed to create hi-z level image view\n";
+                std::exit(-1);
+            }
+        }
+
+        VkDescriptorPoolSize pool_sizes[2]{};
+        pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        pool_sizes[0].descriptorCount = pyramid.level_count + 1;
+        pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        pool_sizes[1].descriptorCount = pyramid.level_count;
+
+        VkDescriptorPoolCreateInfo pool_create_info{};
+        pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_create_info.maxSets = pyramid.level_count + 1;
+        pool_create_info.poolSizeCount = 2;
+        pool_create_info.pPoolSizes = pool_sizes;
+
+        if (vkCreateDescriptorPool(m_device->get_device(), &pool_create_info, m_device->get_allocation_callbacks(), &pyramid.descriptor_pool) != VK_SUCCESS) {
+            std::cout << "failed to create hi-z descriptor pool\n";
+            std::exit(-1);
+        }
+
+        std::vector<VkDescriptorSetLayout> set_layouts(pyramid.level_count, m_build_set_layout);
+        set_layouts.push_back(m_read_set_layout);
+        std::vector<VkDescriptorSet> sets(set_layouts.size());
+
+        VkDescriptorSetAllocateInfo allocate_info{};
+        allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocate_info.descriptorPool = pyramid.descriptor_pool;
+        allocate_info.descriptorSetCount = static_cast<uint32_t>(set_layouts.size());
+        allocate_info.pSetLayouts = set_layouts.data();
+
+        if (vkAllocateDescriptorSets(m_device->get_device(), &allocate_info, sets.data()) != VK_SUCCESS) {
+            std::cout << "failed to allocate hi-z descriptor sets\n";
+            std::exit(-1);
+        }
+
+        pyramid.build_sets.assign(sets.begin(), sets.begin() + pyramid.level_count);
+        pyramid.read_set = sets.back();
+
+        // the pyramid stays in the general layout so it can be written by one level's dispatch and read by the next
+        std::vector<VkDescriptorImageInfo> image_infos(pyramid.level_count * 2 + 1);
+        std::vector<VkWriteDescriptorSet> writes(pyramid.level_count * 2 + 1);
+        for (uint32_t level = 0; level < pyramid.level_count; level++) {
+            VkDescriptorImageInfo& source = image_infos[level * 2];
+            source.sampler = m_sampler;
+            source.imageView = level == 0 ? pyramid.depth_image_view : pyramid.level_views[level - 1];
+            source.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+            VkDescriptorImageInfo& destination = image_infos[level * 2 + 1];
+            destination.imageView = pyramid.level_views[level];
+            destination.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            writes[level * 2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[level * 2].dstSet = pyramid.build_sets[level];
+            writes[level * 2].dstBinding = 0;
+            writes[level * 2].descriptorCount = 1;
+            writes[level * 2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[level * 2].pImageInfo = &source;
+
+            writes[level * 2 + 1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[level * 2 + 1].dstSet = pyramid.build_sets[level];
+            writes[level * 2 + 1].dstBinding = 1;
+            writes[level * 2 + 1].descriptorCount = 1;
+            writes[level * 2 + 1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            writes[level * 2 + 1].pImageInfo = &destination;
+        }
+
+        VkDescriptorImageInfo& read = image_infos.back();
+        read.sampler = m_sampler;
+        read.imageView = pyramid.view;
+        read.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        writes.back().sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes.back().dstSet = pyramid.read_set;
+        writes.back().dstBinding = 0;
+        writes.back().descriptorCount = 1;
+        writes.back().descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes.back().pImageInfo = &read;
+
+        m_dispatch->vkUpdateDescriptorSets(m_device->get_device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        std::cout << "successfully created hi-z pyramid (" << pyramid.extent.width << "x" << pyramid.extent.height << ", "
+            << pyramid.level_count << " levels)\n";
+    }
+
+    void HiZPyramid::_retire_pyramid(Pyramid& pyramid, uint64_t retire_frame_number) {
+        if (pyramid.image == nullptr) {
+            return;
+        }
+
+        // descriptor sets go with their pool, the pool is queued first so nothing outlives the views it references
+        DeletionQueue* deletion_queue = m_device->get_deletion_queue();
+        deletion_queue->destroy_descriptor_pool(pyramid.descriptor_pool, retire_frame_number);
+        for (VkImageView level_view : pyramid.level_views) {
+            deletion_queue->destroy_image_view(level_view, retire_frame_number);
+        }
+        deletion_queue->destroy_image_view(pyramid.view, retire_frame_number);
+        deletion_queue->destroy_image(pyramid.image, pyramid.allocation, retire_frame_number);
+
+        pyramid = {};
+    }
+
+    void HiZPyramid::_destroy_pyramid(Pyramid& pyramid) {
+        if (pyramid.image == nullptr) {
+            return;
+        }
+
+        vkDestroyDescriptorPool(m_device->get_device(), pyramid.descriptor_pool, m_device->get_allocation_callbacks());
+        for (VkImageView level_view : pyramid.level_views) {
+            vkDestroyImageView(m_device->get_device(), level_view, m_device->get_allocation_callbacks());
+        }
+        vkDestroyImageView(m_device->get_device(), pyramid.view, m_device->get_allocation_callbacks());
+        m_device->get_allocator()->destroy_image(pyramid.image, pyramid.allocation);
+
+        pyramid = {};
+    }
+
+}
@@ -0,0 +1,81 @@
+#ifndef __HI_Z_PYRAMID_HPP__
+#define __HI_Z_PYRAMID_HPP__
+
+#include "vulkan_device.hpp"
+#include "vulkan_allocator.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace vlk {
+
+    // max reduction of the depth buffer into a mip chain, every texel holds the farthest depth of the pixels under it, so
+    // something whose nearest depth is behind the covering texels is hidden. built after the render pass, which makes it
+    // last frame's depth by the time the next frame's culling reads it. barriers around it are left to the render graph,
+    // the pyramid is read and written in the general layout
+    class HiZPyramid {
+    public:
+        static constexpr uint32_t MAX_LEVELS = 16;
+        static constexpr uint32_t WORKGROUP_SIZE = 8;
+
+        HiZPyramid(VulkanDevice* device);
+        ~HiZPyramid();
+
+        // false until the current pyramid has been built once, e.g. on the first frame or right after a resize
+        inline bool is_valid() const { return m_current.built; }
+        inline VkExtent2D get_extent() const { return m_current.extent; }
+        inline uint32_t get_level_count() const { return m_current.level_count; }
+        // changes whenever prepare recreates the pyramid, starting out in the undefined layout
+        inline VkImage get_image() const { return m_current.image; }
+
+        // one combined image sampler at binding 0 covering every level, for whoever tests against the pyramid
+        inline VkDescriptorSetLayout get_read_set_layout() const { return m_read_set_layout; }
+        inline VkDescriptorSet get_read_set() const { return m_current.read_set; }
+
+        // call every frame before anything reads the pyramid. when the device's depth image has been recreated the pyramid
+        // follows it, and the old one goes to the device's deletion queue until every frame before frame_number has finished
+        void prepare(uint64_t frame_number);
+        // reduces the depth written by this frame's render pass, the depth has to be in the read only layout and the
+        // pyramid in the general one
+        void build(VkCommandBuffer command_buffer);
+
+    private:
+        struct Pyramid {
+            VkImageView depth_image_view{ nullptr }; // the depth this pyramid reduces, owned by the device
+            VkExtent2D extent{};
+            uint32_t level_count{ 0 };
+            bool built{ false };
+
+            VkImage image{ nullptr };
+            VulkanAllocation allocation{};
+            VkImageView view{ nullptr };
+            std::vector<VkImageView> level_views{};
+
+            // every descriptor points at this pyramid's images, so they are allocated and retired with it
+            VkDescriptorPool descriptor_pool{ nullptr };
+            VkDescriptorSet read_set{ nullptr };
+            std::vector<VkDescriptorSet> build_sets{}; // one per level, reading the level above (the depth for level 0)
+        };
+
+        void _init_pipeline();
+        void _create_pyramid(Pyramid& pyramid);
+        void _retire_pyramid(Pyramid& pyramid, uint64_t retire_frame_number);
+        void _destroy_pyramid(Pyramid& pyramid);
+
+        HiZPyramid(const HiZPyramid& other) = delete;
+        HiZPyramid& operator=(const HiZPyramid& other) = delete;
+
+        VulkanDevice* m_device{ nullptr };
+        const VulkanDeviceDispatch* m_dispatch{ nullptr };
+        VkSampler m_sampler{ nullptr };
+        VkDescriptorSetLayout m_build_set_layout{ nullptr };
+        VkDescriptorSetLayout m_read_set_layout{ nullptr };
+        VkPipelineLayout m_pipeline_layout{ nullptr };
+        VkPipeline m_pipeline{ nullptr };
+
+        Pyramid m_current{};
+    };
+
+}
+
+#endif // __HI_Z_PYRAMID_HPP__
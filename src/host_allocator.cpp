@@ -0,0 +1,290 @@
+#include "host_allocator.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <atomic>
+
+namespace vlk {
+
+    enum class BlockKind : uint16_t {
+        Arena,
+        Pool,
+        Heap,
+    };
+
+    // command scope allocations are normally freed before the vulkan call that made them returns, so each thread bumps
+    // through its own arena without locking and rewinds it whenever nothing in it is live. only the owning thread moves
+    // offset, a block freed on another thread just drops live and the owner rewinds on its next allocation
+    struct CommandArena {
+        char* memory{ nullptr };
+        size_t offset{ 0 };
+        std::atomic<uint32_t> live{ 0 };
+
+        ~CommandArena() {
+            std::free(memory);
+        }
+    };
+
+    static thread_local CommandArena t_command_arena{};
+
+    // sits right before every pointer handed to the driver, free and reallocation get nothing else to go on
+    struct AllocationHeader {
+        void* base{ nullptr }; // start of the block the allocation was placed in
+        CommandArena* arena{ nullptr }; // arena blocks only, the thread's arena the block was bumped out of
+        uint64_t size{ 0 };
+        uint32_t scope{ 0 };
+        BlockKind kind{ BlockKind::Heap };
+        uint16_t size_class{ 0 };
+    };
+
+    static const char* const SCOPE_NAMES[HOST_ALLOCATION_SCOPE_COUNT] = { "command", "object", "cache", "device", "instance" };
+
+    static inline AllocationHeader* get_header(void* memory) {
+        return reinterpret_cast<AllocationHeader*>(static_cast<char*>(memory) - sizeof(AllocationHeader));
+    }
+
+    static inline void raise_peak(std::atomic<uint64_t>& peak, uint64_t value) {
+        uint64_t current = peak.load(std::memory_order_relaxed);
+        while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    HostAllocator::HostAllocator() {
+        m_callbacks.pUserData = this;
+        m_callbacks.pfnAllocation = _allocation;
+        m_callbacks.pfnReallocation = _reallocation;
+        m_callbacks.pfnFree = _free;
+        m_callbacks.pfnInternalAllocation = _internal_allocation;
+        m_callbacks.pfnInternalFree = _internal_free;
+    }
+
+    HostAllocator::~HostAllocator() {
+        for (void* slab : m_slabs) {
+            std::free(slab);
+        }
+    }
+
+    HostAllocatorStats HostAllocator::get_stats() const {
+        HostAllocatorStats stats{};
+        for (uint32_t i = 0; i < HOST_ALLOCATION_SCOPE_COUNT; i++) {
+            stats.scopes[i].allocations = m_scopes[i].allocations.load(std::memory_order_relaxed);
+            stats.scopes[i].bytes = m_scopes[i].bytes.load(std::memory_order_relaxed);
+            stats.scopes[i].peak_bytes = m_scopes[i].peak_bytes.load(std::memory_order_relaxed);
+            stats.scopes[i].internal_bytes = m_scopes[i].internal_bytes.load(std::memory_order_relaxed);
+            stats.scopes[i].internal_peak_bytes = m_scopes[i].internal_peak_bytes.load(std::memory_order_relaxed);
+        }
+
+        stats.arena_allocations = m_arena_allocations.load(std::memory_order_relaxed);
+        stats.arena_overflows = m_arena_overflows.load(std::memory_order_relaxed);
+        stats.heap_allocations = m_heap_allocations.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(m_pool_mutex);
+        stats.pool_allocations = m_pool_allocations;
+        stats.pool_reuses = m_pool_reuses;
+        stats.slab_bytes = m_slabs.size() * SLAB_SIZE;
+        return stats;
+    }
+
+    void HostAllocator::print_stats() const {
+        HostAllocatorStats stats = get_stats();
+
+        std::cout << "vulkan host allocator stats:\n";
+        for (uint32_t i = 0; i < HOST_ALLOCATION_SCOPE_COUNT; i++) {
+            const HostAllocationScopeStats& scope = stats.scopes[i];
+            std::cout << "\t* " << SCOPE_NAMES[i] << ": " << scope.allocations << " allocations, peak " << scope.peak_bytes
+                << " bytes (internal peak " << scope.internal_peak_bytes << " bytes)";
+            if (scope.bytes > 0) {
+                std::cout << ", " << scope.bytes << " bytes still live";
+            }
+            std::cout << "\n";
+        }
+
+        std::cout << "\t* arena: " << stats.arena_allocations << " allocations, " << stats.arena_overflows << " overflowed\n";
+        std::cout << "\t* pools: " << stats.pool_allocations << " allocations (" << stats.pool_reuses << " reused) from "
+            << stats.slab_bytes << " bytes of slabs\n";
+        std::cout << "\t* heap: " << stats.heap_allocations << " allocations\n";
+    }
+
+    void* VKAPI_CALL HostAllocator::_allocation(void* user_data, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+        return static_cast<HostAllocator*>(user_data)->_allocate(size, alignment, scope);
+    }
+
+    void* VKAPI_CALL HostAllocator::_reallocation(void* user_data, void* original, size_t size, size_t alignment,
+        VkSystemAllocationScope scope) {
+        HostAllocator* allocator = static_cast<HostAllocator*>(user_data);
+        if (original == nullptr) {
+            return allocator->_allocate(size, alignment, scope);
+        }
+
+        if (size == 0) {
+            allocator->_deallocate(original);
+            return nullptr;
+        }
+
+        // on failure the original has to be left untouched
+        void* memory = allocator->_allocate(size, alignment, scope);
+        if (memory == nullptr) {
+            return nullptr;
+        }
+
+        std::memcpy(memory, original, static_cast<size_t>(std::min<uint64_t>(get_header(original)->size, size)));
+        allocator->_deallocate(original);
+        return memory;
+    }
+
+    void VKAPI_CALL HostAllocator::_free(void* user_data, void* memory) {
+        if (memory != nullptr) {
+            static_cast<HostAllocator*>(user_data)->_deallocate(memory);
+        }
+    }
+
+    void VKAPI_CALL HostAllocator::_internal_allocation(void* user_data, size_t size, VkInternalAllocationType,
+        VkSystemAllocationScope scope) {
+        ScopeCounters& counters = static_cast<HostAllocator*>(user_data)->m_scopes[scope];
+        raise_peak(counters.internal_peak_bytes, counters.internal_bytes.fetch_add(size, std::memory_order_relaxed) + size);
+    }
+
+    void VKAPI_CALL HostAllocator::_internal_free(void* user_data, size_t size, VkInternalAllocationType,
+        VkSystemAllocationScope scope) {
+        static_cast<HostAllocator*>(user_data)->m_scopes[scope].internal_bytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    void* HostAllocator::_allocate(size_t size, size_t alignment, VkSystemAllocationScope scope) {
+        if (size == 0) {
+            return nullptr;
+        }
+
+        // enough room to place the header and still align the pointer after it however the block itself is aligned
+        alignment = std::max(alignment, alignof(std::max_align_t));
+        size_t block_size = size + sizeof(AllocationHeader) + alignment - 1;
+
+        char* base = nullptr;
+        BlockKind kind = BlockKind::Heap;
+        uint16_t size_class = 0;
+        CommandArena* owner = nullptr;
+
+        if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+            CommandArena& arena = t_command_arena;
+            if (arena.memory == nullptr) {
+                arena.memory = static_cast<char*>(std::malloc(ARENA_SIZE));
+            }
+
+            // everything may have been freed by other threads since the last allocation
+            if (arena.live.load(std::memory_order_acquire) == 0) {
+                arena.offset = 0;
+            }
+
+            if (arena.memory != nullptr && arena.offset + block_size <= ARENA_SIZE) {
+                base = arena.memory + arena.offset;
+                arena.offset += block_size;
+                arena.live.fetch_add(1, std::memory_order_relaxed);
+                owner = &arena;
+                kind = BlockKind::Arena;
+                m_arena_allocations.fetch_add(1, std::memory_order_relaxed);
+            }
+            else {
+                m_arena_overflows.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        if (base == nullptr && block_size <= MAX_SIZE_CLASS) {
+            while ((MIN_SIZE_CLASS << size_class) < block_size) {
+                size_class++;
+            }
+
+            base = static_cast<char*>(_pool_allocate(size_class));
+            kind = BlockKind::Pool;
+        }
+
+        if (base == nullptr) {
+            base = static_cast<char*>(std::malloc(block_size));
+            if (base == nullptr) {
+                return nullptr;
+            }
+
+            kind = BlockKind::Heap;
+            m_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        uintptr_t address = reinterpret_cast<uintptr_t>(base) + sizeof(AllocationHeader);
+        address = (address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        void* memory = reinterpret_cast<void*>(address);
+
+        AllocationHeader* header = get_header(memory);
+        header->base = base;
+        header->arena = owner;
+        header->size = size;
+        header->scope = static_cast<uint32_t>(scope);
+        header->kind = kind;
+        header->size_class = size_class;
+
+        ScopeCounters& counters = m_scopes[scope];
+        counters.allocations.fetch_add(1, std::memory_order_relaxed);
+        raise_peak(counters.peak_bytes, counters.bytes.fetch_add(size, std::memory_order_relaxed) + size);
+
+        return memory;
+    }
+
+    void HostAllocator::_deallocate(void* memory) {
+        AllocationHeader header = *get_header(memory);
+        m_scopes[header.scope].bytes.fetch_sub(header.size, std::memory_order_relaxed);
+
+        switch (header.kind) {
+            case BlockKind::Arena: {
+                CommandArena* arena = header.arena;
+                if (arena->live.fetch_sub(1, std::memory_order_release) == 1 && arena == &t_command_arena) {
+                    arena->offset = 0;
+                }
+                break;
+            }
+            case BlockKind::Pool:
+                _pool_free(header.base, header.size_class);
+                break;
+            default:
+                std::free(header.base);
+                break;
+        }
+    }
+
+    void* HostAllocator::_pool_allocate(uint32_t size_class) {
+        std::lock_guard<std::mutex> lock(m_pool_mutex);
+        m_pool_allocations++;
+
+        // freed blocks keep the next pointer of their free list in their first bytes
+        if (m_free_lists[size_class] != nullptr) {
+            void* block = m_free_lists[size_class];
+            m_free_lists[size_class] = *static_cast<void**>(block);
+            m_pool_reuses++;
+            return block;
+        }
+
+        // classes share the current slab, whatever is left over when a block doesn't fit is simply abandoned
+        size_t class_size = MIN_SIZE_CLASS << size_class;
+        if (m_slab_remaining < class_size) {
+            void* slab = std::malloc(SLAB_SIZE);
+            if (slab == nullptr) {
+                m_pool_allocations--;
+                return nullptr;
+            }
+
+            m_slabs.push_back(slab);
+            m_slab_cursor = static_cast<char*>(slab);
+            m_slab_remaining = SLAB_SIZE;
+        }
+
+        void* block = m_slab_cursor;
+        m_slab_cursor += class_size;
+        m_slab_remaining -= class_size;
+        return block;
+    }
+
+    void HostAllocator::_pool_free(void* block, uint32_t size_class) {
+        std::lock_guard<std::mutex> lock(m_pool_mutex);
+        *static_cast<void**>(block) = m_free_lists[size_class];
+        m_free_lists[size_class] = block;
+    }
+
+}
@@ -0,0 +1,101 @@
+#ifndef __HOST_ALLOCATOR_HPP__
+#define __HOST_ALLOCATOR_HPP__
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+namespace vlk {
+
+    // VK_SYSTEM_ALLOCATION_SCOPE_COMMAND through VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE
+    constexpr uint32_t HOST_ALLOCATION_SCOPE_COUNT = 5;
+
+    struct HostAllocationScopeStats {
+        uint64_t allocations{ 0 };      // every allocation and reallocation over the allocator's lifetime
+        uint64_t bytes{ 0 };            // bytes currently live, as requested by the driver
+        uint64_t peak_bytes{ 0 };
+        uint64_t internal_bytes{ 0 };   // driver allocations made without these callbacks, only reported to them
+        uint64_t internal_peak_bytes{ 0 };
+    };
+
+    struct HostAllocatorStats {
+        HostAllocationScopeStats scopes[HOST_ALLOCATION_SCOPE_COUNT]{};
+        uint64_t arena_allocations{ 0 };
+        uint64_t arena_overflows{ 0 };  // command scope allocations that didn't fit the thread's arena
+        uint64_t pool_allocations{ 0 };
+        uint64_t pool_reuses{ 0 };      // pool allocations served from a free list rather than a fresh slab
+        uint64_t heap_allocations{ 0 }; // went straight to malloc, too big for any size class
+        uint64_t slab_bytes{ 0 };
+    };
+
+    // VkAllocationCallbacks for every vulkan object the application creates, so driver host memory can be measured and
+    // most of it kept off malloc. command scope allocations only live for the duration of one vulkan call on one thread,
+    // so they are bumped out of a thread local arena that rewinds once everything in it has been freed. everything else
+    // comes from power of two size classes carved out of slabs that are kept until the allocator is destroyed. the
+    // allocator has to outlive every object created with its callbacks, including the instance
+    class HostAllocator {
+    public:
+        static constexpr size_t ARENA_SIZE = 64 * 1024;
+        static constexpr size_t SLAB_SIZE = 64 * 1024;
+        static constexpr size_t MIN_SIZE_CLASS = 32;
+        static constexpr size_t MAX_SIZE_CLASS = 4096;
+
+        HostAllocator();
+        ~HostAllocator();
+
+        inline const VkAllocationCallbacks* get_callbacks() const { return &m_callbacks; }
+        HostAllocatorStats get_stats() const;
+        void print_stats() const;
+
+    private:
+        static constexpr uint32_t SIZE_CLASS_COUNT = 8; // 32 bytes through 4096
+
+        struct ScopeCounters {
+            std::atomic<uint64_t> allocations{ 0 };
+            std::atomic<uint64_t> bytes{ 0 };
+            std::atomic<uint64_t> peak_bytes{ 0 };
+            std::atomic<uint64_t> internal_bytes{ 0 };
+            std::atomic<uint64_t> internal_peak_bytes{ 0 };
+        };
+
+        static VKAPI_ATTR void* VKAPI_CALL _allocation(void* user_data, size_t size, size_t alignment, VkSystemAllocationScope scope);
+        static VKAPI_ATTR void* VKAPI_CALL _reallocation(void* user_data, void* original, size_t size, size_t alignment,
+            VkSystemAllocationScope scope);
+        static VKAPI_ATTR void VKAPI_CALL _free(void* user_data, void* memory);
+        static VKAPI_ATTR void VKAPI_CALL _internal_allocation(void* user_data, size_t size, VkInternalAllocationType type,
+            VkSystemAllocationScope scope);
+        static VKAPI_ATTR void VKAPI_CALL _internal_free(void* user_data, size_t size, VkInternalAllocationType type,
+            VkSystemAllocationScope scope);
+
+        void* _allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+        void _deallocate(void* memory);
+
+        void* _pool_allocate(uint32_t size_class);
+        void _pool_free(void* block, uint32_t size_class);
+
+        HostAllocator(const HostAllocator& other) = delete;
+        HostAllocator& operator=(const HostAllocator& other) = delete;
+
+        VkAllocationCallbacks m_callbacks{};
+        ScopeCounters m_scopes[HOST_ALLOCATION_SCOPE_COUNT]{};
+
+        std::atomic<uint64_t> m_arena_allocations{ 0 };
+        std::atomic<uint64_t> m_arena_overflows{ 0 };
+        std::atomic<uint64_t> m_heap_allocations{ 0 };
+
+        // guards the size classes and their counters
+        mutable std::mutex m_pool_mutex{};
+        void* m_free_lists[SIZE_CLASS_COUNT]{};
+        std::vector<void*> m_slabs{};
+        char* m_slab_cursor{ nullptr };
+        size_t m_slab_remaining{ 0 };
+        uint64_t m_pool_allocations{ 0 };
+        uint64_t m_pool_reuses{ 0 };
+    };
+
+}
+
+#endif // __HOST_ALLOCATOR_HPP__
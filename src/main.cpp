@@ -1,7 +1,7 @@
-#include "application.hpp"
-
-int main() {
-    vlk::Application app{};
-    app.run();
-    return 0;
-}
\ No newline at end of file
+#include "application.hpp"
+
+int main(int argc, char** argv) {
+    vlk::Application app{ vlk::ApplicationOptions::parse(argc, argv) };
+    app.run();
+    return 0;
+}
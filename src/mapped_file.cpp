@@ -0,0 +1,86 @@
+#include "mapped_file.hpp"
+
+#if defined(_WIN32)
+#   define WIN32_LEAN_AND_MEAN
+#   define NOMINMAX
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+namespace vlk {
+
+#if defined(_WIN32)
+    MappedFile::MappedFile(std::string_view path) : m_path(path) {
+        HANDLE file = CreateFileA(m_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+
+        LARGE_INTEGER file_size{};
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+            CloseHandle(file);
+            return;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            CloseHandle(file);
+            return;
+        }
+
+        const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data == nullptr) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return;
+        }
+
+        m_file_handle = file;
+        m_mapping_handle = mapping;
+        m_data = data;
+        m_size = static_cast<size_t>(file_size.QuadPart);
+    }
+
+    MappedFile::~MappedFile() {
+        if (m_data != nullptr) {
+            UnmapViewOfFile(m_data);
+            CloseHandle(static_cast<HANDLE>(m_mapping_handle));
+            CloseHandle(static_cast<HANDLE>(m_file_handle));
+        }
+    }
+#else
+    MappedFile::MappedFile(std::string_view path) : m_path(path) {
+        int file = open(m_path.c_str(), O_RDONLY);
+        if (file < 0) {
+            return;
+        }
+
+        struct stat file_stat{};
+        if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0) {
+            close(file);
+            return;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        close(file); // the mapping keeps its own reference to the file
+
+        if (data == MAP_FAILED) {
+            return;
+        }
+
+        m_data = data;
+        m_size = static_cast<size_t>(file_stat.st_size);
+    }
+
+    MappedFile::~MappedFile() {
+        if (m_data != nullptr) {
+            munmap(const_cast<void*>(m_data), m_size);
+        }
+    }
+#endif
+
+}
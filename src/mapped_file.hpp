@@ -0,0 +1,37 @@
+#ifndef __MAPPED_FILE_HPP__
+#define __MAPPED_FILE_HPP__
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace vlk {
+
+    // read only memory mapping of a whole file, the mapping is released when this goes out of scope
+    class MappedFile {
+    public:
+        MappedFile(std::string_view path);
+        ~MappedFile();
+
+        inline bool is_open() const { return m_data != nullptr; }
+        inline const void* get_data() const { return m_data; }
+        inline size_t get_size() const { return m_size; }
+        inline const std::string& get_path() const { return m_path; }
+
+    private:
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+
+        std::string m_path{};
+        const void* m_data{ nullptr };
+        size_t m_size{ 0 };
+
+#if defined(_WIN32)
+        void* m_file_handle{ nullptr };
+        void* m_mapping_handle{ nullptr };
+#endif
+    };
+
+}
+
+#endif // __MAPPED_FILE_HPP__
@@ -0,0 +1,86 @@
+#include "mesh_buffer.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace vlk {
+
+    VkVertexInputBindingDescription Vertex::get_binding_description() {
+        VkVertexInputBindingDescription binding_description{};
+        binding_description.binding = 0;
+        binding_description.stride = sizeof(Vertex);
+        binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        return binding_description;
+    }
+
+    std::array<VkVertexInputAttributeDescription, 2> Vertex::get_attribute_descriptions() {
+        std::array<VkVertexInputAttributeDescription, 2> attribute_descriptions{};
+
+        attribute_descriptions[0].binding = 0;
+        attribute_descriptions[0].location = 0;
+        attribute_descriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attribute_descriptions[0].offset = offsetof(Vertex, position);
+
+        attribute_descriptions[1].binding = 0;
+        attribute_descriptions[1].location = 1;
+        attribute_descriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attribute_descriptions[1].offset = offsetof(Vertex, color);
+
+        return attribute_descriptions;
+    }
+
+    MeshBuffer::MeshBuffer(VulkanDevice* device, VulkanUploader* uploader, uint32_t vertex_capacity, uint32_t index_capacity)
+        : m_device(device), m_dispatch(&device->get_dispatch()), m_uploader(uploader), m_vertex_capacity(vertex_capacity),
+        m_index_capacity(index_capacity) {
+        VulkanAllocator* allocator = m_device->get_allocator();
+
+        m_vertex_buffer = allocator->create_buffer(static_cast<VkDeviceSize>(m_vertex_capacity) * sizeof(Vertex),
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_vertex_allocation);
+        m_index_buffer = allocator->create_buffer(static_cast<VkDeviceSize>(m_index_capacity) * sizeof(uint32_t),
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_index_allocation);
+
+        std::cout << "successfully created mesh buffers (" << m_vertex_capacity << " vertices, " << m_index_capacity << " indices)\n";
+    }
+
+    MeshBuffer::~MeshBuffer() {
+        m_device->get_allocator()->destroy_buffer(m_index_buffer, m_index_allocation);
+        m_device->get_allocator()->destroy_buffer(m_vertex_buffer, m_vertex_allocation);
+    }
+
+    Mesh MeshBuffer::add_mesh(const Vertex* vertices, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count) {
+        if (m_vertex_count + vertex_count > m_vertex_capacity || m_index_count + index_count > m_index_capacity) {
+            std::cout << "failed to add mesh, the mesh buffer is full\n";
+            std::exit(-1);
+        }
+
+        Mesh mesh{};
+        mesh.first_index = m_index_count;
+        mesh.index_count = index_count;
+        mesh.vertex_offset = static_cast<int32_t>(m_vertex_count);
+
+        for (uint32_t i = 0; i < vertex_count; i++) {
+            const float* position = vertices[i].position;
+            mesh.radius = std::max(mesh.radius, std::sqrt(position[0] * position[0] + position[1] * position[1] + position[2] * position[2]));
+        }
+
+        m_uploader->upload_buffer(m_vertex_buffer, static_cast<VkDeviceSize>(m_vertex_count) * sizeof(Vertex), vertices,
+            static_cast<VkDeviceSize>(vertex_count) * sizeof(Vertex), VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+        m_last_upload = m_uploader->upload_buffer(m_index_buffer, static_cast<VkDeviceSize>(m_index_count) * sizeof(uint32_t), indices,
+            static_cast<VkDeviceSize>(index_count) * sizeof(uint32_t), VK_ACCESS_INDEX_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+
+        m_vertex_count += vertex_count;
+        m_index_count += index_count;
+
+        return mesh;
+    }
+
+    void MeshBuffer::bind(VkCommandBuffer command_buffer) const {
+        VkDeviceSize offset = 0;
+        m_dispatch->vkCmdBindVertexBuffers(command_buffer, 0, 1, &m_vertex_buffer, &offset);
+        m_dispatch->vkCmdBindIndexBuffer(command_buffer, m_index_buffer, 0, VK_INDEX_TYPE_UINT32);
+    }
+
+}
@@ -0,0 +1,75 @@
+#ifndef __MESH_BUFFER_HPP__
+#define __MESH_BUFFER_HPP__
+
+#include "vulkan_device.hpp"
+#include "vulkan_uploader.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace vlk {
+
+    struct Vertex {
+        float position[3]{};
+        float color[3]{};
+
+        static VkVertexInputBindingDescription get_binding_description();
+        static std::array<VkVertexInputAttributeDescription, 2> get_attribute_descriptions();
+    };
+
+    // where a mesh lives inside the shared buffers, these map straight onto VkDrawIndexedIndirectCommand
+    struct Mesh {
+        uint32_t first_index{ 0 };
+        uint32_t index_count{ 0 };
+        int32_t vertex_offset{ 0 };
+        float radius{ 0.0f }; // bounding sphere around the mesh's origin, used for culling
+    };
+
+    // every mesh shares one vertex buffer and one index buffer, so a whole scene is drawn with a single bind and indices
+    // stay relative to their own mesh through vertex_offset. meshes are appended and never freed
+    class MeshBuffer {
+    public:
+        static constexpr uint32_t DEFAULT_VERTEX_CAPACITY = 1u << 20;
+        static constexpr uint32_t DEFAULT_INDEX_CAPACITY = 4u << 20;
+
+        MeshBuffer(VulkanDevice* device, VulkanUploader* uploader, uint32_t vertex_capacity = DEFAULT_VERTEX_CAPACITY,
+            uint32_t index_capacity = DEFAULT_INDEX_CAPACITY);
+        ~MeshBuffer();
+
+        inline VkBuffer get_vertex_buffer() const { return m_vertex_buffer; }
+        inline VkBuffer get_index_buffer() const { return m_index_buffer; }
+        inline uint32_t get_vertex_count() const { return m_vertex_count; }
+        inline uint32_t get_index_count() const { return m_index_count; }
+
+        // the upload covering every mesh added so far, nothing may be drawn before it is complete
+        inline UploadTicket get_last_upload() const { return m_last_upload; }
+
+        // queued on the uploader, so the data can be freed as soon as this returns
+        Mesh add_mesh(const Vertex* vertices, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count);
+
+        void bind(VkCommandBuffer command_buffer) const;
+
+    private:
+        MeshBuffer(const MeshBuffer& other) = delete;
+        MeshBuffer& operator=(const MeshBuffer& other) = delete;
+
+        VulkanDevice* m_device{ nullptr };
+        const VulkanDeviceDispatch* m_dispatch{ nullptr };
+        VulkanUploader* m_uploader{ nullptr };
+
+        VkBuffer m_vertex_buffer{ nullptr };
+        VulkanAllocation m_vertex_allocation{};
+        uint32_t m_vertex_capacity{ 0 };
+        uint32_t m_vertex_count{ 0 };
+
+        VkBuffer m_index_buffer{ nullptr };
+        VulkanAllocation m_index_allocation{};
+        uint32_t m_index_capacity{ 0 };
+        uint32_t m_index_count{ 0 };
+
+        UploadTicket m_last_upload{};
+    };
+
+}
+
+#endif // __MESH_BUFFER_HPP__
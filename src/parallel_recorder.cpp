@@ -0,0 +1,115 @@
+#include "parallel_recorder.hpp"
+#include "profiler.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+namespace vlk {
+
+    ParallelRecorder::ParallelRecorder(VulkanDevice* device, ThreadPool* thread_pool, uint32_t frames_in_flight)
+        : m_device(device), m_dispatch(&device->get_dispatch()), m_thread_pool(thread_pool), m_frames_in_flight(frames_in_flight) {
+        _init_command_pools();
+    }
+
+    ParallelRecorder::~ParallelRecorder() {
+        // destroying a pool frees every command buffer allocated from it
+        for (WorkerFrame& frame : m_worker_frames) {
+            vkDestroyCommandPool(m_device->get_device(), frame.command_pool, m_device->get_allocation_callbacks());
+        }
+    }
+
+    void ParallelRecorder::record(Renderer* renderer, VkCommandBuffer primary, uint32_t draw_count, const RecordSlice& record_slice) {
+        if (draw_count == 0) {
+            return;
+        }
+
+        uint32_t slice_count = (draw_count + MIN_DRAWS_PER_SLICE - 1) / MIN_DRAWS_PER_SLICE;
+        slice_count = std::min(slice_count, m_thread_pool->get_thread_count());
+        m_slices.assign(slice_count, nullptr);
+
+        const VkCommandBufferInheritanceInfo inheritance_info = renderer->get_inheritance_info();
+        const uint32_t frame_index = renderer->get_frame_index();
+        const uint64_t frame_number = renderer->get_frame_number();
+
+        // worker i always records slice i into its own pool, the renderer has already waited on this frame's timeline value
+        // so nothing recorded from these pools last time around is still in use by the gpu
+        m_thread_pool->run_on_workers(slice_count, [&](uint32_t worker_index) {
+            VLK_PROFILE_SCOPE("ParallelRecorder::record_slice");
+
+            WorkerFrame& frame = m_worker_frames[worker_index * m_frames_in_flight + frame_index];
+            VkCommandBuffer command_buffer = _next_command_buffer(frame, frame_number);
+
+            VkCommandBufferBeginInfo begin_info{};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            begin_info.pInheritanceInfo = &inheritance_info;
+
+            if (m_dispatch->vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+                std::cout << "failed to begin secondary command buffer\n";
+                std::exit(-1);
+            }
+
+            renderer->set_viewport_and_scissor(command_buffer);
+
+            uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(draw_count) * worker_index / slice_count);
+            uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(draw_count) * (worker_index + 1) / slice_count);
+            record_slice(command_buffer, begin, end);
+
+            if (m_dispatch->vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+                std::cout << "failed to record secondary command buffer\n";
+                std::exit(-1);
+            }
+
+            m_slices[worker_index] = command_buffer;
+        });
+
+        m_dispatch->vkCmdExecuteCommands(primary, slice_count, m_slices.data());
+    }
+
+    VkCommandBuffer ParallelRecorder::_next_command_buffer(WorkerFrame& frame, uint64_t frame_number) {
+        // first use this frame, recycle everything the pool handed out last time instead of freeing it
+        if (frame.reset_frame_number != frame_number) {
+            m_dispatch->vkResetCommandPool(m_device->get_device(), frame.command_pool, 0);
+            frame.reset_frame_number = frame_number;
+            frame.used = 0;
+        }
+
+        if (frame.used == frame.command_buffers.size()) {
+            VkCommandBufferAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.commandPool = frame.command_pool;
+            allocate_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocate_info.commandBufferCount = 1;
+
+            VkCommandBuffer command_buffer = nullptr;
+            if (vkAllocateCommandBuffers(m_device->get_device(), &allocate_info, &command_buffer) != VK_SUCCESS) {
+                std::cout << "failed to allocate secondary command buffer\n";
+                std::exit(-1);
+            }
+
+            frame.command_buffers.push_back(command_buffer);
+        }
+
+        return frame.command_buffers[frame.used++];
+    }
+
+    void ParallelRecorder::_init_command_pools() {
+        m_worker_frames.resize(m_thread_pool->get_thread_count() * m_frames_in_flight);
+
+        // transient since everything recorded is thrown away when the pool is reset a couple of frames later
+        VkCommandPoolCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        create_info.queueFamilyIndex = m_device->get_queue_family_indices().graphics_family.value();
+
+        for (WorkerFrame& frame : m_worker_frames) {
+            if (vkCreateCommandPool(m_device->get_device(), &create_info, m_device->get_allocation_callbacks(), &frame.command_pool) != VK_SUCCESS) {
+                std::cout << "failed to create worker command pool\n";
+                std::exit(-1);
+            }
+        }
+
+        std::cout << "successfully created " << m_worker_frames.size() << " worker command pools\n";
+    }
+
+}
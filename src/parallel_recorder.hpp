@@ -0,0 +1,54 @@
+#ifndef __PARALLEL_RECORDER_HPP__
+#define __PARALLEL_RECORDER_HPP__
+
+#include "vulkan_device.hpp"
+#include "renderer.hpp"
+#include "thread_pool.hpp"
+
+#include <vector>
+#include <functional>
+
+namespace vlk {
+
+    // splits a draw list into contiguous slices, records each slice into a secondary command buffer on its own worker and
+    // executes them from the primary in slice order, so the result doesn't depend on which worker finished first
+    class ParallelRecorder {
+    public:
+        // below this many draws a slice isn't worth the cost of waking another worker
+        static constexpr uint32_t MIN_DRAWS_PER_SLICE = 256;
+
+        // records draws [begin, end) into command_buffer, pipeline and viewport state are already set
+        using RecordSlice = std::function<void(VkCommandBuffer command_buffer, uint32_t begin, uint32_t end)>;
+
+        ParallelRecorder(VulkanDevice* device, ThreadPool* thread_pool, uint32_t frames_in_flight);
+        ~ParallelRecorder();
+
+        // must be called inside a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+        void record(Renderer* renderer, VkCommandBuffer primary, uint32_t draw_count, const RecordSlice& record_slice);
+
+    private:
+        // only ever touched by the worker that owns it, so no locking is needed around the pool
+        struct WorkerFrame {
+            VkCommandPool command_pool{ nullptr };
+            std::vector<VkCommandBuffer> command_buffers{};
+            uint32_t used{ 0 };
+            uint64_t reset_frame_number{ UINT64_MAX };
+        };
+
+        void _init_command_pools();
+        VkCommandBuffer _next_command_buffer(WorkerFrame& frame, uint64_t frame_number);
+
+        ParallelRecorder(const ParallelRecorder& other) = delete;
+        ParallelRecorder& operator=(const ParallelRecorder& other) = delete;
+
+        VulkanDevice* m_device{ nullptr };
+        const VulkanDeviceDispatch* m_dispatch{ nullptr };
+        ThreadPool* m_thread_pool{ nullptr };
+        uint32_t m_frames_in_flight{ 0 };
+        std::vector<WorkerFrame> m_worker_frames{}; // [worker * frames_in_flight + frame_index]
+        std::vector<VkCommandBuffer> m_slices{};
+    };
+
+}
+
+#endif // __PARALLEL_RECORDER_HPP__
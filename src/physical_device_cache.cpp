@@ -0,0 +1,232 @@
+#include "physical_device_cache.hpp"
+#include "mapped_file.hpp"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <filesystem>
+
+namespace vlk {
+
+    static constexpr uint32_t CACHE_MAGIC = 0x50444B56; // "VKDP"
+    static constexpr uint32_t CACHE_VERSION = 1;
+
+    // the struct sizes go in the header so a file written against different vulkan headers is thrown away rather than
+    // read back misaligned
+    struct CacheHeader {
+        uint32_t magic{ CACHE_MAGIC };
+        uint32_t version{ CACHE_VERSION };
+        uint32_t features_size{ sizeof(VkPhysicalDeviceFeatures) };
+        uint32_t memory_properties_size{ sizeof(VkPhysicalDeviceMemoryProperties) };
+        uint32_t queue_family_size{ sizeof(VkQueueFamilyProperties) };
+        uint32_t extension_size{ sizeof(VkExtensionProperties) };
+        uint32_t entry_count{ 0 };
+    };
+
+    // bounds checked reads over the mapped file, any short read marks the whole file as bad
+    struct CacheReader {
+        const uint8_t* data{ nullptr };
+        size_t size{ 0 };
+        size_t offset{ 0 };
+        bool failed{ false };
+
+        void read(void* destination, size_t bytes) {
+            if (failed || size - offset < bytes) {
+                failed = true;
+                return;
+            }
+
+            std::memcpy(destination, data + offset, bytes);
+            offset += bytes;
+        }
+
+        template<typename T>
+        void read_vector(std::vector<T>& values) {
+            uint32_t count = 0;
+            read(&count, sizeof(count));
+            if (failed || (size - offset) / sizeof(T) < count) {
+                failed = true;
+                return;
+            }
+
+            values.resize(count);
+            read(values.data(), count * sizeof(T));
+        }
+    };
+
+    template<typename T>
+    static void write_vector(std::vector<uint8_t>& out, const std::vector<T>& values) {
+        uint32_t count = static_cast<uint32_t>(values.size());
+        const uint8_t* count_bytes = reinterpret_cast<const uint8_t*>(&count);
+        const uint8_t* value_bytes = reinterpret_cast<const uint8_t*>(values.data());
+
+        out.insert(out.end(), count_bytes, count_bytes + sizeof(count));
+        out.insert(out.end(), value_bytes, value_bytes + values.size() * sizeof(T));
+    }
+
+    template<typename T>
+    static void write_value(std::vector<uint8_t>& out, const T& value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    bool PhysicalDeviceCache::Entry::matches(const VkPhysicalDeviceProperties& properties) const {
+        return vendor_id == properties.vendorID && device_id == properties.deviceID && driver_version == properties.driverVersion &&
+            api_version == properties.apiVersion && std::memcmp(uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    PhysicalDeviceCache::PhysicalDeviceCache(std::string path) : m_path(std::move(path)) {
+        _load();
+    }
+
+    PhysicalDeviceCapabilities PhysicalDeviceCache::query(VkPhysicalDevice physical_device) {
+        PhysicalDeviceCapabilities capabilities{};
+        capabilities.physical_device = physical_device;
+        vkGetPhysicalDeviceProperties(physical_device, &capabilities.properties);
+
+        for (const Entry& entry : m_entries) {
+            if (entry.matches(capabilities.properties)) {
+                capabilities.features = entry.features;
+                capabilities.memory_properties = entry.memory_properties;
+                capabilities.queue_families = entry.queue_families;
+                capabilities.extensions = entry.extensions;
+
+                m_hits++;
+                return capabilities;
+            }
+        }
+
+        vkGetPhysicalDeviceFeatures(physical_device, &capabilities.features);
+        vkGetPhysicalDeviceMemoryProperties(physical_device, &capabilities.memory_properties);
+
+        uint32_t queue_family_count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+        capabilities.queue_families.resize(queue_family_count);
+        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, capabilities.queue_families.data());
+
+        uint32_t extension_count = 0;
+        vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr);
+        capabilities.extensions.resize(extension_count);
+        vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, capabilities.extensions.data());
+
+        Entry entry{};
+        entry.vendor_id = capabilities.properties.vendorID;
+        entry.device_id = capabilities.properties.deviceID;
+        entry.driver_version = capabilities.properties.driverVersion;
+        entry.api_version = capabilities.properties.apiVersion;
+        std::memcpy(entry.uuid, capabilities.properties.pipelineCacheUUID, VK_UUID_SIZE);
+        entry.features = capabilities.features;
+        entry.memory_properties = capabilities.memory_properties;
+        entry.queue_families = capabilities.queue_families;
+        entry.extensions = capabilities.extensions;
+
+        // an older entry for the same device is from a previous driver and will never match again
+        for (size_t i = 0; i < m_entries.size(); i++) {
+            if (m_entries[i].vendor_id == entry.vendor_id && m_entries[i].device_id == entry.device_id) {
+                m_entries.erase(m_entries.begin() + i);
+                break;
+            }
+        }
+        m_entries.push_back(std::move(entry));
+
+        m_misses++;
+        return capabilities;
+    }
+
+    bool PhysicalDeviceCache::save() {
+        if (m_misses == 0) {
+            return true;
+        }
+
+        CacheHeader header{};
+        header.entry_count = static_cast<uint32_t>(m_entries.size());
+
+        std::vector<uint8_t> data{};
+        write_value(data, header);
+        for (const Entry& entry : m_entries) {
+            write_value(data, entry.vendor_id);
+            write_value(data, entry.device_id);
+            write_value(data, entry.driver_version);
+            write_value(data, entry.api_version);
+            write_value(data, entry.uuid);
+            write_value(data, entry.features);
+            write_value(data, entry.memory_properties);
+            write_vector(data, entry.queue_families);
+            write_vector(data, entry.extensions);
+        }
+
+        std::string temporary_path = m_path + ".tmp";
+        std::FILE* file = std::fopen(temporary_path.c_str(), "wb");
+        if (file == nullptr) {
+            std::cout << "failed to open \"" << temporary_path << "\" to write the physical device cache\n";
+            return false;
+        }
+
+        bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+        written = std::fflush(file) == 0 && written;
+        std::fclose(file);
+
+        std::error_code error{};
+        if (!written) {
+            std::cout << "failed to write physical device cache to \"" << temporary_path << "\"\n";
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+
+        std::filesystem::rename(temporary_path, m_path, error);
+        if (error) {
+            std::cout << "failed to replace physical device cache \"" << m_path << "\": " << error.message() << "\n";
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    void PhysicalDeviceCache::_load() {
+        MappedFile file(m_path);
+        if (!file.is_open()) {
+            return;
+        }
+
+        CacheReader reader{};
+        reader.data = static_cast<const uint8_t*>(file.get_data());
+        reader.size = file.get_size();
+
+        CacheHeader expected{};
+        CacheHeader header{};
+        reader.read(&header, sizeof(header));
+        if (reader.failed || std::memcmp(&header, &expected, offsetof(CacheHeader, entry_count)) != 0) {
+            std::cout << "physical device cache \"" << m_path << "\" is from a different build, ignoring it\n";
+            return;
+        }
+
+        // every entry holds at least the features, anything claiming more entries than that is corrupt
+        if (header.entry_count > reader.size / sizeof(VkPhysicalDeviceFeatures)) {
+            std::cout << "physical device cache \"" << m_path << "\" is corrupt, ignoring it\n";
+            return;
+        }
+
+        std::vector<Entry> entries(header.entry_count);
+        for (Entry& entry : entries) {
+            reader.read(&entry.vendor_id, sizeof(entry.vendor_id));
+            reader.read(&entry.device_id, sizeof(entry.device_id));
+            reader.read(&entry.driver_version, sizeof(entry.driver_version));
+            reader.read(&entry.api_version, sizeof(entry.api_version));
+            reader.read(entry.uuid, sizeof(entry.uuid));
+            reader.read(&entry.features, sizeof(entry.features));
+            reader.read(&entry.memory_properties, sizeof(entry.memory_properties));
+            reader.read_vector(entry.queue_families);
+            reader.read_vector(entry.extensions);
+        }
+
+        if (reader.failed) {
+            std::cout << "physical device cache \"" << m_path << "\" is truncated, ignoring it\n";
+            return;
+        }
+
+        m_entries = std::move(entries);
+    }
+
+}
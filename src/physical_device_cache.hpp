@@ -0,0 +1,59 @@
+#ifndef __PHYSICAL_DEVICE_CACHE_HPP__
+#define __PHYSICAL_DEVICE_CACHE_HPP__
+
+#include "vulkan_device.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace vlk {
+
+    // keeps the surface independent part of each PhysicalDeviceCapabilities on disk, so the next launch can skip the
+    // feature, memory, queue family and extension queries. entries are keyed on the device, driver version and pipeline
+    // cache uuid, so a driver update simply misses and gets queried again
+    class PhysicalDeviceCache {
+    public:
+        static constexpr const char* DEFAULT_PATH = "physical_device_cache.bin";
+
+        PhysicalDeviceCache(std::string path);
+
+        inline uint32_t get_hits() const { return m_hits; }
+        inline uint32_t get_misses() const { return m_misses; }
+
+        // properties are always queried live, they are what the cache is keyed on
+        PhysicalDeviceCapabilities query(VkPhysicalDevice physical_device);
+
+        // only writes when something was missed, same temporary file and rename as the pipeline cache
+        bool save();
+
+    private:
+        struct Entry {
+            uint32_t vendor_id{ 0 };
+            uint32_t device_id{ 0 };
+            uint32_t driver_version{ 0 };
+            uint32_t api_version{ 0 };
+            uint8_t uuid[VK_UUID_SIZE]{};
+
+            VkPhysicalDeviceFeatures features{};
+            VkPhysicalDeviceMemoryProperties memory_properties{};
+            std::vector<VkQueueFamilyProperties> queue_families{};
+            std::vector<VkExtensionProperties> extensions{};
+
+            bool matches(const VkPhysicalDeviceProperties& properties) const;
+        };
+
+        void _load();
+
+        PhysicalDeviceCache(const PhysicalDeviceCache& other) = delete;
+        PhysicalDeviceCache& operator=(const PhysicalDeviceCache& other) = delete;
+
+        std::string m_path{};
+        std::vector<Entry> m_entries{};
+        uint32_t m_hits{ 0 };
+        uint32_t m_misses{ 0 };
+    };
+
+}
+
+#endif // __PHYSICAL_DEVICE_CACHE_HPP__
@@ -0,0 +1,300 @@
+#include "profiler.hpp"
+#include "vulkan_device.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstdio>
+
+namespace vlk {
+
+    void write_json_string(std::ostream& out, const char* string) {
+        out << '"';
+        for (const char* c = string; *c != '\0'; c++) {
+            unsigned char character = static_cast<unsigned char>(*c);
+            if (character < 0x20) {
+                // json strings can't hold raw control characters, a name with a newline would break the whole trace
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+                out << escaped;
+                continue;
+            }
+
+            if (*c == '"' || *c == '\\') {
+                out << '\\';
+            }
+            out << *c;
+        }
+        out << '"';
+    }
+
+    Profiler& Profiler::get() {
+        static Profiler profiler{};
+        return profiler;
+    }
+
+    Profiler::~Profiler() {
+        end_session();
+    }
+
+    void Profiler::begin_session(const std::string& path) {
+        if (!is_compiled_in()) {
+            std::cout << "built without the profiler, ignoring trace output " << path << "\n";
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_path = path;
+        m_events.clear();
+        m_start = std::chrono::steady_clock::now();
+        m_active.store(true, std::memory_order_relaxed);
+    }
+
+    void Profiler::end_session() {
+        if (!m_active.exchange(false)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_path.empty()) {
+            return;
+        }
+
+        std::ofstream file(m_path, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cout << "failed to open trace output " << m_path << "\n";
+            return;
+        }
+
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+        bool first = true;
+        for (const std::pair<uint32_t, std::string>& thread_name : m_thread_names) {
+            file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread_name.first
+                << ",\"args\":{\"name\":";
+            write_json_string(file, thread_name.second.c_str());
+            file << "}}";
+            first = false;
+        }
+
+        for (const TraceEvent& event : m_events) {
+            file << (first ? "" : ",\n") << "{\"name\":";
+            write_json_string(file, event.name);
+            file << ",\"cat\":";
+            write_json_string(file, event.category);
+            file << ",\"ph\":\"X\",\"ts\":" << event.start_us << ",\"dur\":" << event.duration_us << ",\"pid\":0,\"tid\":"
+                << event.thread_id << "}";
+            first = false;
+        }
+
+        file << "\n]}\n";
+
+        std::cout << "wrote " << m_events.size() << " trace events to " << m_path << "\n";
+        m_events.clear();
+    }
+
+    std::vector<TraceEvent> Profiler::take_events() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::vector<TraceEvent> events{};
+        events.swap(m_events);
+        return events;
+    }
+
+    double Profiler::now_us() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+    uint32_t Profiler::get_thread_id() {
+        // small sequential ids read better in the trace viewer than hashed std::thread::ids
+        thread_local uint32_t thread_id = m_next_thread_id.fetch_add(1, std::memory_order_relaxed);
+        return thread_id;
+    }
+
+    void Profiler::set_thread_name(const char* name) {
+        set_thread_name(get_thread_id(), name);
+    }
+
+    void Profiler::set_thread_name(uint32_t thread_id, const char* name) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_thread_names.emplace_back(thread_id, name);
+    }
+
+    void Profiler::add_event(const TraceEvent& event) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_events.push_back(event);
+    }
+
+    ProfileScope::ProfileScope(const char* name, const char* category) : m_name(name), m_category(category) {
+        Profiler& profiler = Profiler::get();
+        if (profiler.is_active()) {
+            m_start_us = profiler.now_us();
+        }
+    }
+
+    ProfileScope::~ProfileScope() {
+        // a scope that started before the session began is dropped rather than reported with a bogus start
+        Profiler& profiler = Profiler::get();
+        if (m_start_us < 0.0 || !profiler.is_active()) {
+            return;
+        }
+
+        TraceEvent event{};
+        event.name = m_name;
+        event.category = m_category;
+        event.start_us = m_start_us;
+        event.duration_us = profiler.now_us() - m_start_us;
+        event.thread_id = profiler.get_thread_id();
+        profiler.add_event(event);
+    }
+
+    GpuProfiler::GpuProfiler(VulkanDevice* device, uint32_t frames_in_flight) : m_device(device), m_dispatch(&device->get_dispatch()) {
+        _init_query_pools(frames_in_flight);
+    }
+
+    GpuProfiler::~GpuProfiler() {
+        for (FrameQueries& frame : m_frames) {
+            vkDestroyQueryPool(m_device->get_device(), frame.query_pool, m_device->get_allocation_callbacks());
+        }
+    }
+
+    void GpuProfiler::begin_frame(VkCommandBuffer command_buffer, uint32_t frame_index) {
+        if (!is_supported()) {
+            return;
+        }
+
+        FrameQueries& frame = m_frames[frame_index];
+        _collect(frame);
+
+        // the reset has to be recorded outside of a render pass, before any of this frame's timestamps
+        m_dispatch->vkCmdResetQueryPool(command_buffer, frame.query_pool, 0, MAX_ZONES_PER_FRAME * 2);
+        frame.cpu_begin_us = Profiler::get().now_us();
+        m_current_frame = &frame;
+    }
+
+    void GpuProfiler::begin_zone(VkCommandBuffer command_buffer, const char* name) {
+        if (m_current_frame == nullptr) {
+            return;
+        }
+
+        FrameQueries& frame = *m_current_frame;
+
+        // out of queries, keep the nesting balanced so end_zone still pops the right thing
+        if (frame.query_count + 2 > MAX_ZONES_PER_FRAME * 2) {
+            frame.open_zones.push_back(UINT32_MAX);
+            return;
+        }
+
+        Zone zone{};
+        zone.name = name;
+        zone.begin_query = frame.query_count++;
+        zone.end_query = frame.query_count++;
+
+        m_dispatch->vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.query_pool, zone.begin_query);
+
+        frame.open_zones.push_back(static_cast<uint32_t>(frame.zones.size()));
+        frame.zones.push_back(zone);
+    }
+
+    void GpuProfiler::end_zone(VkCommandBuffer command_buffer) {
+        if (m_current_frame == nullptr || m_current_frame->open_zones.empty()) {
+            return;
+        }
+
+        FrameQueries& frame = *m_current_frame;
+        uint32_t zone_index = frame.open_zones.back();
+        frame.open_zones.pop_back();
+
+        if (zone_index != UINT32_MAX) {
+            m_dispatch->vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.query_pool, frame.zones[zone_index].end_query);
+        }
+    }
+
+    void GpuProfiler::collect_all() {
+        for (FrameQueries& frame : m_frames) {
+            _collect(frame);
+        }
+        m_current_frame = nullptr;
+    }
+
+    void GpuProfiler::_collect(FrameQueries& frame) {
+        if (frame.query_count == 0) {
+            return;
+        }
+
+        // no wait bit, the frame's timeline value has already been waited on. if the results somehow aren't there the frame is
+        // dropped from the trace rather than stalling the cpu
+        VkResult result = m_dispatch->vkGetQueryPoolResults(m_device->get_device(), frame.query_pool, 0, frame.query_count,
+            frame.query_count * sizeof(uint64_t), m_results.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+        Profiler& profiler = Profiler::get();
+        if (result == VK_SUCCESS && profiler.is_active()) {
+            // there is no shared clock between the cpu and gpu without VK_EXT_calibrated_timestamps, so the first zone is
+            // lined up with when the frame started recording. durations and gaps within a frame are still exact
+            uint64_t origin = m_results[frame.zones.front().begin_query];
+
+            for (const Zone& zone : frame.zones) {
+                uint64_t begin = m_results[zone.begin_query];
+                uint64_t end = m_results[zone.end_query];
+
+                TraceEvent event{};
+                event.name = zone.name;
+                event.category = "gpu";
+                event.start_us = frame.cpu_begin_us + static_cast<double>((begin - origin) & m_timestamp_mask) * m_timestamp_period_ns / 1000.0;
+                event.duration_us = static_cast<double>((end - begin) & m_timestamp_mask) * m_timestamp_period_ns / 1000.0;
+                event.thread_id = Profiler::GPU_THREAD_ID;
+                profiler.add_event(event);
+            }
+        }
+
+        frame.zones.clear();
+        frame.open_zones.clear();
+        frame.query_count = 0;
+    }
+
+    GpuProfileScope::GpuProfileScope(GpuProfiler* profiler, VkCommandBuffer command_buffer, const char* name)
+        : m_profiler(profiler), m_command_buffer(command_buffer) {
+        if (m_profiler != nullptr) {
+            m_profiler->begin_zone(m_command_buffer, name);
+        }
+    }
+
+    GpuProfileScope::~GpuProfileScope() {
+        if (m_profiler != nullptr) {
+            m_profiler->end_zone(m_command_buffer);
+        }
+    }
+
+    void GpuProfiler::_init_query_pools(uint32_t frames_in_flight) {
+        // timestamps are only meaningful if the graphics queue family actually writes them
+        const PhysicalDeviceCapabilities& capabilities = m_device->get_physical_device_capabilities();
+        uint32_t graphics_family = capabilities.queue_family_indices.graphics_family.value();
+        uint32_t valid_bits = capabilities.queue_families[graphics_family].timestampValidBits;
+        if (valid_bits == 0) {
+            std::cout << "graphics queue doesn't support timestamps, gpu zones won't be traced\n";
+            return;
+        }
+
+        m_timestamp_mask = valid_bits >= 64 ? UINT64_MAX : (uint64_t(1) << valid_bits) - 1;
+        m_timestamp_period_ns = capabilities.properties.limits.timestampPeriod;
+        m_results.resize(MAX_ZONES_PER_FRAME * 2);
+
+        VkQueryPoolCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        create_info.queryCount = MAX_ZONES_PER_FRAME * 2;
+
+        m_frames.resize(frames_in_flight);
+        for (FrameQueries& frame : m_frames) {
+            if (vkCreateQueryPool(m_device->get_device(), &create_info, m_device->get_allocation_callbacks(), &frame.query_pool) != VK_SUCCESS) {
+                std::cout << "failed to create timestamp query pool\n";
+                std::exit(-1);
+            }
+        }
+
+        Profiler::get().set_thread_name(Profiler::GPU_THREAD_ID, "gpu");
+        std::cout << "successfully created gpu profiler query pools\n";
+    }
+
+}
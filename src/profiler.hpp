@@ -0,0 +1,176 @@
+#ifndef __PROFILER_HPP__
+#define __PROFILER_HPP__
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <string>
+#include <iosfwd>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace vlk {
+
+    class VulkanDevice;
+
+    // a single complete ("ph":"X") event in the chrome trace format, times are microseconds since the session started
+    struct TraceEvent {
+        const char* name{ nullptr };
+        const char* category{ nullptr };
+        double start_us{ 0.0 };
+        double duration_us{ 0.0 };
+        uint32_t thread_id{ 0 };
+    };
+
+    // writes string as a quoted json string, escaping quotes, backslashes and control characters
+    void write_json_string(std::ostream& out, const char* string);
+
+    // collects cpu and gpu scopes from every thread and writes them out as chrome trace json, which perfetto and
+    // chrome://tracing can open. names must be string literals or otherwise outlive the session
+    class Profiler {
+    public:
+        // gpu zones show up as their own track in the trace
+        static constexpr uint32_t GPU_THREAD_ID = 0xFFFF;
+
+        static Profiler& get();
+
+        static constexpr bool is_compiled_in() {
+#if defined(VLK_ENABLE_PROFILER)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        // scopes are dropped unless a session is active, so a build with the profiler compiled in costs one atomic load
+        // per scope until --trace is passed
+        inline bool is_active() const { return m_active.load(std::memory_order_relaxed); }
+
+        // an empty path keeps the events in memory for take_events instead of writing a file
+        void begin_session(const std::string& path);
+        void end_session();
+        std::vector<TraceEvent> take_events();
+
+        double now_us() const;
+        uint32_t get_thread_id();
+        // names the calling thread, or any track such as GPU_THREAD_ID
+        void set_thread_name(const char* name);
+        void set_thread_name(uint32_t thread_id, const char* name);
+
+        void add_event(const TraceEvent& event);
+
+    private:
+        Profiler() = default;
+        ~Profiler();
+
+        Profiler(const Profiler& other) = delete;
+        Profiler& operator=(const Profiler& other) = delete;
+
+        std::string m_path{};
+        std::atomic<bool> m_active{ false };
+        std::chrono::steady_clock::time_point m_start{};
+        std::atomic<uint32_t> m_next_thread_id{ 0 };
+
+        std::mutex m_mutex{};
+        std::vector<TraceEvent> m_events{};
+        std::vector<std::pair<uint32_t, std::string>> m_thread_names{};
+    };
+
+    class ProfileScope {
+    public:
+        ProfileScope(const char* name, const char* category = "cpu");
+        ~ProfileScope();
+
+    private:
+        ProfileScope(const ProfileScope& other) = delete;
+        ProfileScope& operator=(const ProfileScope& other) = delete;
+
+        const char* m_name{ nullptr };
+        const char* m_category{ nullptr };
+        double m_start_us{ -1.0 };
+    };
+
+    // timestamp queries written into one query pool per frame in flight. a pool is only read back once the renderer has
+    // waited on that frame's timeline value, so vkGetQueryPoolResults never has to block
+    class GpuProfiler {
+    public:
+        static constexpr uint32_t MAX_ZONES_PER_FRAME = 64;
+
+        GpuProfiler(VulkanDevice* device, uint32_t frames_in_flight);
+        ~GpuProfiler();
+
+        inline bool is_supported() const { return m_timestamp_period_ns > 0.0; }
+
+        // reads back what frame_index recorded last time around and resets its pool, call right after
+        // Renderer::begin_frame, which has already waited on the frame's timeline value
+        void begin_frame(VkCommandBuffer command_buffer, uint32_t frame_index);
+
+        // timestamps are written at bottom of pipe for both ends so the zone covers all work recorded between them.
+        // zones may nest but can't be opened inside a render pass that only executes secondary command buffers
+        void begin_zone(VkCommandBuffer command_buffer, const char* name);
+        void end_zone(VkCommandBuffer command_buffer);
+
+        // reads back every frame still pending, the device must be idle
+        void collect_all();
+
+    private:
+        struct Zone {
+            const char* name{ nullptr };
+            uint32_t begin_query{ 0 };
+            uint32_t end_query{ 0 };
+        };
+
+        struct FrameQueries {
+            VkQueryPool query_pool{ nullptr };
+            std::vector<Zone> zones{};
+            std::vector<uint32_t> open_zones{};
+            uint32_t query_count{ 0 };
+            double cpu_begin_us{ 0.0 };
+        };
+
+        void _init_query_pools(uint32_t frames_in_flight);
+        void _collect(FrameQueries& frame);
+
+        GpuProfiler(const GpuProfiler& other) = delete;
+        GpuProfiler& operator=(const GpuProfiler& other) = delete;
+
+        VulkanDevice* m_device{ nullptr };
+        const VulkanDeviceDispatch* m_dispatch{ nullptr };
+        std::vector<FrameQueries> m_frames{};
+        FrameQueries* m_current_frame{ nullptr };
+        double m_timestamp_period_ns{ 0.0 };
+        uint64_t m_timestamp_mask{ 0 };
+        std::vector<uint64_t> m_results{};
+    };
+
+    class GpuProfileScope {
+    public:
+        GpuProfileScope(GpuProfiler* profiler, VkCommandBuffer command_buffer, const char* name);
+        ~GpuProfileScope();
+
+    private:
+        GpuProfileScope(const GpuProfileScope& other) = delete;
+        GpuProfileScope& operator=(const GpuProfileScope& other) = delete;
+
+        GpuProfiler* m_profiler{ nullptr };
+        VkCommandBuffer m_command_buffer{ nullptr };
+    };
+
+}
+
+#define VLK_PROFILE_CONCAT_INNER(a, b) a##b
+#define VLK_PROFILE_CONCAT(a, b) VLK_PROFILE_CONCAT_INNER(a, b)
+
+// compiled out entirely unless the build sets VLK_ENABLE_PROFILER, see the LEARNING_VULKAN_PROFILER cmake option
+#if defined(VLK_ENABLE_PROFILER)
+#define VLK_PROFILE_SCOPE(name) ::vlk::ProfileScope VLK_PROFILE_CONCAT(_vlk_profile_scope_, __LINE__)(name)
+#define VLK_PROFILE_GPU_SCOPE(profiler, command_buffer, name) \
+    ::vlk::GpuProfileScope VLK_PROFILE_CONCAT(_vlk_gpu_profile_scope_, __LINE__)(profiler, command_buffer, name)
+#else
+#define VLK_PROFILE_SCOPE(name) ((void)0)
+#define VLK_PROFILE_GPU_SCOPE(profiler, command_buffer, name) ((void)0)
+#endif
+
+#endif // __PROFILER_HPP__
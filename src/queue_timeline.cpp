@@ -0,0 +1,147 @@
+#include "queue_timeline.hpp"
+#include "profiler.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <limits>
+
+namespace vlk {
+
+    QueueTimeline::QueueTimeline(VkDevice device, const VkAllocationCallbacks* allocation_callbacks, const VulkanDeviceDispatch* dispatch,
+        VkQueue queue) : m_device(device), m_allocation_callbacks(allocation_callbacks), m_dispatch(dispatch), m_queue(queue) {
+        VkSemaphoreTypeCreateInfo type_create_info{};
+        type_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        type_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        type_create_info.initialValue = 0;
+
+        VkSemaphoreCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        create_info.pNext = &type_create_info;
+
+        if (vkCreateSemaphore(m_device, &create_info, m_allocation_callbacks, &m_semaphore) != VK_SUCCESS) {
+            std::cout << "failed to create queue timeline semaphore\n";
+            std::exit(-1);
+        }
+    }
+
+    QueueTimeline::~QueueTimeline() {
+        vkDestroySemaphore(m_device, m_semaphore, m_allocation_callbacks);
+    }
+
+    uint64_t QueueTimeline::get_submitted_value() const {
+        std::lock_guard<std::mutex> lock(m_submit_mutex);
+        return m_submitted_value;
+    }
+
+    uint64_t QueueTimeline::get_completed_value() {
+        uint64_t value = 0;
+        if (m_dispatch->vkGetSemaphoreCounterValue(m_device, m_semaphore, &value) != VK_SUCCESS) {
+            std::cout << "failed to read queue timeline value\n";
+            std::exit(-1);
+        }
+
+        return _observe(value);
+    }
+
+    bool QueueTimeline::is_complete(uint64_t value) {
+        if (value <= m_completed_value.load(std::memory_order_relaxed)) {
+            return true;
+        }
+
+        return value <= get_completed_value();
+    }
+
+    void QueueTimeline::wait(uint64_t value) {
+        if (is_complete(value)) {
+            return;
+        }
+
+        VLK_PROFILE_SCOPE("QueueTimeline::wait");
+
+        VkSemaphoreWaitInfo wait_info{};
+        wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        wait_info.semaphoreCount = 1;
+        wait_info.pSemaphores = &m_semaphore;
+        wait_info.pValues = &value;
+
+        if (m_dispatch->vkWaitSemaphores(m_device, &wait_info, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS) {
+            std::cout << "failed to wait on queue timeline\n";
+            std::exit(-1);
+        }
+
+        _observe(value);
+    }
+
+    uint64_t QueueTimeline::submit(const VkCommandBuffer* command_buffers, uint32_t command_buffer_count, const TimelineWait* waits,
+            uint32_t wait_count, VkSemaphore binary_wait, VkPipelineStageFlags binary_wait_stage, VkSemaphore binary_signal) {
+        if (wait_count > MAX_SUBMIT_WAITS) {
+            std::cout << "cannot wait on more than " << MAX_SUBMIT_WAITS << " timelines in one submit\n";
+            std::exit(-1);
+        }
+
+        // binary semaphores sit in the same arrays, their values are ignored
+        VkSemaphore wait_semaphores[MAX_SUBMIT_WAITS + 1]{};
+        uint64_t wait_values[MAX_SUBMIT_WAITS + 1]{};
+        VkPipelineStageFlags wait_stages[MAX_SUBMIT_WAITS + 1]{};
+        uint32_t semaphore_wait_count = 0;
+
+        for (uint32_t i = 0; i < wait_count; i++) {
+            if (waits[i].semaphore == nullptr || waits[i].value == 0) {
+                continue;
+            }
+
+            wait_semaphores[semaphore_wait_count] = waits[i].semaphore;
+            wait_values[semaphore_wait_count] = waits[i].value;
+            wait_stages[semaphore_wait_count] = waits[i].stage;
+            semaphore_wait_count++;
+        }
+
+        if (binary_wait != nullptr) {
+            wait_semaphores[semaphore_wait_count] = binary_wait;
+            wait_stages[semaphore_wait_count] = binary_wait_stage;
+            semaphore_wait_count++;
+        }
+
+        std::lock_guard<std::mutex> lock(m_submit_mutex);
+        uint64_t value = m_submitted_value + 1;
+
+        VkSemaphore signal_semaphores[2] = { m_semaphore, binary_signal };
+        uint64_t signal_values[2] = { value, 0 };
+        uint32_t signal_count = binary_signal != nullptr ? 2 : 1;
+
+        VkTimelineSemaphoreSubmitInfo timeline_submit_info{};
+        timeline_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timeline_submit_info.waitSemaphoreValueCount = semaphore_wait_count;
+        timeline_submit_info.pWaitSemaphoreValues = wait_values;
+        timeline_submit_info.signalSemaphoreValueCount = signal_count;
+        timeline_submit_info.pSignalSemaphoreValues = signal_values;
+
+        VkSubmitInfo submit_info{};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.pNext = &timeline_submit_info;
+        submit_info.waitSemaphoreCount = semaphore_wait_count;
+        submit_info.pWaitSemaphores = wait_semaphores;
+        submit_info.pWaitDstStageMask = wait_stages;
+        submit_info.commandBufferCount = command_buffer_count;
+        submit_info.pCommandBuffers = command_buffers;
+        submit_info.signalSemaphoreCount = signal_count;
+        submit_info.pSignalSemaphores = signal_semaphores;
+
+        if (m_dispatch->vkQueueSubmit(m_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
+            return 0;
+        }
+
+        m_submitted_value = value;
+        return value;
+    }
+
+    uint64_t QueueTimeline::_observe(uint64_t value) {
+        // other threads may have seen a newer value already, the counter never goes back
+        uint64_t completed = m_completed_value.load(std::memory_order_relaxed);
+        while (value > completed && !m_completed_value.compare_exchange_weak(completed, value, std::memory_order_relaxed)) {
+        }
+
+        return std::max(value, completed);
+    }
+
+}
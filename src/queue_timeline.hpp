@@ -0,0 +1,69 @@
+#ifndef __QUEUE_TIMELINE_HPP__
+#define __QUEUE_TIMELINE_HPP__
+
+#include "vulkan_dispatch.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+namespace vlk {
+
+    // a point on another queue's timeline for a submission to wait on before the given stages
+    struct TimelineWait {
+        VkSemaphore semaphore{ nullptr };
+        uint64_t value{ 0 };
+        VkPipelineStageFlags stage{ 0 };
+    };
+
+    // one timeline semaphore per queue, every submission through it signals the next value. whether some work has finished
+    // is a compare against a single counter instead of a fence per submission, nothing has to be reset, and other queues
+    // wait on a value directly. submissions go through here so values are signaled in the order they were handed out,
+    // which also serializes vkQueueSubmit for everyone sharing the queue
+    class QueueTimeline {
+    public:
+        static constexpr uint32_t MAX_SUBMIT_WAITS = 8;
+
+        QueueTimeline(VkDevice device, const VkAllocationCallbacks* allocation_callbacks, const VulkanDeviceDispatch* dispatch, VkQueue queue);
+        ~QueueTimeline();
+
+        inline VkQueue get_queue() const { return m_queue; }
+        inline VkSemaphore get_semaphore() const { return m_semaphore; }
+        // the value the latest submission will signal, 0 before anything was submitted
+        uint64_t get_submitted_value() const;
+        uint64_t get_completed_value();
+        inline TimelineWait wait_for(uint64_t value, VkPipelineStageFlags stage) const { return { m_semaphore, value, stage }; }
+
+        // value 0 is signaled from the start, so work that was never submitted always counts as complete
+        bool is_complete(uint64_t value);
+        void wait(uint64_t value);
+
+        // returns the value signaled once the command buffers finish, or 0 if the submit failed. binary semaphores are only
+        // for the swapchain, which can't use timelines
+        uint64_t submit(const VkCommandBuffer* command_buffers, uint32_t command_buffer_count, const TimelineWait* waits = nullptr,
+            uint32_t wait_count = 0, VkSemaphore binary_wait = nullptr, VkPipelineStageFlags binary_wait_stage = 0,
+            VkSemaphore binary_signal = nullptr);
+
+    private:
+        // records a value known to be signaled, returns the newest one seen
+        uint64_t _observe(uint64_t value);
+
+        QueueTimeline(const QueueTimeline& other) = delete;
+        QueueTimeline& operator=(const QueueTimeline& other) = delete;
+
+        VkDevice m_device{ nullptr };
+        const VkAllocationCallbacks* m_allocation_callbacks{ nullptr };
+        const VulkanDeviceDispatch* m_dispatch{ nullptr };
+        VkQueue m_queue{ nullptr };
+        VkSemaphore m_semaphore{ nullptr };
+
+        mutable std::mutex m_submit_mutex{};
+        uint64_t m_submitted_value{ 0 };
+        std::atomic<uint64_t> m_completed_value{ 0 }; // last value seen signaled, saves querying the driver for old values
+    };
+
+}
+
+#endif // __QUEUE_TIMELINE_HPP__
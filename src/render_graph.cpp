@@ -0,0 +1,481 @@
+#include "render_graph.hpp"
+#include "renderer.hpp"
+#include "profiler.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+namespace vlk {
+
+    static constexpr VkAccessFlags WRITE_ACCESS_MASK = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    RenderGraphPass::RenderGraphPass(const char* name, QueueType queue, Record record)
+        : m_name(name), m_queue(queue), m_record(std::move(record)) {
+    }
+
+    RenderGraphPass& RenderGraphPass::read(RenderGraphResource resource, VkPipelineStageFlags stages, VkAccessFlags access,
+            VkImageLayout layout) {
+        m_accesses.push_back({ resource.index, stages, access, layout, false });
+        return *this;
+    }
+
+    RenderGraphPass& RenderGraphPass::write(RenderGraphResource resource, VkPipelineStageFlags stages, VkAccessFlags access,
+            VkImageLayout layout) {
+        m_accesses.push_back({ resource.index, stages, access, layout, true });
+        return *this;
+    }
+
+    RenderGraphPass& RenderGraphPass::set_side_effect() {
+        m_side_effect = true;
+        return *this;
+    }
+
+    void RenderGraph::BarrierBatch::clear() {
+        src_stages = 0;
+        dst_stages = 0;
+        src_access = 0;
+        dst_access = 0;
+        buffer_barriers.clear();
+        image_barriers.clear();
+    }
+
+    RenderGraph::RenderGraph(VulkanDevice* device, Renderer* renderer)
+        : m_device(device), m_dispatch(&device->get_dispatch()), m_renderer(renderer) {
+        m_graphics_timeline = m_device->get_timeline(QueueType::Graphics);
+        m_graphics_family = m_device->get_queue_family(QueueType::Graphics);
+        m_compute_family = m_device->get_queue_family(QueueType::Compute);
+
+        // compute resolves to the graphics queue unless the device has a family just for it
+        QueueTimeline* compute_timeline = m_device->get_timeline(QueueType::Compute);
+        if (compute_timeline != m_graphics_timeline) {
+            m_async_timeline = compute_timeline;
+            _init_async_frames();
+        }
+    }
+
+    RenderGraph::~RenderGraph() {
+        for (FrameData& frame : m_frames) {
+            m_async_timeline->wait(frame.timeline_value);
+            vkDestroyCommandPool(m_device->get_device(), frame.command_pool, m_device->get_allocation_callbacks());
+        }
+    }
+
+    void RenderGraph::print_stats() const {
+        std::cout << "render graph: " << m_stats.pass_count << " passes (" << m_stats.culled_pass_count << " culled, "
+            << m_stats.async_pass_count << " on the async compute queue), " << m_stats.barrier_count << " barriers a frame with "
+            << m_stats.image_barrier_count << " image barriers, " << m_stats.folded_hazard_count << " hazards folded into global barriers and "
+            << m_stats.ownership_transfer_count << " ownership transfers\n";
+    }
+
+    RenderGraphResource RenderGraph::import_buffer(const char* name, VkBuffer buffer, QueueType owner) {
+        Resource resource{};
+        resource.name = name;
+        resource.buffer = buffer;
+        resource.state.family = m_device->get_queue_family(owner);
+
+        m_resources.push_back(resource);
+        return { static_cast<uint32_t>(m_resources.size() - 1) };
+    }
+
+    RenderGraphResource RenderGraph::import_image(const char* name, VkImage image, VkImageAspectFlags aspect, VkImageLayout layout) {
+        Resource resource{};
+        resource.name = name;
+        resource.is_image = true;
+        resource.image = image;
+        resource.aspect = aspect;
+        resource.state.layout = layout;
+
+        m_resources.push_back(resource);
+        return { static_cast<uint32_t>(m_resources.size() - 1) };
+    }
+
+    void RenderGraph::set_image(RenderGraphResource resource, VkImage image, VkImageLayout layout) {
+        Resource& imported = m_resources[resource.index];
+        if (imported.image == image) {
+            return;
+        }
+
+        // a release recorded for the old image is never acquired, that's fine since nothing uses it again
+        imported.image = image;
+        imported.state = {};
+        imported.state.layout = layout;
+    }
+
+    RenderGraphPass& RenderGraph::add_pass(const char* name, QueueType queue, RenderGraphPass::Record record) {
+        m_passes.emplace_back(name, queue, std::move(record));
+        m_compiled = false;
+        return m_passes.back();
+    }
+
+    void RenderGraph::compile() {
+        VLK_PROFILE_SCOPE("RenderGraph::compile");
+
+        // every resource is imported and outlives the frame, so a pass is only dropped when it writes nothing at all
+        for (RenderGraphPass& pass : m_passes) {
+            bool writes = std::any_of(pass.m_accesses.begin(), pass.m_accesses.end(), [](const RenderGraphPass::Access& access) {
+                return access.write;
+            });
+
+            pass.m_culled = !pass.m_side_effect && !writes;
+        }
+
+        // a compute pass goes async when everything it touches was last touched by another async pass this frame, or not at
+        // all yet. graphics passes can then depend on async ones but never the other way around, so the async passes are
+        // submitted ahead of the frame's graphics work and nothing has to be split into more submits
+        std::vector<const RenderGraphPass*> last_user(m_resources.size(), nullptr);
+        m_async_pass_count = 0;
+        for (RenderGraphPass& pass : m_passes) {
+            pass.m_async = false;
+            if (pass.m_culled) {
+                continue;
+            }
+
+            if (has_async_compute() && pass.m_queue == QueueType::Compute) {
+                pass.m_async = std::all_of(pass.m_accesses.begin(), pass.m_accesses.end(), [&](const RenderGraphPass::Access& access) {
+                    return last_user[access.resource] == nullptr || last_user[access.resource]->m_async;
+                });
+            }
+
+            for (const RenderGraphPass::Access& access : pass.m_accesses) {
+                last_user[access.resource] = &pass;
+            }
+
+            if (pass.m_async) {
+                m_async_pass_count++;
+            }
+        }
+
+        for (Resource& resource : m_resources) {
+            resource.async_use = false;
+            resource.async_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        }
+
+        m_stats = {};
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_passes.size()); i++) {
+            const RenderGraphPass& pass = m_passes[i];
+            m_stats.pass_count++;
+            if (pass.m_culled) {
+                m_stats.culled_pass_count++;
+                continue;
+            }
+
+            for (const RenderGraphPass::Access& access : pass.m_accesses) {
+                Resource& resource = m_resources[access.resource];
+                if (pass.m_async && !resource.async_use) {
+                    resource.async_use = true;
+                    resource.async_layout = access.layout;
+                }
+            }
+        }
+
+        m_pass_barriers.resize(m_passes.size());
+        m_compiled = true;
+
+        std::cout << "successfully compiled render graph with " << m_stats.pass_count << " passes (" << m_stats.culled_pass_count
+            << " culled, " << m_async_pass_count << " async)\n";
+    }
+
+    void RenderGraph::execute(VkCommandBuffer command_buffer, GpuProfiler* profiler) {
+        VLK_PROFILE_SCOPE("RenderGraph::execute");
+
+        if (!m_compiled) {
+            std::cout << "cannot execute a render graph that hasn't been compiled since it last changed\n";
+            std::exit(-1);
+        }
+
+        bool async = m_async_pass_count > 0 && _is_async_ready();
+        _plan(async);
+
+        if (async) {
+            _submit_async();
+        }
+
+        for (size_t i = 0; i < m_passes.size(); i++) {
+            RenderGraphPass& pass = m_passes[i];
+            if (pass.m_culled || (async && pass.m_async)) {
+                continue;
+            }
+
+            // the zones take in the pass's barrier, waiting on it is part of what the pass costs
+            VLK_PROFILE_SCOPE(pass.m_name);
+            VLK_PROFILE_GPU_SCOPE(profiler, command_buffer, pass.m_name);
+
+            _record_barriers(command_buffer, m_pass_barriers[i]);
+            pass.m_record(command_buffer);
+        }
+
+        _record_barriers(command_buffer, m_graphics_release);
+    }
+
+    void RenderGraph::_init_async_frames() {
+        m_frames.resize(m_renderer->get_frames_in_flight());
+
+        for (FrameData& frame : m_frames) {
+            VkCommandPoolCreateInfo pool_create_info{};
+            pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            pool_create_info.queueFamilyIndex = m_compute_family;
+
+            if (vkCreateCommandPool(m_device->get_device(), &pool_create_info, m_device->get_allocation_callbacks(), &frame.command_pool) != VK_SUCCESS) {
+                std::cout << "failed to create async compute command pool\n";
+                std::exit(-1);
+            }
+
+            VkCommandBufferAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.commandPool = frame.command_pool;
+            allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocate_info.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(m_device->get_device(), &allocate_info, &frame.command_buffer) != VK_SUCCESS) {
+                std::cout << "failed to allocate async compute command buffer\n";
+                std::exit(-1);
+            }
+        }
+    }
+
+    bool RenderGraph::_is_async_ready() const {
+        for (const Resource& resource : m_resources) {
+            if (!resource.async_use) {
+                continue;
+            }
+
+            const ResourceState& state = resource.state;
+            bool owned = state.family == VK_QUEUE_FAMILY_IGNORED || state.family == m_compute_family;
+            bool released = state.family == m_graphics_family && state.released;
+            if (!owned && !released) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void RenderGraph::_plan(bool async) {
+        m_async_release.clear();
+        m_graphics_release.clear();
+        m_async_wait_stages = 0;
+        m_graphics_wait_stages = 0;
+
+        m_stats.async_pass_count = async ? m_async_pass_count : 0;
+        m_stats.barrier_count = 0;
+        m_stats.image_barrier_count = 0;
+        m_stats.folded_hazard_count = 0;
+        m_stats.ownership_transfer_count = 0;
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_passes.size()); i++) {
+            const RenderGraphPass& pass = m_passes[i];
+            BarrierBatch& batch = m_pass_barriers[i];
+            batch.clear();
+
+            if (pass.m_culled) {
+                continue;
+            }
+
+            uint32_t family = async && pass.m_async ? m_compute_family : m_graphics_family;
+            for (const RenderGraphPass::Access& access : pass.m_accesses) {
+                _plan_access(access, family, batch);
+            }
+        }
+
+        // whatever next frame's async passes use is handed over at the end of this frame's graphics work, already in the
+        // layout they want it in
+        if (has_async_compute()) {
+            for (Resource& resource : m_resources) {
+                if (resource.async_use && resource.state.family == m_graphics_family && !resource.state.released) {
+                    _release(resource, m_compute_family, resource.async_layout, m_graphics_release);
+                }
+            }
+        }
+    }
+
+    void RenderGraph::_plan_access(const RenderGraphPass::Access& access, uint32_t family, BarrierBatch& batch) {
+        Resource& resource = m_resources[access.resource];
+        ResourceState& state = resource.state;
+        VkImageLayout layout = resource.is_image ? access.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageSubresourceRange range{ resource.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+
+        if (state.family != VK_QUEUE_FAMILY_IGNORED && state.family != family) {
+            // last used on the other queue. async passes only hand resources forward to this frame's graphics passes, those
+            // get released as the async passes finish. anything going the other way was released at the end of last frame
+            if (!state.released) {
+                _release(resource, family, layout, m_async_release);
+            }
+
+            QueueOwnershipTransfer transfer{ state.family, family };
+            if (resource.is_image) {
+                batch.image_barriers.push_back(transfer.image_barrier(resource.image, range, state.release_old_layout,
+                    state.release_new_layout, 0, access.access));
+                state.layout = state.release_new_layout;
+            }
+            else {
+                batch.buffer_barriers.push_back(transfer.buffer_barrier(resource.buffer, 0, access.access));
+            }
+            batch.dst_stages |= access.stages;
+            (family == m_graphics_family ? m_graphics_wait_stages : m_async_wait_stages) |= access.stages;
+
+            state.family = family;
+            state.released = false;
+            state.write_stages = access.stages;
+            state.write_access = access.write ? access.access & WRITE_ACCESS_MASK : 0;
+            state.read_stages = access.write ? 0 : access.stages;
+            state.visible_stages = access.write ? 0 : access.stages;
+            state.visible_access = access.write ? 0 : access.access;
+        }
+        else {
+            if (state.family == VK_QUEUE_FAMILY_IGNORED) {
+                state.family = family;
+            }
+
+            bool layout_change = resource.is_image && layout != state.layout;
+            if (access.write || layout_change) {
+                // a write or a transition waits on everything since the last write, reads included
+                VkPipelineStageFlags src_stages = state.write_stages | state.read_stages;
+                if (src_stages != 0 || layout_change) {
+                    batch.src_stages |= src_stages;
+                    batch.dst_stages |= access.stages;
+
+                    if (layout_change) {
+                        VkImageMemoryBarrier barrier{};
+                        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                        barrier.srcAccessMask = state.write_access;
+                        barrier.dstAccessMask = access.access;
+                        barrier.oldLayout = state.layout;
+                        barrier.newLayout = layout;
+                        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                        barrier.image = resource.image;
+                        barrier.subresourceRange = range;
+                        batch.image_barriers.push_back(barrier);
+                    }
+                    else {
+                        batch.src_access |= state.write_access;
+                        batch.dst_access |= access.access;
+                        m_stats.folded_hazard_count++;
+                    }
+                }
+
+                // a transition counts as a write for everything after it, only the stages it was made visible to can skip
+                // waiting on it
+                state.layout = layout;
+                state.write_stages = access.stages;
+                state.write_access = access.write ? access.access & WRITE_ACCESS_MASK : 0;
+                state.read_stages = access.write ? 0 : access.stages;
+                state.visible_stages = access.write ? 0 : access.stages;
+                state.visible_access = access.write ? 0 : access.access;
+            }
+            else {
+                // reads only wait when the last write isn't visible to them yet
+                bool hidden = (access.stages & ~state.visible_stages) != 0 || (access.access & ~state.visible_access) != 0;
+                if (state.write_stages != 0 && hidden) {
+                    batch.src_stages |= state.write_stages;
+                    batch.src_access |= state.write_access;
+                    batch.dst_stages |= access.stages;
+                    batch.dst_access |= access.access;
+                    m_stats.folded_hazard_count++;
+
+                    state.visible_stages |= access.stages;
+                    state.visible_access |= access.access;
+                }
+
+                state.read_stages |= access.stages;
+            }
+        }
+    }
+
+    void RenderGraph::_release(Resource& resource, uint32_t dst_family, VkImageLayout layout, BarrierBatch& batch) {
+        ResourceState& state = resource.state;
+        QueueOwnershipTransfer transfer{ state.family, dst_family };
+        VkImageLayout new_layout = resource.is_image ? layout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (resource.is_image) {
+            VkImageSubresourceRange range{ resource.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+            batch.image_barriers.push_back(transfer.image_barrier(resource.image, range, state.layout, new_layout, state.write_access, 0));
+        }
+        else {
+            batch.buffer_barriers.push_back(transfer.buffer_barrier(resource.buffer, state.write_access, 0));
+        }
+        batch.src_stages |= state.write_stages | state.read_stages;
+
+        state.released = true;
+        state.release_old_layout = state.layout;
+        state.release_new_layout = new_layout;
+        m_stats.ownership_transfer_count++;
+    }
+
+    void RenderGraph::_record_barriers(VkCommandBuffer command_buffer, const BarrierBatch& batch) {
+        if (batch.is_empty()) {
+            return;
+        }
+
+        VkMemoryBarrier memory_barrier{};
+        memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memory_barrier.srcAccessMask = batch.src_access;
+        memory_barrier.dstAccessMask = batch.dst_access;
+        uint32_t memory_barrier_count = batch.src_access != 0 || batch.dst_access != 0 ? 1 : 0;
+
+        // an acquire has nothing before it to wait on within the queue, the semaphore did that, and a release has nothing
+        // after it
+        VkPipelineStageFlags src_stages = batch.src_stages != 0 ? batch.src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        VkPipelineStageFlags dst_stages = batch.dst_stages != 0 ? batch.dst_stages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+        m_dispatch->vkCmdPipelineBarrier(command_buffer, src_stages, dst_stages, 0, memory_barrier_count, &memory_barrier,
+            static_cast<uint32_t>(batch.buffer_barriers.size()), batch.buffer_barriers.data(),
+            static_cast<uint32_t>(batch.image_barriers.size()), batch.image_barriers.data());
+
+        m_stats.barrier_count++;
+        m_stats.image_barrier_count += static_cast<uint32_t>(batch.image_barriers.size());
+    }
+
+    void RenderGraph::_submit_async() {
+        FrameData& frame = m_frames[m_renderer->get_frame_index()];
+
+        // normally long done, the renderer already waited on this slot's graphics work and that waits on these
+        m_async_timeline->wait(frame.timeline_value);
+        m_dispatch->vkResetCommandPool(m_device->get_device(), frame.command_pool, 0);
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (m_dispatch->vkBeginCommandBuffer(frame.command_buffer, &begin_info) != VK_SUCCESS) {
+            std::cout << "failed to begin recording async compute command buffer\n";
+            std::exit(-1);
+        }
+
+        for (size_t i = 0; i < m_passes.size(); i++) {
+            RenderGraphPass& pass = m_passes[i];
+            if (pass.m_culled || !pass.m_async) {
+                continue;
+            }
+
+            // gpu zones are written to the graphics queue's query pools, async passes only get the cpu scope
+            VLK_PROFILE_SCOPE(pass.m_name);
+
+            _record_barriers(frame.command_buffer, m_pass_barriers[i]);
+            pass.m_record(frame.command_buffer);
+        }
+
+        _record_barriers(frame.command_buffer, m_async_release);
+
+        if (m_dispatch->vkEndCommandBuffer(frame.command_buffer) != VK_SUCCESS) {
+            std::cout << "failed to record async compute command buffer\n";
+            std::exit(-1);
+        }
+
+        // waits on last frame's graphics work whenever something was handed over by the graphics queue, which is every
+        // frame for any resource both queues use. the work runs on the compute queue but in series with rendering
+        TimelineWait wait = m_graphics_timeline->wait_for(m_graphics_timeline->get_submitted_value(), m_async_wait_stages);
+        frame.timeline_value = m_async_timeline->submit(&frame.command_buffer, 1, &wait, m_async_wait_stages != 0 ? 1 : 0);
+        if (frame.timeline_value == 0) {
+            std::cout << "failed to submit async compute command buffer\n";
+            std::exit(-1);
+        }
+
+        if (m_graphics_wait_stages != 0) {
+            m_renderer->add_wait(m_async_timeline->wait_for(frame.timeline_value, m_graphics_wait_stages));
+        }
+    }
+
+}
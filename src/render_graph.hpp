@@ -0,0 +1,201 @@
+#ifndef __RENDER_GRAPH_HPP__
+#define __RENDER_GRAPH_HPP__
+
+#include "vulkan_device.hpp"
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <cstdint>
+
+namespace vlk {
+
+    class Renderer;
+    class GpuProfiler;
+
+    struct RenderGraphResource {
+        static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+        uint32_t index{ INVALID_INDEX };
+
+        inline bool is_valid() const { return index != INVALID_INDEX; }
+    };
+
+    struct RenderGraphStats {
+        uint32_t pass_count{ 0 };
+        uint32_t culled_pass_count{ 0 };
+        uint32_t async_pass_count{ 0 };             // passes that ran on the async compute queue last frame
+        uint32_t barrier_count{ 0 };                // vkCmdPipelineBarrier calls recorded last frame
+        uint32_t image_barrier_count{ 0 };          // layout transitions and image ownership transfers
+        uint32_t folded_hazard_count{ 0 };          // hazards that went into a pass's one global memory barrier instead
+        uint32_t ownership_transfer_count{ 0 };
+    };
+
+    // what a pass declares about one resource, the graph works out every barrier between passes from these
+    class RenderGraphPass {
+    public:
+        using Record = std::function<void(VkCommandBuffer command_buffer)>;
+
+        struct Access {
+            uint32_t resource{ RenderGraphResource::INVALID_INDEX };
+            VkPipelineStageFlags stages{ 0 };
+            VkAccessFlags access{ 0 };
+            VkImageLayout layout{ VK_IMAGE_LAYOUT_UNDEFINED }; // images only, the graph transitions it before the pass
+            bool write{ false };
+        };
+
+        RenderGraphPass(const char* name, QueueType queue, Record record);
+
+        inline const char* get_name() const { return m_name; }
+        inline QueueType get_queue() const { return m_queue; }
+        inline bool is_culled() const { return m_culled; }
+        inline bool is_async() const { return m_async; }
+
+        // a write that depends on what was there before (a blend, an atomic) should be declared as a read too, otherwise
+        // the old contents aren't made visible to it
+        RenderGraphPass& read(RenderGraphResource resource, VkPipelineStageFlags stages, VkAccessFlags access,
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+        RenderGraphPass& write(RenderGraphResource resource, VkPipelineStageFlags stages, VkAccessFlags access,
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+        // never culled, e.g. the pass rendering to the swapchain, which isn't a graph resource
+        RenderGraphPass& set_side_effect();
+
+    private:
+        friend class RenderGraph;
+
+        const char* m_name{ nullptr };
+        QueueType m_queue{ QueueType::Graphics };
+        Record m_record{};
+        std::vector<Access> m_accesses{};
+        bool m_side_effect{ false };
+
+        // decided by RenderGraph::compile
+        bool m_culled{ false };
+        bool m_async{ false };
+    };
+
+    // a frame described as passes declaring what they read and write, compiled once and executed every frame. passes run
+    // in the order they were added, the graph records one batched barrier in front of each pass that needs one, drops
+    // passes that write nothing and moves compute passes that don't wait on graphics work from the same frame onto the
+    // async compute queue when the device has one. an async pass still waits on last frame's graphics work when it uses
+    // anything graphics touched, and the frame's graphics work waits on it in turn. the two queues only overlap for
+    // passes whose resources graphics never uses. every resource is imported, transient images with aliased memory are
+    // left for when a frame has intermediate attachments of its own
+    class RenderGraph {
+    public:
+        RenderGraph(VulkanDevice* device, Renderer* renderer);
+        ~RenderGraph();
+
+        inline bool has_async_compute() const { return m_async_timeline != nullptr; }
+        inline RenderGraphStats get_stats() const { return m_stats; }
+        void print_stats() const;
+
+        // imported resources outlive the frame, so a pass writing one is never culled. buffers are owned by the given
+        // queue's family to begin with, e.g. the graphics queue for anything the uploader has handed over
+        RenderGraphResource import_buffer(const char* name, VkBuffer buffer, QueueType owner = QueueType::Graphics);
+        RenderGraphResource import_image(const char* name, VkImage image, VkImageAspectFlags aspect, VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+        // call every frame before execute for images that get recreated. a different handle starts tracking over from
+        // layout with no queue owning it
+        void set_image(RenderGraphResource resource, VkImage image, VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+        // name is used for profiler zones and has to outlive the graph, like every other profiler scope name
+        RenderGraphPass& add_pass(const char* name, QueueType queue, RenderGraphPass::Record record);
+
+        // culls passes and picks the async compute passes, call again after adding passes
+        void compile();
+
+        // records the frame's passes, graphics ones into command_buffer after a profiler zone each. async passes are
+        // submitted on the compute queue straight away and the renderer's next submit waits on them. nothing using graph
+        // resources may be recorded into command_buffer afterwards, the graph releases them to the compute queue at the end
+        void execute(VkCommandBuffer command_buffer, GpuProfiler* profiler = nullptr);
+
+    private:
+        struct ResourceState {
+            VkImageLayout layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+            uint32_t family{ VK_QUEUE_FAMILY_IGNORED };     // ignored until a queue first uses it
+            VkPipelineStageFlags write_stages{ 0 };         // last write or layout transition
+            VkAccessFlags write_access{ 0 };                // still to be made available
+            VkPipelineStageFlags read_stages{ 0 };          // reads since, a later write waits on them
+            VkPipelineStageFlags visible_stages{ 0 };       // stages and access the last write is already visible to
+            VkAccessFlags visible_access{ 0 };
+
+            // the release half of an ownership transfer was recorded, the acquire repeats the same layouts
+            bool released{ false };
+            VkImageLayout release_old_layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+            VkImageLayout release_new_layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+        };
+
+        struct Resource {
+            const char* name{ nullptr };
+            bool is_image{ false };
+            VkBuffer buffer{ nullptr };
+            VkImage image{ nullptr };
+            VkImageAspectFlags aspect{ 0 };
+            ResourceState state{};
+
+            bool async_use{ false };                        // used by an async pass
+            VkImageLayout async_layout{ VK_IMAGE_LAYOUT_UNDEFINED }; // layout of its first async use
+        };
+
+        // everything one pass (or the end of a queue's work) needs, as a single vkCmdPipelineBarrier. buffers and images
+        // that keep their layout and queue share the global memory barrier
+        struct BarrierBatch {
+            VkPipelineStageFlags src_stages{ 0 };
+            VkPipelineStageFlags dst_stages{ 0 };
+            VkAccessFlags src_access{ 0 };
+            VkAccessFlags dst_access{ 0 };
+            std::vector<VkBufferMemoryBarrier> buffer_barriers{}; // ownership transfers only
+            std::vector<VkImageMemoryBarrier> image_barriers{};
+
+            void clear();
+            inline bool is_empty() const {
+                return src_stages == 0 && dst_stages == 0 && buffer_barriers.empty() && image_barriers.empty();
+            }
+        };
+
+        struct FrameData {
+            VkCommandPool command_pool{ nullptr };
+            VkCommandBuffer command_buffer{ nullptr };
+            uint64_t timeline_value{ 0 }; // compute timeline value signaled by this slot's async passes
+        };
+
+        void _init_async_frames();
+
+        // every resource an async pass uses has to be unowned, owned by the compute family or released to it already,
+        // otherwise the async passes run on the graphics queue this frame
+        bool _is_async_ready() const;
+        void _plan(bool async);
+        void _plan_access(const RenderGraphPass::Access& access, uint32_t family, BarrierBatch& batch);
+        void _release(Resource& resource, uint32_t dst_family, VkImageLayout layout, BarrierBatch& batch);
+        void _record_barriers(VkCommandBuffer command_buffer, const BarrierBatch& batch);
+        void _submit_async();
+
+        RenderGraph(const RenderGraph& other) = delete;
+        RenderGraph& operator=(const RenderGraph& other) = delete;
+
+        VulkanDevice* m_device{ nullptr };
+        const VulkanDeviceDispatch* m_dispatch{ nullptr };
+        Renderer* m_renderer{ nullptr };
+        QueueTimeline* m_graphics_timeline{ nullptr };
+        QueueTimeline* m_async_timeline{ nullptr }; // only when compute has a queue of its own
+        uint32_t m_graphics_family{ 0 };
+        uint32_t m_compute_family{ 0 };
+
+        std::deque<RenderGraphPass> m_passes{};
+        std::vector<Resource> m_resources{};
+        std::vector<FrameData> m_frames{};
+        bool m_compiled{ false };
+        uint32_t m_async_pass_count{ 0 };
+
+        // rebuilt by every execute, kept around so their storage is reused
+        std::vector<BarrierBatch> m_pass_barriers{};
+        BarrierBatch m_async_release{};     // end of the async passes, handing resources to this frame's graphics passes
+        BarrierBatch m_graphics_release{};  // end of the frame, handing resources to next frame's async passes
+        VkPipelineStageFlags m_async_wait_stages{ 0 };     // async passes waiting on earlier graphics work
+        VkPipelineStageFlags m_graphics_wait_stages{ 0 };  // graphics passes waiting on this frame's async passes
+
+        RenderGraphStats m_stats{};
+    };
+
+}
+
+#endif // __RENDER_GRAPH_HPP__
@@ -0,0 +1,294 @@
+#include "renderer.hpp"
+#include "profiler.hpp"
+#include "bindless_descriptors.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+namespace vlk {
+
+    Renderer::Renderer(VulkanDevice* device, uint32_t frames_in_flight) : m_device(device), m_dispatch(&device->get_dispatch()) {
+        m_timeline = m_device->get_timeline(QueueType::Graphics);
+        m_frames.resize(std::clamp(frames_in_flight, 1u, MAX_FRAMES_IN_FLIGHT));
+        m_image_timeline_values.resize(m_device->get_swapchain_image_count(), 0);
+
+        _init_frames();
+        _init_image_semaphores();
+        m_uniform_ring = new UniformRing(m_device, get_frames_in_flight());
+    }
+
+    Renderer::~Renderer() {
+        wait_idle();
+
+        for (VkSemaphore render_finished : m_render_finished) {
+            vkDestroySemaphore(m_device->get_device(), render_finished, m_device->get_allocation_callbacks());
+        }
+
+        for (FrameData& frame : m_frames) {
+            vkDestroySemaphore(m_device->get_device(), frame.image_available, m_device->get_allocation_callbacks());
+            vkDestroyCommandPool(m_device->get_device(), frame.command_pool, m_device->get_allocation_callbacks());
+        }
+
+        delete m_uniform_ring;
+    }
+
+    VkCommandBuffer Renderer::begin_frame() {
+        if (m_frame_started) {
+            std::cout << "cannot begin a frame while the previous one is still being recorded\n";
+            std::exit(-1);
+        }
+
+        FrameData& frame = m_frames[m_frame_index];
+        wait_for_frame();
+
+        m_device->get_deletion_queue()->collect(m_completed_frame_count);
+        m_device->get_bindless_descriptors()->collect(m_completed_frame_count);
+        m_uniform_ring->begin_frame(m_frame_index);
+
+        if (m_swapchain_stale && !_recreate_swapchain()) {
+            return nullptr;
+        }
+
+        VkResult result = VK_SUCCESS;
+        {
+            VLK_PROFILE_SCOPE("Renderer::acquire_next_image");
+            result = m_device->acquire_next_image(frame.image_available, &m_image_index);
+
+            // one retry against the new swapchain so a resize doesn't drop a frame
+            if (result == VK_ERROR_OUT_OF_DATE_KHR && _recreate_swapchain()) {
+                result = m_device->acquire_next_image(frame.image_available, &m_image_index);
+            }
+        }
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            return nullptr;
+        }
+        else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            std::cout << "failed to acquire swapchain image\n";
+            std::exit(-1);
+        }
+
+        // the image could still be in use by a different frame in flight if the image count doesn't match
+        m_timeline->wait(m_image_timeline_values[m_image_index]);
+
+        // resetting the pool is cheaper than resetting or freeing individual command buffers
+        m_dispatch->vkResetCommandPool(m_device->get_device(), frame.command_pool, 0);
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (m_dispatch->vkBeginCommandBuffer(frame.command_buffer, &begin_info) != VK_SUCCESS) {
+            std::cout << "failed to begin recording frame command buffer\n";
+            std::exit(-1);
+        }
+
+        m_frame_started = true;
+        return frame.command_buffer;
+    }
+
+    void Renderer::wait_for_frame() {
+        // only blocks if the gpu is a full frames in flight behind
+        VLK_PROFILE_SCOPE("Renderer::wait_for_frame");
+        m_timeline->wait(m_frames[m_frame_index].timeline_value);
+
+        // everything on the queue finishes in submission order, so any slot whose value has been reached means every
+        // frame up to and including it is done. that can be further along than the slot just waited on
+        uint64_t completed_value = m_timeline->get_completed_value();
+        for (const FrameData& frame : m_frames) {
+            if (frame.timeline_value != 0 && frame.timeline_value <= completed_value) {
+                m_completed_frame_count = std::max(m_completed_frame_count, frame.frame_number + 1);
+            }
+        }
+    }
+
+    void Renderer::add_wait(const TimelineWait& wait) {
+        if (wait.semaphore == nullptr || wait.value == 0) {
+            return;
+        }
+
+        // values only go up, so a later wait on the same timeline covers the earlier one
+        for (TimelineWait& pending_wait : m_pending_waits) {
+            if (pending_wait.semaphore == wait.semaphore) {
+                pending_wait.value = std::max(pending_wait.value, wait.value);
+                pending_wait.stage |= wait.stage;
+                return;
+            }
+        }
+
+        m_pending_waits.push_back(wait);
+    }
+
+    void Renderer::end_frame() {
+        if (!m_frame_started) {
+            std::cout << "cannot end a frame that was never started\n";
+            std::exit(-1);
+        }
+
+        FrameData& frame = m_frames[m_frame_index];
+
+        if (m_dispatch->vkEndCommandBuffer(frame.command_buffer) != VK_SUCCESS) {
+            std::cout << "failed to record frame command buffer\n";
+            std::exit(-1);
+        }
+
+        // offscreen devices never signal image available and have nothing to present, so there is nothing to wait on or
+        // signal. the swapchain only works with binary semaphores, everything else is the graphics timeline
+        bool presents = !m_device->is_offscreen();
+        VkSemaphore render_finished = presents ? m_render_finished[m_image_index] : VK_NULL_HANDLE;
+        frame.timeline_value = m_timeline->submit(&frame.command_buffer, 1, m_pending_waits.data(),
+            static_cast<uint32_t>(m_pending_waits.size()), presents ? frame.image_available : VK_NULL_HANDLE,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, render_finished);
+        if (frame.timeline_value == 0) {
+            std::cout << "failed to submit frame command buffer\n";
+            std::exit(-1);
+        }
+
+        frame.frame_number = m_frame_number;
+        m_image_timeline_values[m_image_index] = frame.timeline_value;
+        m_pending_waits.clear();
+
+        VkResult result = m_device->present(render_finished, m_image_index);
+        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR) {
+            std::cout << "failed to present swapchain image\n";
+            std::exit(-1);
+        }
+
+        m_frame_started = false;
+        m_frame_index = (m_frame_index + 1) % get_frames_in_flight();
+        m_frame_number++;
+
+        // the frame just submitted still uses the old swapchain, it is retired from m_frame_number onwards
+        bool resized = m_device->consume_window_resize();
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || resized) {
+            _recreate_swapchain();
+        }
+    }
+
+    void Renderer::begin_render_pass(VkCommandBuffer command_buffer, VkSubpassContents contents) {
+        const VkExtent2D& extent = m_device->get_swapchain_extent();
+
+        VkClearValue clear_values[2]{};
+        clear_values[0].color = { { 0.01f, 0.01f, 0.01f, 1.0f } };
+        clear_values[1].depthStencil = { 1.0f, 0 };
+
+        VkRenderPassBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        begin_info.renderPass = m_device->get_render_pass();
+        begin_info.framebuffer = m_device->get_framebuffer(m_image_index);
+        begin_info.renderArea.offset = { 0, 0 };
+        begin_info.renderArea.extent = extent;
+        begin_info.clearValueCount = 2;
+        begin_info.pClearValues = clear_values;
+
+        m_dispatch->vkCmdBeginRenderPass(command_buffer, &begin_info, contents);
+
+        if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+            set_viewport_and_scissor(command_buffer);
+        }
+    }
+
+    void Renderer::end_render_pass(VkCommandBuffer command_buffer) {
+        m_dispatch->vkCmdEndRenderPass(command_buffer);
+    }
+
+    VkCommandBufferInheritanceInfo Renderer::get_inheritance_info() const {
+        VkCommandBufferInheritanceInfo inheritance_info{};
+        inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance_info.renderPass = m_device->get_render_pass();
+        inheritance_info.subpass = 0;
+        inheritance_info.framebuffer = m_device->get_framebuffer(m_image_index);
+
+        return inheritance_info;
+    }
+
+    void Renderer::set_viewport_and_scissor(VkCommandBuffer command_buffer) const {
+        const VkExtent2D& extent = m_device->get_swapchain_extent();
+
+        // viewport and scissor are dynamic pipeline states
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+
+        VkRect2D scissor{ { 0, 0 }, extent };
+
+        m_dispatch->vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+        m_dispatch->vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+    }
+
+    void Renderer::wait_idle() {
+        vkDeviceWaitIdle(m_device->get_device());
+    }
+
+    bool Renderer::_recreate_swapchain() {
+        m_swapchain_stale = !m_device->recreate_swapchain(m_frame_number);
+        if (m_swapchain_stale) {
+            return false;
+        }
+
+        // image indices now refer to the new swapchain's images, none of which have been rendered to yet
+        m_image_timeline_values.assign(m_device->get_swapchain_image_count(), 0);
+
+        // the last presents may still be waiting on the old semaphores, they go with the old swapchain
+        for (VkSemaphore render_finished : m_render_finished) {
+            m_device->get_deletion_queue()->destroy_semaphore(render_finished, m_frame_number);
+        }
+        _init_image_semaphores();
+        return true;
+    }
+
+    void Renderer::_init_frames() {
+        for (FrameData& frame : m_frames) {
+            VkCommandPoolCreateInfo pool_create_info{};
+            pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            pool_create_info.queueFamilyIndex = m_device->get_queue_family_indices().graphics_family.value();
+
+            if (vkCreateCommandPool(m_device->get_device(), &pool_create_info, m_device->get_allocation_callbacks(), &frame.command_pool) != VK_SUCCESS) {
+                std::cout << "failed to create frame command pool\n";
+                std::exit(-1);
+            }
+
+            VkCommandBufferAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.commandPool = frame.command_pool;
+            allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocate_info.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(m_device->get_device(), &allocate_info, &frame.command_buffer) != VK_SUCCESS) {
+                std::cout << "failed to allocate frame command buffer\n";
+                std::exit(-1);
+            }
+
+            // binary, for the swapchain only. frame completion is tracked on the graphics timeline, where a slot that was
+            // never submitted waits on value 0 and returns straight away
+            VkSemaphoreCreateInfo semaphore_create_info{};
+            semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+            if (vkCreateSemaphore(m_device->get_device(), &semaphore_create_info, m_device->get_allocation_callbacks(), &frame.image_available) != VK_SUCCESS) {
+                std::cout << "failed to create frame synchronization objects\n";
+                std::exit(-1);
+            }
+        }
+
+        std::cout << "successfully initialized " << m_frames.size() << " frames in flight\n";
+    }
+
+    void Renderer::_init_image_semaphores() {
+        m_render_finished.resize(m_device->get_swapchain_image_count());
+
+        VkSemaphoreCreateInfo semaphore_create_info{};
+        semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        for (VkSemaphore& render_finished : m_render_finished) {
+            if (vkCreateSemaphore(m_device->get_device(), &semaphore_create_info, m_device->get_allocation_callbacks(), &render_finished) != VK_SUCCESS) {
+                std::cout << "failed to create swapchain image synchronization objects\n";
+                std::exit(-1);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,92 @@
+#ifndef __RENDERER_HPP__
+#define __RENDERER_HPP__
+
+#include "vulkan_device.hpp"
+#include "uniform_ring.hpp"
+
+#include <vector>
+
+namespace vlk {
+
+    // owns the per frame in flight resources so the cpu can record frame N + 1 while the gpu is still executing frame N
+    class Renderer {
+    public:
+        static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+        static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
+        Renderer(VulkanDevice* device, uint32_t frames_in_flight = DEFAULT_FRAMES_IN_FLIGHT);
+        ~Renderer();
+
+        inline uint32_t get_frames_in_flight() const { return static_cast<uint32_t>(m_frames.size()); }
+        inline uint32_t get_frame_index() const { return m_frame_index; }
+        inline uint32_t get_image_index() const { return m_image_index; }
+        inline uint64_t get_frame_number() const { return m_frame_number; }
+        // every frame numbered below this has finished on the gpu, up to date once wait_for_frame or begin_frame returns
+        inline uint64_t get_completed_frame_count() const { return m_completed_frame_count; }
+        // uniforms allocated from here between begin_frame and end_frame live exactly as long as the frame
+        inline UniformRing* get_uniform_ring() { return m_uniform_ring; }
+        inline const UniformRing* get_uniform_ring() const { return m_uniform_ring; }
+
+        // the next end_frame submit waits for this before the wait's stages, e.g. for work on another queue. a null or
+        // zero wait is ignored
+        void add_wait(const TimelineWait& wait);
+
+        // blocks until this frame slot's previous submission is done. begin_frame does this itself, calling it earlier
+        // just moves the wait in front of whatever comes before begin_frame, like sampling input
+        void wait_for_frame();
+
+        // returns nullptr when there is no image to render to this frame (e.g. a minimized window), in which case end_frame
+        // must not be called. an out of date swapchain is rebuilt here or in end_frame without waiting on the device
+        VkCommandBuffer begin_frame();
+        void end_frame();
+
+        // with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the pass may only contain vkCmdExecuteCommands
+        void begin_render_pass(VkCommandBuffer command_buffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+        void end_render_pass(VkCommandBuffer command_buffer);
+
+        // render pass state secondary command buffers continue from, only valid between begin_frame and end_frame
+        VkCommandBufferInheritanceInfo get_inheritance_info() const;
+        // viewport and scissor are dynamic and secondary command buffers don't inherit them
+        void set_viewport_and_scissor(VkCommandBuffer command_buffer) const;
+
+        // only for shutdown, the frame loop itself never waits on the whole device
+        void wait_idle();
+
+    private:
+        struct FrameData {
+            VkCommandPool command_pool{ nullptr };
+            VkCommandBuffer command_buffer{ nullptr };
+            VkSemaphore image_available{ nullptr };
+            uint64_t frame_number{ 0 };
+            uint64_t timeline_value{ 0 }; // graphics timeline value signaled by this slot's last submission
+        };
+
+        void _init_frames();
+        void _init_image_semaphores();
+        bool _recreate_swapchain();
+
+        Renderer(const Renderer& other) = delete;
+        Renderer& operator=(const Renderer& other) = delete;
+
+        VulkanDevice* m_device{ nullptr };
+        const VulkanDeviceDispatch* m_dispatch{ nullptr };
+        QueueTimeline* m_timeline{ nullptr };
+        std::vector<FrameData> m_frames{};
+        std::vector<uint64_t> m_image_timeline_values{}; // timeline value of the frame last rendering to each swapchain image
+        // one per swapchain image rather than per frame slot. a slot coming round again only shows its rendering finished,
+        // not that the presentation engine has waited on the signal, while an image is only acquired again once it has
+        std::vector<VkSemaphore> m_render_finished{};
+        std::vector<TimelineWait> m_pending_waits{};
+        UniformRing* m_uniform_ring{ nullptr };
+
+        uint32_t m_frame_index{ 0 };
+        uint32_t m_image_index{ 0 };
+        uint64_t m_frame_number{ 0 };
+        uint64_t m_completed_frame_count{ 0 };
+        bool m_frame_started{ false };
+        bool m_swapchain_stale{ false }; // a rebuild was needed but couldn't happen yet, usually a minimized window
+    };
+
+}
+
+#endif // __RENDERER_HPP__
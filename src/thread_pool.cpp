@@ -0,0 +1,100 @@
+#include "thread_pool.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace vlk {
+
+    uint32_t ThreadPool::default_thread_count() {
+        // leave one core for the thread submitting frames
+        uint32_t hardware_threads = std::thread::hardware_concurrency();
+        return std::max(hardware_threads, 2u) - 1;
+    }
+
+    ThreadPool::ThreadPool(uint32_t thread_count) : m_workers(std::max(thread_count, 1u)) {
+        for (uint32_t i = 0; i < m_workers.size(); i++) {
+            m_workers[i].thread = std::thread(&ThreadPool::_worker_main, this, i);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_job_available.notify_all();
+
+        for (Worker& worker : m_workers) {
+            worker.thread.join();
+        }
+    }
+
+    void ThreadPool::submit(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_shared_jobs.push_back(std::move(job));
+        }
+        m_job_available.notify_one();
+    }
+
+    void ThreadPool::submit_to(uint32_t worker_index, Job job) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_workers[worker_index].jobs.push_back(std::move(job));
+        }
+        // the targeted worker might not be the one woken by notify_one
+        m_job_available.notify_all();
+    }
+
+    void ThreadPool::run_on_workers(uint32_t worker_count, const Job& job) {
+        worker_count = std::min(worker_count, get_thread_count());
+
+        std::mutex done_mutex{};
+        std::condition_variable done{};
+        uint32_t remaining = worker_count;
+
+        for (uint32_t i = 0; i < worker_count; i++) {
+            submit_to(i, [&](uint32_t worker_index) {
+                job(worker_index);
+
+                std::lock_guard<std::mutex> lock(done_mutex);
+                if (--remaining == 0) {
+                    done.notify_one();
+                }
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done.wait(lock, [&]() { return remaining == 0; });
+    }
+
+    void ThreadPool::_worker_main(uint32_t worker_index) {
+        Profiler::get().set_thread_name(("worker " + std::to_string(worker_index)).c_str());
+
+        while (true) {
+            Job job{};
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                Worker& worker = m_workers[worker_index];
+                m_job_available.wait(lock, [&]() { return m_stopping || !worker.jobs.empty() || !m_shared_jobs.empty(); });
+
+                // jobs pinned to this worker go first, they are usually what someone is blocked on
+                if (!worker.jobs.empty()) {
+                    job = std::move(worker.jobs.front());
+                    worker.jobs.pop_front();
+                }
+                else if (!m_shared_jobs.empty()) {
+                    job = std::move(m_shared_jobs.front());
+                    m_shared_jobs.pop_front();
+                }
+                else {
+                    return; // stopping with nothing left to do
+                }
+            }
+
+            job(worker_index);
+        }
+    }
+
+}
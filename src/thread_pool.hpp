@@ -0,0 +1,53 @@
+#ifndef __THREAD_POOL_HPP__
+#define __THREAD_POOL_HPP__
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+namespace vlk {
+
+    // fixed set of worker threads. jobs either go to whichever worker is free, or to one specific worker when they touch
+    // per thread state such as command pools
+    class ThreadPool {
+    public:
+        using Job = std::function<void(uint32_t worker_index)>;
+
+        static uint32_t default_thread_count();
+
+        ThreadPool(uint32_t thread_count = default_thread_count());
+        ~ThreadPool();
+
+        inline uint32_t get_thread_count() const { return static_cast<uint32_t>(m_workers.size()); }
+
+        void submit(Job job);
+        void submit_to(uint32_t worker_index, Job job);
+
+        // runs job once on each of the first worker_count workers and returns once they have all finished
+        void run_on_workers(uint32_t worker_count, const Job& job);
+
+    private:
+        struct Worker {
+            std::thread thread{};
+            std::deque<Job> jobs{};
+        };
+
+        void _worker_main(uint32_t worker_index);
+
+        ThreadPool(const ThreadPool& other) = delete;
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+
+        std::vector<Worker> m_workers{};
+        std::deque<Job> m_shared_jobs{};
+        std::mutex m_mutex{};
+        std::condition_variable m_job_available{};
+        bool m_stopping{ false };
+    };
+
+}
+
+#endif // __THREAD_POOL_HPP__
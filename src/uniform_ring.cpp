@@ -0,0 +1,137 @@
+#include "uniform_ring.hpp"
+#include "profiler.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+namespace vlk {
+
+    static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    UniformRing::UniformRing(VulkanDevice* device, uint32_t frames_in_flight, VkDeviceSize frame_capacity)
+        : m_device(device), m_dispatch(&device->get_dispatch()) {
+        VLK_PROFILE_SCOPE("UniformRing::UniformRing");
+
+        m_alignment = std::max<VkDeviceSize>(m_device->get_physical_device_properties().limits.minUniformBufferOffsetAlignment, 1);
+        m_frame_capacity = align_up(frame_capacity, m_alignment);
+
+        // the descriptor always covers MAX_ALLOCATION_SIZE bytes past the dynamic offset, the tail keeps that inside the
+        // buffer for allocations at the very end of the last segment
+        VkDeviceSize size = m_frame_capacity * frames_in_flight + MAX_ALLOCATION_SIZE;
+
+        // passes on the async compute queue read the ring too, every frame, so it's shared rather than handed back and
+        // forth between the two families
+        uint32_t queue_families[] = { m_device->get_queue_family(QueueType::Graphics), m_device->get_queue_family(QueueType::Compute) };
+        uint32_t queue_family_count = queue_families[0] != queue_families[1] ? 2 : 1;
+        m_buffer = m_device->get_allocator()->create_buffer(size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &m_allocation, queue_families, queue_family_count);
+
+        if (m_allocation.mapped == nullptr) {
+            std::cout << "uniform rings need host visible memory\n";
+            std::exit(-1);
+        }
+
+        _init_descriptor_set();
+        begin_frame(0);
+    }
+
+    UniformRing::~UniformRing() {
+        std::cout << "uniform ring: peak " << m_peak_usage << " of " << m_frame_capacity << " bytes per frame\n";
+
+        vkDestroyDescriptorPool(m_device->get_device(), m_descriptor_pool, m_device->get_allocation_callbacks());
+        vkDestroyDescriptorSetLayout(m_device->get_device(), m_set_layout, m_device->get_allocation_callbacks());
+        m_device->get_allocator()->destroy_buffer(m_buffer, m_allocation);
+    }
+
+    void UniformRing::begin_frame(uint32_t frame_index) {
+        m_peak_usage = std::max(m_peak_usage, std::min(m_head.load(), m_segment_end) - m_segment_begin);
+
+        m_segment_begin = m_frame_capacity * frame_index;
+        m_segment_end = m_segment_begin + m_frame_capacity;
+        m_head.store(m_segment_begin);
+    }
+
+    UniformRing::Allocation UniformRing::allocate(VkDeviceSize size) {
+        if (size > MAX_ALLOCATION_SIZE) {
+            std::cout << "failed to allocate " << size << " bytes of uniforms, blocks are limited to " << MAX_ALLOCATION_SIZE << "\n";
+            std::exit(-1);
+        }
+
+        VkDeviceSize offset = m_head.fetch_add(align_up(size, m_alignment));
+        if (offset + size > m_segment_end) {
+            std::cout << "failed to allocate uniforms, the frame has used all " << m_frame_capacity << " bytes\n";
+            std::exit(-1);
+        }
+
+        Allocation allocation{};
+        allocation.data = static_cast<uint8_t*>(m_allocation.mapped) + offset;
+        allocation.offset = static_cast<uint32_t>(offset);
+        return allocation;
+    }
+
+    void UniformRing::bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t set, uint32_t offset) const {
+        m_dispatch->vkCmdBindDescriptorSets(command_buffer, bind_point, layout, set, 1, &m_set, 1, &offset);
+    }
+
+    void UniformRing::_init_descriptor_set() {
+        VkDescriptorSetLayoutBinding binding{};
+        binding.binding = 0;
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        binding.descriptorCount = 1;
+        binding.stageFlags = VK_SHADER_STAGE_ALL;
+
+        VkDescriptorSetLayoutCreateInfo layout_create_info{};
+        layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_create_info.bindingCount = 1;
+        layout_create_info.pBindings = &binding;
+
+        if (vkCreateDescriptorSetLayout(m_device->get_device(), &layout_create_info, m_device->get_allocation_callbacks(), &m_set_layout) != VK_SUCCESS) {
+            std::cout << "failed to create uniform ring descriptor set layout\n";
+            std::exit(-1);
+        }
+
+        VkDescriptorPoolSize pool_size{};
+        pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        pool_size.descriptorCount = 1;
+
+        VkDescriptorPoolCreateInfo pool_create_info{};
+        pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_create_info.maxSets = 1;
+        pool_create_info.poolSizeCount = 1;
+        pool_create_info.pPoolSizes = &pool_size;
+
+        if (vkCreateDescriptorPool(m_device->get_device(), &pool_create_info, m_device->get_allocation_callbacks(), &m_descriptor_pool) != VK_SUCCESS) {
+            std::cout << "failed to create uniform ring descriptor pool\n";
+            std::exit(-1);
+        }
+
+        VkDescriptorSetAllocateInfo allocate_info{};
+        allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocate_info.descriptorPool = m_descriptor_pool;
+        allocate_info.descriptorSetCount = 1;
+        allocate_info.pSetLayouts = &m_set_layout;
+
+        if (vkAllocateDescriptorSets(m_device->get_device(), &allocate_info, &m_set) != VK_SUCCESS) {
+            std::cout << "failed to allocate uniform ring descriptor set\n";
+            std::exit(-1);
+        }
+
+        VkDescriptorBufferInfo buffer_info{};
+        buffer_info.buffer = m_buffer;
+        buffer_info.offset = 0;
+        buffer_info.range = MAX_ALLOCATION_SIZE;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_set;
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        write.pBufferInfo = &buffer_info;
+
+        m_dispatch->vkUpdateDescriptorSets(m_device->get_device(), 1, &write, 0, nullptr);
+    }
+
+}
@@ -0,0 +1,76 @@
+#ifndef __UNIFORM_RING_HPP__
+#define __UNIFORM_RING_HPP__
+
+#include "vulkan_device.hpp"
+#include "vulkan_allocator.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace vlk {
+
+    // per frame uniform data, one persistently mapped buffer split into a segment per frame in flight. allocations bump
+    // a pointer through the current frame's segment and are addressed with a dynamic offset into a single descriptor, so
+    // writing uniforms is a memcpy and binding them is an offset, with no allocations or descriptor writes per frame.
+    // a segment is reset by begin_frame once the renderer has waited for the frame that last used it
+    class UniformRing {
+    public:
+        static constexpr VkDeviceSize DEFAULT_FRAME_CAPACITY = 256 * 1024;
+        static constexpr VkDeviceSize MAX_ALLOCATION_SIZE = 1024; // range of the descriptor, the largest block a shader can see
+
+        struct Allocation {
+            void* data{ nullptr };
+            uint32_t offset{ 0 };   // dynamic offset to bind the set with
+        };
+
+        UniformRing(VulkanDevice* device, uint32_t frames_in_flight, VkDeviceSize frame_capacity = DEFAULT_FRAME_CAPACITY);
+        ~UniformRing();
+
+        inline VkBuffer get_buffer() const { return m_buffer; }
+        inline VkDeviceSize get_alignment() const { return m_alignment; }
+        inline VkDescriptorSetLayout get_set_layout() const { return m_set_layout; }
+        inline VkDescriptorSet get_set() const { return m_set; }
+
+        // only once the frame slot's timeline value has been waited on
+        void begin_frame(uint32_t frame_index);
+
+        // safe to call from several recording threads at once, the memory is only valid until this frame slot comes around
+        Allocation allocate(VkDeviceSize size);
+
+        template<typename T>
+        inline uint32_t push(const T& value) {
+            static_assert(sizeof(T) <= MAX_ALLOCATION_SIZE, "uniform block is larger than the ring's descriptor range");
+            Allocation allocation = allocate(sizeof(T));
+            *static_cast<T*>(allocation.data) = value;
+            return allocation.offset;
+        }
+
+        // a single uniform block at binding 0 of set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+        void bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t set, uint32_t offset) const;
+
+    private:
+        void _init_descriptor_set();
+
+        UniformRing(const UniformRing& other) = delete;
+        UniformRing& operator=(const UniformRing& other) = delete;
+
+        VulkanDevice* m_device{ nullptr };
+        const VulkanDeviceDispatch* m_dispatch{ nullptr };
+        VkBuffer m_buffer{ nullptr };
+        VulkanAllocation m_allocation{};
+        VkDeviceSize m_frame_capacity{ 0 };
+        VkDeviceSize m_alignment{ 256 };
+
+        VkDeviceSize m_segment_begin{ 0 };
+        VkDeviceSize m_segment_end{ 0 };
+        std::atomic<VkDeviceSize> m_head{ 0 };
+        VkDeviceSize m_peak_usage{ 0 };                // most any frame has allocated, printed on shutdown
+
+        VkDescriptorSetLayout m_set_layout{ nullptr };
+        VkDescriptorPool m_descriptor_pool{ nullptr };
+        VkDescriptorSet m_set{ nullptr };
+    };
+
+}
+
+#endif // __UNIFORM_RING_HPP__
@@ -0,0 +1,463 @@
+#include "vulkan_allocator.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <set>
+
+namespace vlk {
+
+    static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+        return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+    }
+
+    static VkDeviceSize floor_power_of_two(VkDeviceSize value) {
+        VkDeviceSize result = 1;
+        while (result <= value / 2) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    static VkDeviceSize ceil_power_of_two(VkDeviceSize value) {
+        VkDeviceSize result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    static uint32_t log2_of_power_of_two(VkDeviceSize value) {
+        uint32_t result = 0;
+        while (value > 1) {
+            value >>= 1;
+            result++;
+        }
+        return result;
+    }
+
+    // a buddy allocator over one VkDeviceMemory. order n nodes are MIN_ALLOCATION_SIZE << n bytes and always sit at an offset
+    // that is a multiple of their size, so any power of two alignment up to the node size is met for free
+    struct VulkanMemoryBlock {
+        VkDeviceMemory memory{ nullptr };
+        VkDeviceSize size{ 0 };
+        uint32_t memory_type{ 0 };
+        bool linear{ false };
+        uint32_t max_order{ 0 };
+        void* mapped{ nullptr };
+
+        std::vector<std::set<VkDeviceSize>> free_lists{}; // sorted so the lowest address is always handed out first
+        VkDeviceSize used_bytes{ 0 };
+        VkDeviceSize reserved_bytes{ 0 };
+        uint32_t allocation_count{ 0 };
+
+        static VkDeviceSize order_size(uint32_t order) {
+            return VulkanAllocator::MIN_ALLOCATION_SIZE << order;
+        }
+
+        void init() {
+            max_order = log2_of_power_of_two(size / VulkanAllocator::MIN_ALLOCATION_SIZE);
+            free_lists.resize(max_order + 1);
+            free_lists[max_order].insert(0);
+        }
+
+        bool try_allocate(VkDeviceSize request_size, VkDeviceSize alignment, VkDeviceSize* offset, uint32_t* order) {
+            VkDeviceSize node_size = ceil_power_of_two(std::max({ request_size, alignment, VulkanAllocator::MIN_ALLOCATION_SIZE }));
+            uint32_t wanted_order = log2_of_power_of_two(node_size / VulkanAllocator::MIN_ALLOCATION_SIZE);
+            if (wanted_order > max_order) {
+                return false;
+            }
+
+            uint32_t found_order = wanted_order;
+            while (found_order <= max_order && free_lists[found_order].empty()) {
+                found_order++;
+            }
+            if (found_order > max_order) {
+                return false;
+            }
+
+            VkDeviceSize node_offset = *free_lists[found_order].begin();
+            free_lists[found_order].erase(free_lists[found_order].begin());
+
+            // split down to the wanted size, keeping the low half and freeing the high half at each level
+            while (found_order > wanted_order) {
+                found_order--;
+                free_lists[found_order].insert(node_offset + order_size(found_order));
+            }
+
+            used_bytes += request_size;
+            reserved_bytes += node_size;
+            allocation_count++;
+
+            *offset = node_offset;
+            *order = wanted_order;
+            return true;
+        }
+
+        void release(VkDeviceSize offset, uint32_t order, VkDeviceSize request_size) {
+            used_bytes -= request_size;
+            reserved_bytes -= order_size(order);
+            allocation_count--;
+
+            // merge with the buddy for as long as it is free as well
+            while (order < max_order) {
+                VkDeviceSize buddy = offset ^ order_size(order);
+                auto found = free_lists[order].find(buddy);
+                if (found == free_lists[order].end()) {
+                    break;
+                }
+
+                free_lists[order].erase(found);
+                offset = std::min(offset, buddy);
+                order++;
+            }
+
+            free_lists[order].insert(offset);
+        }
+
+        VkDeviceSize largest_free_range() const {
+            for (uint32_t order = max_order + 1; order > 0; order--) {
+                if (!free_lists[order - 1].empty()) {
+                    return order_size(order - 1);
+                }
+            }
+            return 0;
+        }
+    };
+
+    VulkanAllocator::VulkanAllocator(VkDevice device, const VkAllocationCallbacks* allocation_callbacks, const VkPhysicalDeviceMemoryProperties& memory_properties,
+            const VkPhysicalDeviceLimits& limits, VkDeviceSize block_size)
+        : m_device(device), m_allocation_callbacks(allocation_callbacks), m_memory_properties(memory_properties), m_buffer_image_granularity(limits.bufferImageGranularity),
+          m_max_allocation_count(limits.maxMemoryAllocationCount) {
+
+        // small heaps (integrated or software devices) get smaller blocks so a single block can't starve the heap
+        for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; i++) {
+            VkDeviceSize heap_size = m_memory_properties.memoryHeaps[m_memory_properties.memoryTypes[i].heapIndex].size;
+            VkDeviceSize type_block_size = floor_power_of_two(std::min(block_size, std::max(heap_size / 8, MIN_ALLOCATION_SIZE)));
+            m_block_sizes[i] = std::max(type_block_size, MIN_ALLOCATION_SIZE);
+        }
+    }
+
+    VulkanAllocator::~VulkanAllocator() {
+        for (Pool& pool : m_pools) {
+            for (std::unique_ptr<VulkanMemoryBlock>& block : pool.blocks) {
+                if (block->allocation_count != 0) {
+                    std::cout << "vulkan allocator destroyed with " << block->allocation_count << " live allocations in memory type "
+                        << block->memory_type << "\n";
+                }
+                _destroy_block(block.get());
+            }
+        }
+
+        if (m_dedicated_count != 0) {
+            std::cout << "vulkan allocator destroyed with " << m_dedicated_count << " live dedicated allocations\n";
+        }
+    }
+
+    uint32_t VulkanAllocator::find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties) const {
+        for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; i++) {
+            if ((type_filter & (1 << i)) && (m_memory_properties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+
+        std::cout << "failed to find a suitable memory type\n";
+        std::exit(-1);
+    }
+
+    VulkanAllocation VulkanAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        VulkanAllocation allocation{};
+        allocation.memory_type = find_memory_type(requirements.memoryTypeBits, properties);
+        allocation.size = requirements.size;
+
+        // anything bigger than half a block would waste most of a block, so it gets its own memory
+        VkDeviceSize block_size = m_block_sizes[allocation.memory_type];
+        if (ceil_power_of_two(std::max(requirements.size, requirements.alignment)) > block_size / 2) {
+            allocation.memory = _allocate_memory(allocation.memory_type, requirements.size, &allocation.mapped);
+            m_dedicated_count++;
+            m_dedicated_bytes += requirements.size;
+            return allocation;
+        }
+
+        Pool& pool = _get_pool(allocation.memory_type, linear);
+        VulkanMemoryBlock* chosen_block = nullptr;
+        for (std::unique_ptr<VulkanMemoryBlock>& block : pool.blocks) {
+            if (block->try_allocate(requirements.size, requirements.alignment, &allocation.offset, &allocation.order)) {
+                chosen_block = block.get();
+                break;
+            }
+        }
+
+        if (chosen_block == nullptr) {
+            chosen_block = _create_block(allocation.memory_type, block_size);
+            chosen_block->linear = linear;
+            pool.blocks.emplace_back(chosen_block);
+
+            if (!chosen_block->try_allocate(requirements.size, requirements.alignment, &allocation.offset, &allocation.order)) {
+                std::cout << "failed to sub allocate " << requirements.size << " bytes from a new memory block\n";
+                std::exit(-1);
+            }
+        }
+
+        allocation.memory = chosen_block->memory;
+        allocation.block = chosen_block;
+        if (chosen_block->mapped != nullptr) {
+            allocation.mapped = static_cast<uint8_t*>(chosen_block->mapped) + allocation.offset;
+        }
+
+        return allocation;
+    }
+
+    void VulkanAllocator::free(VulkanAllocation& allocation) {
+        if (allocation.memory == nullptr) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (allocation.block == nullptr) {
+            vkFreeMemory(m_device, allocation.memory, m_allocation_callbacks);
+            m_device_memory_count--;
+            m_dedicated_count--;
+            m_dedicated_bytes -= allocation.size;
+            allocation = {};
+            return;
+        }
+
+        VulkanMemoryBlock* block = allocation.block;
+        block->release(allocation.offset, allocation.order, allocation.size);
+        allocation = {};
+
+        // keep a single empty block around per pool so allocation patterns that hover around a block boundary don't thrash
+        if (block->allocation_count == 0) {
+            Pool& pool = _get_pool(block->memory_type, block->linear);
+            size_t empty_blocks = std::count_if(pool.blocks.begin(), pool.blocks.end(),
+                [](const std::unique_ptr<VulkanMemoryBlock>& pool_block) { return pool_block->allocation_count == 0; });
+
+            if (empty_blocks > 1) {
+                auto found = std::find_if(pool.blocks.begin(), pool.blocks.end(),
+                    [block](const std::unique_ptr<VulkanMemoryBlock>& pool_block) { return pool_block.get() == block; });
+                _destroy_block(block);
+                pool.blocks.erase(found);
+            }
+        }
+    }
+
+    VkBuffer VulkanAllocator::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VulkanAllocation* allocation,
+        const uint32_t* queue_families, uint32_t queue_family_count) {
+        VkBufferCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        create_info.size = size;
+        create_info.usage = usage;
+        create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (queue_family_count > 1) {
+            create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            create_info.queueFamilyIndexCount = queue_family_count;
+            create_info.pQueueFamilyIndices = queue_families;
+        }
+
+        VkBuffer buffer{};
+        if (vkCreateBuffer(m_device, &create_info, m_allocation_callbacks, &buffer) != VK_SUCCESS) {
+            std::cout << "failed to create buffer\n";
+            std::exit(-1);
+        }
+
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(m_device, buffer, &requirements);
+
+        *allocation = allocate(requirements, properties, true);
+        vkBindBufferMemory(m_device, buffer, allocation->memory, allocation->offset);
+
+        return buffer;
+    }
+
+    void VulkanAllocator::destroy_buffer(VkBuffer buffer, VulkanAllocation& allocation) {
+        vkDestroyBuffer(m_device, buffer, m_allocation_callbacks);
+        free(allocation);
+    }
+
+    VkImage VulkanAllocator::create_image(const VkImageCreateInfo& create_info, VkMemoryPropertyFlags properties, VulkanAllocation* allocation) {
+        VkImage image{};
+        if (vkCreateImage(m_device, &create_info, m_allocation_callbacks, &image) != VK_SUCCESS) {
+            std::cout << "failed to create image\n";
+            std::exit(-1);
+        }
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(m_device, image, &requirements);
+
+        *allocation = allocate(requirements, properties, create_info.tiling == VK_IMAGE_TILING_LINEAR);
+        vkBindImageMemory(m_device, image, allocation->memory, allocation->offset);
+
+        return image;
+    }
+
+    void VulkanAllocator::destroy_image(VkImage image, VulkanAllocation& allocation) {
+        vkDestroyImage(m_device, image, m_allocation_callbacks);
+        free(allocation);
+    }
+
+    VulkanAllocatorStats VulkanAllocator::get_stats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        VulkanAllocatorStats stats{};
+        stats.dedicated_count = m_dedicated_count;
+        stats.dedicated_bytes = m_dedicated_bytes;
+        stats.allocation_count = m_dedicated_count;
+
+        for (const Pool& pool : m_pools) {
+            for (const std::unique_ptr<VulkanMemoryBlock>& block : pool.blocks) {
+                stats.block_count++;
+                stats.block_bytes += block->size;
+                stats.used_bytes += block->used_bytes;
+                stats.reserved_bytes += block->reserved_bytes;
+                stats.allocation_count += block->allocation_count;
+                stats.largest_free_range = std::max(stats.largest_free_range, block->largest_free_range());
+            }
+        }
+
+        VkDeviceSize free_bytes = stats.block_bytes - stats.reserved_bytes;
+        if (free_bytes > 0) {
+            stats.fragmentation = 1.0f - static_cast<float>(stats.largest_free_range) / static_cast<float>(free_bytes);
+        }
+
+        return stats;
+    }
+
+    void VulkanAllocator::print_stats() const {
+        VulkanAllocatorStats stats = get_stats();
+
+        std::cout << "vulkan allocator stats:\n";
+        std::cout << "\t* device memory objects: " << m_device_memory_count << " (limit " << m_max_allocation_count << ")\n";
+        std::cout << "\t* blocks: " << stats.block_count << " holding " << stats.block_bytes << " bytes\n";
+        std::cout << "\t* sub allocations: " << stats.allocation_count - stats.dedicated_count << " using " << stats.used_bytes
+            << " bytes (" << stats.reserved_bytes << " reserved)\n";
+        std::cout << "\t* dedicated allocations: " << stats.dedicated_count << " using " << stats.dedicated_bytes << " bytes\n";
+        std::cout << "\t* largest free range: " << stats.largest_free_range << " bytes, fragmentation: " << stats.fragmentation << "\n";
+    }
+
+    VulkanAllocator::Pool& VulkanAllocator::_get_pool(uint32_t memory_type, bool linear) {
+        // optimal images and linear resources live in separate pools whenever the device has a granularity to respect
+        bool pool_linear = m_buffer_image_granularity > 1 ? linear : false;
+
+        for (Pool& pool : m_pools) {
+            if (pool.memory_type == memory_type && pool.linear == pool_linear) {
+                return pool;
+            }
+        }
+
+        Pool pool{};
+        pool.memory_type = memory_type;
+        pool.linear = pool_linear;
+        m_pools.push_back(std::move(pool));
+        return m_pools.back();
+    }
+
+    VulkanMemoryBlock* VulkanAllocator::_create_block(uint32_t memory_type, VkDeviceSize size) {
+        VulkanMemoryBlock* block = new VulkanMemoryBlock();
+        block->memory_type = memory_type;
+        block->size = size;
+        block->memory = _allocate_memory(memory_type, size, &block->mapped);
+        block->init();
+
+        return block;
+    }
+
+    void VulkanAllocator::_destroy_block(VulkanMemoryBlock* block) {
+        vkFreeMemory(m_device, block->memory, m_allocation_callbacks);
+        m_device_memory_count--;
+    }
+
+    VkDeviceMemory VulkanAllocator::_allocate_memory(uint32_t memory_type, VkDeviceSize size, void** mapped) {
+        if (m_max_allocation_count != 0 && m_device_memory_count >= m_max_allocation_count) {
+            std::cout << "reached maxMemoryAllocationCount (" << m_max_allocation_count << ") device memory objects\n";
+            std::exit(-1);
+        }
+
+        VkMemoryAllocateInfo allocate_info{};
+        allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocate_info.allocationSize = size;
+        allocate_info.memoryTypeIndex = memory_type;
+
+        VkDeviceMemory memory{};
+        if (vkAllocateMemory(m_device, &allocate_info, m_allocation_callbacks, &memory) != VK_SUCCESS) {
+            std::cout << "failed to allocate " << size << " bytes of device memory\n";
+            std::exit(-1);
+        }
+        m_device_memory_count++;
+
+        *mapped = nullptr;
+        if (m_memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            if (vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+                std::cout << "failed to map host visible device memory\n";
+                std::exit(-1);
+            }
+        }
+
+        return memory;
+    }
+
+    VulkanRingBuffer::VulkanRingBuffer(VulkanAllocator* allocator, VkDeviceSize capacity, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+        : m_allocator(allocator), m_capacity(capacity) {
+        m_buffer = m_allocator->create_buffer(m_capacity, usage, properties, &m_allocation);
+
+        if (m_allocation.mapped == nullptr) {
+            std::cout << "ring buffers need host visible memory\n";
+            std::exit(-1);
+        }
+    }
+
+    VulkanRingBuffer::~VulkanRingBuffer() {
+        m_allocator->destroy_buffer(m_buffer, m_allocation);
+    }
+
+    bool VulkanRingBuffer::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset) {
+        if (size > m_capacity) {
+            return false;
+        }
+
+        VkDeviceSize used = get_used();
+        VkDeviceSize start = align_up(m_head, alignment);
+
+        // with head ahead of tail the free space is [head, capacity) and [0, tail), otherwise it is [head, tail)
+        if (m_head > m_tail || used == 0) {
+            if (start + size > m_capacity) {
+                // skip the rest of the buffer and start over at the front, the skipped bytes are released with this serial
+                if (size > m_tail && used != 0) {
+                    return false;
+                }
+                start = 0;
+                m_allocated_total += m_capacity - m_head;
+                m_head = 0;
+            }
+        }
+        else if (start + size > m_tail) {
+            return false;
+        }
+
+        m_allocated_total += (start - m_head) + size;
+        m_head = start + size;
+
+        *offset = start;
+        return true;
+    }
+
+    void VulkanRingBuffer::mark(uint64_t serial) {
+        if (m_allocated_total == m_marked_total) {
+            return; // nothing allocated since the last mark
+        }
+
+        m_marked_total = m_allocated_total;
+        m_markers.push_back({ serial, m_head, m_allocated_total });
+    }
+
+    void VulkanRingBuffer::release(uint64_t completed_serial) {
+        while (!m_markers.empty() && m_markers.front().serial <= completed_serial) {
+            m_tail = m_markers.front().head;
+            m_released_total = m_markers.front().allocated_total;
+            m_markers.pop_front();
+        }
+    }
+
+}
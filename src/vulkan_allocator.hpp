@@ -0,0 +1,140 @@
+#ifndef __VULKAN_ALLOCATOR_HPP__
+#define __VULKAN_ALLOCATOR_HPP__
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace vlk {
+
+    struct VulkanMemoryBlock;
+
+    struct VulkanAllocation {
+        VkDeviceMemory memory{ nullptr };
+        VkDeviceSize offset{ 0 };
+        VkDeviceSize size{ 0 };
+        void* mapped{ nullptr }; // host visible memory is persistently mapped, already offset to this allocation
+        uint32_t memory_type{ 0 };
+
+        // internal bookkeeping, block is null for dedicated allocations
+        VulkanMemoryBlock* block{ nullptr };
+        uint32_t order{ 0 };
+    };
+
+    struct VulkanAllocatorStats {
+        uint32_t block_count{ 0 };
+        uint32_t dedicated_count{ 0 };
+        uint32_t allocation_count{ 0 };
+        VkDeviceSize block_bytes{ 0 };      // total size of every pooled block
+        VkDeviceSize used_bytes{ 0 };       // bytes requested by live sub allocations
+        VkDeviceSize reserved_bytes{ 0 };   // bytes held by live sub allocations once rounded up to their buddy size
+        VkDeviceSize dedicated_bytes{ 0 };
+        VkDeviceSize largest_free_range{ 0 };
+        float fragmentation{ 0.0f };        // 1 - largest free range / total free bytes, 0 means all free memory is contiguous
+    };
+
+    // sub allocates buffers and images out of large per memory type blocks with a buddy allocator. linear resources
+    // (buffers) and optimal images never share a block, so bufferImageGranularity can't be violated within a block
+    class VulkanAllocator {
+    public:
+        static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+        static constexpr VkDeviceSize MIN_ALLOCATION_SIZE = 256;
+
+        VulkanAllocator(VkDevice device, const VkAllocationCallbacks* allocation_callbacks, const VkPhysicalDeviceMemoryProperties& memory_properties, const VkPhysicalDeviceLimits& limits,
+            VkDeviceSize block_size = DEFAULT_BLOCK_SIZE);
+        ~VulkanAllocator();
+
+        uint32_t find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties) const;
+
+        VulkanAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear);
+        void free(VulkanAllocation& allocation);
+
+        // more than one queue family makes the buffer concurrent between them, for buffers no one transfers ownership of
+        VkBuffer create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VulkanAllocation* allocation,
+            const uint32_t* queue_families = nullptr, uint32_t queue_family_count = 0);
+        void destroy_buffer(VkBuffer buffer, VulkanAllocation& allocation);
+        VkImage create_image(const VkImageCreateInfo& create_info, VkMemoryPropertyFlags properties, VulkanAllocation* allocation);
+        void destroy_image(VkImage image, VulkanAllocation& allocation);
+
+        VulkanAllocatorStats get_stats() const;
+        void print_stats() const;
+
+    private:
+        struct Pool {
+            uint32_t memory_type{ 0 };
+            bool linear{ false };
+            std::vector<std::unique_ptr<VulkanMemoryBlock>> blocks{};
+        };
+
+        Pool& _get_pool(uint32_t memory_type, bool linear);
+        VulkanMemoryBlock* _create_block(uint32_t memory_type, VkDeviceSize size);
+        void _destroy_block(VulkanMemoryBlock* block);
+        VkDeviceMemory _allocate_memory(uint32_t memory_type, VkDeviceSize size, void** mapped);
+
+        VulkanAllocator(const VulkanAllocator& other) = delete;
+        VulkanAllocator& operator=(const VulkanAllocator& other) = delete;
+
+        VkDevice m_device{ nullptr };
+        const VkAllocationCallbacks* m_allocation_callbacks{ nullptr };
+        VkPhysicalDeviceMemoryProperties m_memory_properties{};
+        VkDeviceSize m_buffer_image_granularity{ 1 };
+        uint32_t m_max_allocation_count{ 0 };
+        VkDeviceSize m_block_sizes[VK_MAX_MEMORY_TYPES]{};
+
+        std::vector<Pool> m_pools{};
+        uint32_t m_device_memory_count{ 0 };
+        uint32_t m_dedicated_count{ 0 };
+        VkDeviceSize m_dedicated_bytes{ 0 };
+        mutable std::mutex m_mutex{};
+    };
+
+    // linear allocator over one persistently mapped buffer for transient data. space is handed out front to back and wraps
+    // around, and is only reused once the serial (frame number, fence or timeline value) it was marked with has retired
+    class VulkanRingBuffer {
+    public:
+        VulkanRingBuffer(VulkanAllocator* allocator, VkDeviceSize capacity, VkBufferUsageFlags usage,
+            VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        ~VulkanRingBuffer();
+
+        inline VkBuffer get_buffer() const { return m_buffer; }
+        inline VkDeviceSize get_capacity() const { return m_capacity; }
+        inline VkDeviceSize get_used() const { return m_allocated_total - m_released_total; }
+        inline uint8_t* get_mapped() const { return static_cast<uint8_t*>(m_allocation.mapped); }
+
+        // returns false when there isn't enough retired space, the caller decides whether to wait or try again later
+        bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset);
+
+        // everything allocated since the last mark belongs to serial
+        void mark(uint64_t serial);
+        void release(uint64_t completed_serial);
+
+    private:
+        struct Marker {
+            uint64_t serial{ 0 };
+            VkDeviceSize head{ 0 };
+            VkDeviceSize allocated_total{ 0 };
+        };
+
+        VulkanRingBuffer(const VulkanRingBuffer& other) = delete;
+        VulkanRingBuffer& operator=(const VulkanRingBuffer& other) = delete;
+
+        VulkanAllocator* m_allocator{ nullptr };
+        VkBuffer m_buffer{ nullptr };
+        VulkanAllocation m_allocation{};
+        VkDeviceSize m_capacity{ 0 };
+
+        VkDeviceSize m_head{ 0 };
+        VkDeviceSize m_tail{ 0 };
+        VkDeviceSize m_allocated_total{ 0 }; // includes alignment padding and the space skipped when wrapping
+        VkDeviceSize m_released_total{ 0 };
+        VkDeviceSize m_marked_total{ 0 };
+        std::deque<Marker> m_markers{};
+    };
+
+}
+
+#endif // __VULKAN_ALLOCATOR_HPP__
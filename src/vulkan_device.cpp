@@ -1,542 +1,1150 @@
-#include "vulkan_device.hpp"
-
-#include <GLFW/glfw3.h>
-#include <iostream>     // std::cout, std::exit, std::...
-#include <set>          // std::set
-#include <limits>       // std::numeric_limits
-#include <algorithm>    // std::clamp
-
-namespace vlk {
-
-#if defined(NDEBUG)
-    bool VulkanDevice::m_enable_validation_layers = false;
-    std::vector<const char*> VulkanDevice::m_validation_layers{};
-    static VKAPI_ATTR VkBool32 VKAPI_CALL debug_call_back() { return VK_TRUE; }
-#else
-    bool VulkanDevice::m_enable_validation_layers = true;
-    std::vector<const char*> VulkanDevice::m_validation_layers = {
-        "VK_LAYER_KHRONOS_validation"
-    };
-
-    static VKAPI_ATTR VkBool32 VKAPI_CALL debug_call_back(
-            VkDebugUtilsMessageSeverityFlagBitsEXT message_severity, VkDebugUtilsMessageTypeFlagsEXT message_type,
-            const VkDebugUtilsMessengerCallbackDataEXT* callback_data, void* user_data) {
-
-        if (message_severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
-            std::cout << callback_data->pMessage << "\n\n";
-
-            // TODO: improve validation to be more specific with what objects it is affecting
-        }
-        else {
-            return VK_TRUE;
-        }
-
-        return VK_FALSE;
-    }
-#endif
-
-    std::vector<const char*> VulkanDevice::m_device_extensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-    };
-
-    std::vector<const char*> VulkanDevice::get_required_extensions() {
-        uint32_t glfw_extension_count = 0;
-        const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
-
-        std::vector<const char*> required_extensions;
-        for (uint32_t i = 0; i < glfw_extension_count; i++) {
-            required_extensions.push_back(glfw_extensions[i]);
-        }
-
-        if (m_enable_validation_layers) {
-            required_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-        }
-
-        return required_extensions;
-    }
-
-    QueueFamilyIndices QueueFamilyIndices::query(VkPhysicalDevice physical_device, VkSurfaceKHR surface) {
-        QueueFamilyIndices indices{};
-
-        uint32_t queue_family_count = 0;
-        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
-        std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
-        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
-
-        uint32_t i = 0;
-        for (VkQueueFamilyProperties& property : queue_families) {
-            if (property.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-                indices.graphics_family = i;
-            }
-
-            VkBool32 present_support = VK_FALSE;
-            vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface, &present_support);
-            if (present_support == VK_TRUE) {
-                indices.present_family = i;
-            }
-
-            if (indices.supports_rendering()) {
-                break;
-            }
-
-            i++;
-        }
-
-        return indices;
-    }
-
-    SwapchainSupportDetails SwapchainSupportDetails::query(VkPhysicalDevice physical_device, VkSurfaceKHR surface) {
-        SwapchainSupportDetails support_details{};
-
-        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &support_details.capabilities);
-
-        uint32_t format_count = 0;
-        vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, nullptr);
-        if (format_count != 0) {
-            support_details.formats.resize(format_count);
-            vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, support_details.formats.data());
-
-            uint32_t present_mode_count = 0;
-            vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, nullptr);
-            if (present_mode_count != 0) {
-                support_details.present_modes.resize(present_mode_count);
-                vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, support_details.present_modes.data());
-            }
-        }
-
-        return support_details;
-    }
-
-    bool SwapchainSupportDetails::is_supported() const {
-        return !formats.empty() && !present_modes.empty();
-    }
-
-    VkSurfaceFormatKHR SwapchainSupportDetails::choose_surface_format() {
-        if (present_modes.size() == 0) {
-            std::cout << "cannot choose surface format from SwapchainSupportDetails as there is nothing in the vector formats\n";
-            std::exit(-1);
-        }
-
-        for (VkSurfaceFormatKHR& format : formats) {
-            if (format.format == VK_FORMAT_B8G8R8A8_SRGB && format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-                return format;
-            }
-        }
-
-        return formats[0];
-    }
-
-    VkPresentModeKHR SwapchainSupportDetails::choose_present_mode() {
-        if (present_modes.size() == 0) {
-            std::cout << "cannot choose surface present mode from SwapchainSupportDetails as there is nothing in the vector present_modes\n";
-            std::exit(-1);
-        }
-
-        for (VkPresentModeKHR& present_mode : present_modes) {
-            if (present_mode == VK_PRESENT_MODE_MAILBOX_KHR) {
-                return present_mode;
-            }
-        }
-
-        return VK_PRESENT_MODE_FIFO_KHR;
-    }
-
-    VkExtent2D SwapchainSupportDetails::choose_swapchain_extent(Window* window) {
-        if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
-            return capabilities.currentExtent;
-        }
-
-        int width, height;
-        glfwGetFramebufferSize(window->get_internal_window(), &width, &height);
-        VkExtent2D actual_size = {
-            static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height)
-        };
-        actual_size.width = std::clamp(actual_size.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
-        actual_size.height = std::clamp(actual_size.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
-
-        return actual_size;
-    }
-
-    VulkanDevice::VulkanDevice(Window* window) : m_window(window) {
-        print_extension_support();
-
-        _init_instance();
-        _init_debug_manager();
-
-        m_window->init_surface(m_instance);
-
-        _init_physical_device();
-        _init_logical_device();
-        _init_swapchain();
-        _init_swapchain_images();
-    }
-
-    VulkanDevice::~VulkanDevice() {
-#if !defined(NDEBUG)
-        if (m_enable_validation_layers) {
-            auto destroy_debug_utils_messenger_ext_func = (PFN_vkDestroyDebugUtilsMessengerEXT) vkGetInstanceProcAddr(m_instance, "vkDestroyDebugUtilsMessengerEXT");
-            if (destroy_debug_utils_messenger_ext_func != nullptr) {
-                destroy_debug_utils_messenger_ext_func(m_instance, m_debug_messenger, nullptr);
-            }
-            else {
-                std::cout << "vkDestroyDebugMessengerEXT function doesn't exist\n";
-            }
-        }
-#endif
-        for (VkImageView& image_view : m_swapchain_image_views) {
-            vkDestroyImageView(m_device, image_view, nullptr);
-        }
-
-        vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
-        vkDestroyDevice(m_device, nullptr);
-        m_window->destroy_surface(m_instance);
-        vkDestroyInstance(m_instance, nullptr);
-    }
-
-    void VulkanDevice::print_extension_support() const {
-        uint32_t extension_count = 0;
-        vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
-        std::vector<VkExtensionProperties> extensions(extension_count);
-        vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, extensions.data());
-
-        std::cout << "list of available vulkan extensions that your devices supports:\n";
-        for (const VkExtensionProperties& extension : extensions) {
-            std::cout << "\t* (" << extension.specVersion << "):\t" << extension.extensionName << "\n";
-        }
-    }
-
-    void VulkanDevice::_populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT& create_info) {
-        create_info = {};
-        create_info.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-        create_info.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | 
-            VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-        create_info.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT |
-            VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
-        create_info.pfnUserCallback = debug_call_back;
-    }
-
-    bool VulkanDevice::_check_validation_layer_support() {
-        uint32_t layer_count = 0;
-        vkEnumerateInstanceLayerProperties(&layer_count, nullptr);
-        std::vector<VkLayerProperties> available_layers(layer_count);
-        vkEnumerateInstanceLayerProperties(&layer_count, available_layers.data());
-
-        std::cout << "checking available validation layers\n";
-        bool found_all_layers = true;
-        for (const char* layer_name : m_validation_layers) {
-            bool found_layer = false;
-            size_t layer_length = std::strlen(layer_name);
-
-            for (const VkLayerProperties& layer_property : available_layers) {
-                if (std::strncmp(layer_name, layer_property.layerName, layer_length) == 0) {
-                    found_layer = true;
-                    std::cout << "\t* " << layer_name << " found\n";
-                    break;
-                }
-            }
-
-            if (!found_layer) {
-                std::cout << "failed to find the validation layer: " << layer_name << " in available layers\n";
-                found_all_layers = false;
-            }
-        }
-
-        return found_all_layers;
-    }
-
-    bool VulkanDevice::_check_physical_device_required_extensions_support(VkPhysicalDevice physical_device) {
-        uint32_t device_extension_count = 0;
-        vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &device_extension_count, nullptr);
-        std::vector<VkExtensionProperties> device_extensions(device_extension_count);
-        vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &device_extension_count, device_extensions.data());
-
-        std::cout << "\t  available physical device extensions device extensions:\n";
-        for (VkExtensionProperties& extensions : device_extensions) {
-            std::cout << "\t\t* " << extensions.extensionName << "\n";
-        }
-
-        for (const char* required_extension : m_device_extensions) {
-            bool found = false;
-            size_t required_extension_length = std::strlen(required_extension);
-            for (VkExtensionProperties& extension : device_extensions) {
-                if (std::strncmp(required_extension, extension.extensionName, required_extension_length) == 0) {
-                    found = true;
-                    break;
-                }
-            }
-
-            if (!found) {
-                return false;
-            }
-        }
-
-        
-       return true;
-    }
-
-    void VulkanDevice::_init_instance() {
-        if (m_enable_validation_layers && !_check_validation_layer_support()) {
-            std::cout << "validation layer requested, but not available\n";
-            std::exit(-1);
-        }
-
-        VkApplicationInfo app_info{};
-        app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-        app_info.pApplicationName = m_window->get_title().c_str();
-        app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
-        app_info.pEngineName = "No Engine";
-        app_info.apiVersion = VK_API_VERSION_1_0;
-
-        VkInstanceCreateInfo create_info{};
-        create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-        create_info.pApplicationInfo = &app_info;
-
-        std::vector<const char*> required_extensions = get_required_extensions();
-        create_info.enabledExtensionCount = static_cast<uint32_t>(required_extensions.size());
-        create_info.ppEnabledExtensionNames = required_extensions.data();
-
-        VkDebugUtilsMessengerCreateInfoEXT debug_create_info{};
-        if (m_enable_validation_layers) {
-            create_info.enabledLayerCount = static_cast<uint32_t>(m_validation_layers.size());
-            create_info.ppEnabledLayerNames = m_validation_layers.data();
-
-            _populate_debug_messenger_create_info(debug_create_info);
-            create_info.pNext = static_cast<VkDebugUtilsMessengerCreateInfoEXT*>(&debug_create_info);
-        }
-        else {
-            create_info.enabledLayerCount = 0;
-            create_info.ppEnabledExtensionNames = nullptr;
-        }
-
-        if (vkCreateInstance(&create_info, nullptr, &m_instance) != VK_SUCCESS) {
-            std::cout << "failed to create vulkan instance\n";
-            std::exit(-1);
-        }
-
-        std::cout << "successfully initialized vulkan instance with the extensions:\n";
-        for (const char* extension : required_extensions) {
-            std::cout << "\t* " << extension << "\n";
-        }
-    }
-
-    void VulkanDevice::_init_debug_manager() {
-#if !defined(NDEBUG)
-        if (!m_enable_validation_layers) {
-            return;
-        }
-
-        VkDebugUtilsMessengerCreateInfoEXT create_info;
-        _populate_debug_messenger_create_info(create_info);
-
-        // getting the vkCreateDebugUtilsMessengerEXT function because its and ext therefore its not automatically loaded
-        auto create_debug_utils_messenger_ext_func = (PFN_vkCreateDebugUtilsMessengerEXT) vkGetInstanceProcAddr(m_instance, "vkCreateDebugUtilsMessengerEXT");
-        if (create_debug_utils_messenger_ext_func != nullptr) {
-            if (create_debug_utils_messenger_ext_func(m_instance, &create_info, nullptr, &m_debug_messenger) != VK_SUCCESS) {
-                std::cout << "failed to call vkCreateDebugUtilsMessengerEXT pointer function\n";
-                std::exit(-1);
-            }
-        }
-        else {
-            std::cout << "vkCreateDebugUtilsMessengerEXT function doesn't exit\n";
-            std::exit(-1);
-        }
-
-        std::cout << "successfully initialized vulkan debug messenger ext\n";
-#endif
-    }
-
-    void VulkanDevice::_init_physical_device() {
-        uint32_t device_count = 0;
-        vkEnumeratePhysicalDevices(m_instance, &device_count, nullptr);
-
-        if (device_count == 0) {
-            std::cout << "failed to find any physical devices capable of vulkan rendering\n";
-            std::exit(-1);
-        }
-
-        std::vector<VkPhysicalDevice> physical_devices(device_count);
-        vkEnumeratePhysicalDevices(m_instance, &device_count, physical_devices.data());
-
-        // checking if the device is suitable
-        std::cout << "physical devices on system:\n";
-        int score_to_beat = 0;
-        VkPhysicalDeviceProperties physical_device_properties;
-        for (VkPhysicalDevice physical_device : physical_devices) {
-            VkPhysicalDeviceProperties properties;
-            VkPhysicalDeviceFeatures features;
-
-            vkGetPhysicalDeviceProperties(physical_device, &properties);
-            vkGetPhysicalDeviceFeatures(physical_device, &features);
-
-            std::cout << "\t* " << properties.deviceName << "\n";
-
-            if (_check_physical_device_required_extensions_support(physical_device)) {
-                QueueFamilyIndices indices = QueueFamilyIndices::query(physical_device, m_window->get_surface());
-                if (!indices.supports_rendering()) {
-                    continue;
-                }
-
-                SwapchainSupportDetails swapchain_support = SwapchainSupportDetails::query(physical_device, m_window->get_surface());
-                if (!swapchain_support.is_supported()) {
-                    continue;
-                }
-
-                if (features.geometryShader) {
-                    int score = 0;
-                    if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
-                        score += 1000;
-                    }
-                    score += properties.limits.maxImageDimension2D;
-
-                    if (score > score_to_beat) {
-                        score_to_beat = score;
-                        m_physical_device = physical_device;
-                        physical_device_properties = properties;
-                        m_physical_device_features = features;
-                    }
-                }
-            }
-        }
-
-        if (m_physical_device == nullptr) {
-            std::cout << "something serious has happened when picking a physical device, cause this should never be called\n";
-            std::exit(-1);
-        }
-
-        std::cout << "chosen physical device: " << physical_device_properties.deviceName << ", extensions enabled:\n";
-        for (const char* extension_name : m_device_extensions) {
-            std::cout << "\t* " << extension_name << "\n";
-        }
-    }
-
-    void VulkanDevice::_init_logical_device() {
-        QueueFamilyIndices indices = QueueFamilyIndices::query(m_physical_device, m_window->get_surface());
-
-        std::vector<VkDeviceQueueCreateInfo> queue_create_infos{};
-        std::set<uint32_t> queue_create_info_ids = { indices.graphics_family.value(), indices.present_family.value() };
-
-        for (uint32_t queue_family_id : queue_create_info_ids) {
-            VkDeviceQueueCreateInfo create_info{};
-            create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-            create_info.pQueuePriorities = &indices.priority;
-            create_info.queueFamilyIndex = queue_family_id;
-            create_info.queueCount = 1;
-            queue_create_infos.push_back(create_info);
-        }
-
-        VkDeviceCreateInfo create_info{};
-        create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        create_info.pEnabledFeatures = &m_physical_device_features;
-        create_info.pQueueCreateInfos = queue_create_infos.data();
-        create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
-
-        create_info.enabledExtensionCount = static_cast<uint32_t>(m_device_extensions.size());
-        create_info.ppEnabledExtensionNames = m_device_extensions.data();
-
-        // for older version of vulkan, newer versions will ignore this parameters
-        if (m_enable_validation_layers) {
-            create_info.enabledLayerCount = static_cast<uint32_t>(m_validation_layers.size());
-            create_info.ppEnabledLayerNames = m_validation_layers.data();
-        }
-        else {
-            create_info.enabledLayerCount = 0;
-        }
-
-        if (vkCreateDevice(m_physical_device, &create_info, nullptr, &m_device) != VK_SUCCESS) {
-            std::cout << "failed to create logical device\n";
-            std::exit(-1);
-        }
-
-        vkGetDeviceQueue(m_device, indices.graphics_family.value(), 0, &m_graphics_queue);
-        vkGetDeviceQueue(m_device, indices.present_family.value(), 0, &m_present_queue);
-
-        std::cout << "successfully initialized vulkan logical device\n";
-    }
-
-    void VulkanDevice::_init_swapchain() {
-        SwapchainSupportDetails support = SwapchainSupportDetails::query(m_physical_device, m_window->get_surface());
-
-        m_swapchain_surface_format = support.choose_surface_format();
-        m_swapchain_present_mode = support.choose_present_mode();
-        m_swapchain_extent = support.choose_swapchain_extent(m_window);
-
-        uint32_t image_count = support.capabilities.minImageCount + 1; // recommended to go at least one over the minimum
-        if (support.capabilities.maxImageCount > 0 && image_count > support.capabilities.maxImageCount) {
-            image_count = support.capabilities.maxImageCount;
-        }
-
-        VkSwapchainCreateInfoKHR create_info{};
-        create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-        create_info.surface = m_window->get_surface();
-        create_info.minImageCount = image_count;
-        create_info.imageFormat = m_swapchain_surface_format.format;
-        create_info.imageExtent = m_swapchain_extent;
-        create_info.imageArrayLayers = 1; // this should always be 1, unless trying to create stereoscopic 3D applications
-        create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; 
-
-        QueueFamilyIndices indices = QueueFamilyIndices::query(m_physical_device, m_window->get_surface());
-        uint32_t queue_family_indices[] = { indices.graphics_family.value(), indices.present_family.value() };
-
-        if (indices.graphics_family != indices.present_family) {
-            create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-            create_info.queueFamilyIndexCount = 2;
-            create_info.pQueueFamilyIndices = queue_family_indices;
-        }
-        else {
-            create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-            create_info.queueFamilyIndexCount = 0;
-            create_info.pQueueFamilyIndices = nullptr;
-        }
-
-        create_info.preTransform = support.capabilities.currentTransform;
-        create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-        create_info.oldSwapchain = VK_NULL_HANDLE;
-
-        create_info.presentMode = m_swapchain_present_mode;
-        create_info.clipped = VK_TRUE;
-
-        if (vkCreateSwapchainKHR(m_device, &create_info, nullptr, &m_swapchain) != VK_SUCCESS) {
-            std::cout << "failed to create vulkan swapchain\n";
-            std::exit(-1);
-        }
-
-        std::cout << "successfully initialized vulkan swapchain\n";
-    }
-
-    void VulkanDevice::_init_swapchain_images() {
-        uint32_t swapchain_image_count = 0;
-        vkGetSwapchainImagesKHR(m_device, m_swapchain, &swapchain_image_count, nullptr);
-        m_swapchain_images.resize(swapchain_image_count);
-        vkGetSwapchainImagesKHR(m_device, m_swapchain, &swapchain_image_count, m_swapchain_images.data());
-
-        m_swapchain_image_views.resize(m_swapchain_images.size());
-        for (size_t i = 0; i < m_swapchain_images.size(); i++) {
-            VkImageViewCreateInfo create_info{};
-            create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-            create_info.image = m_swapchain_images[i];
-            create_info.format = m_swapchain_surface_format.format;
-            create_info.viewType =  VK_IMAGE_VIEW_TYPE_2D;
-
-            create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-            create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-            create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-            create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-
-            // TODO: learn mipmap stuff ...
-            create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            create_info.subresourceRange.baseMipLevel = 0;
-            create_info.subresourceRange.levelCount = 1;
-            create_info.subresourceRange.baseArrayLayer = 0;
-            create_info.subresourceRange.layerCount = 1;
-
-            if (vkCreateImageView(m_device, &create_info, nullptr, &m_swapchain_image_views[i]) != VK_SUCCESS) {
-                std::cout << "failed to create image views\n";
-                std::exit(-1);
-            }
-        }
-
-        std::cout << "successfully created swapchain image views\n";
-    }
-
-}
\ No newline at end of file
+#include "vulkan_device.hpp"
+#include "profiler.hpp"
+#include "physical_device_cache.hpp"
+#include "bindless_descriptors.hpp"
+
+#include <GLFW/glfw3.h>
+#include <iostream>     // std::cout, std::exit, std::...
+#include <set>          // std::set
+#include <limits>       // std::numeric_limits
+#include <algorithm>    // std::clamp
+#include <cstring>      // std::strcmp, std::strncmp
+
+namespace vlk {
+
+#if defined(NDEBUG)
+    bool VulkanDevice::m_enable_validation_layers = false;
+    std::vector<const char*> VulkanDevice::m_validation_layers{};
+#else
+    bool VulkanDevice::m_enable_validation_layers = true;
+    std::vector<const char*> VulkanDevice::m_validation_layers = {
+        "VK_LAYER_KHRONOS_validation"
+    };
+#endif
+
+    // still compiled in release, _populate_debug_messenger_create_info references it even though it is never called
+    static VKAPI_ATTR VkBool32 VKAPI_CALL debug_call_back(
+            VkDebugUtilsMessageSeverityFlagBitsEXT message_severity, VkDebugUtilsMessageTypeFlagsEXT message_type,
+            const VkDebugUtilsMessengerCallbackDataEXT* callback_data, void* user_data) {
+
+        if (message_severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
+            std::cout << callback_data->pMessage << "\n\n";
+
+            // TODO: improve validation to be more specific with what objects it is affecting
+        }
+        else {
+            return VK_TRUE;
+        }
+
+        return VK_FALSE;
+    }
+
+    std::vector<const char*> VulkanDevice::m_device_extensions = {
+        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+    };
+
+    std::vector<const char*> VulkanDevice::m_core_device_extensions = {
+        VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+    };
+
+    std::vector<const char*> VulkanDevice::m_optional_device_extensions = {
+        VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME,
+    };
+
+    std::vector<const char*> VulkanDevice::get_required_extensions(bool headless) {
+        std::vector<const char*> required_extensions;
+        if (!headless) {
+            uint32_t glfw_extension_count = 0;
+            const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+
+            for (uint32_t i = 0; i < glfw_extension_count; i++) {
+                required_extensions.push_back(glfw_extensions[i]);
+            }
+        }
+
+        if (m_enable_validation_layers) {
+            required_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+
+        return required_extensions;
+    }
+
+    QueueFamilyIndices QueueFamilyIndices::query(VkPhysicalDevice physical_device, VkSurfaceKHR surface,
+            const std::vector<VkQueueFamilyProperties>& queue_families) {
+        QueueFamilyIndices indices{};
+
+        // every family is looked at, the first of each kind wins except for present which prefers the graphics family
+        for (uint32_t i = 0; i < static_cast<uint32_t>(queue_families.size()); i++) {
+            const VkQueueFamilyProperties& property = queue_families[i];
+            if (property.queueCount == 0) {
+                continue;
+            }
+
+            bool graphics = property.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+            bool compute = property.queueFlags & VK_QUEUE_COMPUTE_BIT;
+            bool transfer = property.queueFlags & VK_QUEUE_TRANSFER_BIT;
+
+            if (graphics && !indices.graphics_family.has_value()) {
+                indices.graphics_family = i;
+            }
+
+            if (compute && !graphics && !indices.compute_family.has_value()) {
+                indices.compute_family = i;
+            }
+
+            if (transfer && !graphics && !compute && !indices.transfer_family.has_value()) {
+                indices.transfer_family = i;
+            }
+
+            if (surface == nullptr) {
+                continue;
+            }
+
+            VkBool32 present_support = VK_FALSE;
+            vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface, &present_support);
+            if (present_support == VK_TRUE && (!indices.present_family.has_value() || indices.graphics_family == i)) {
+                indices.present_family = i;
+            }
+        }
+
+        if (surface == nullptr) {
+            indices.present_family = indices.graphics_family;
+        }
+
+        return indices;
+    }
+
+    uint32_t QueueFamilyIndices::get_family(QueueType type) const {
+        switch (type) {
+            case QueueType::Present:
+                return present_family.value();
+            case QueueType::Compute:
+                return compute_family.value_or(graphics_family.value());
+            case QueueType::Transfer:
+                return transfer_family.value_or(graphics_family.value());
+            default:
+                return graphics_family.value();
+        }
+    }
+
+    VkBufferMemoryBarrier QueueOwnershipTransfer::buffer_barrier(VkBuffer buffer, VkAccessFlags src_access, VkAccessFlags dst_access,
+            VkDeviceSize offset, VkDeviceSize size) const {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = src_access;
+        barrier.dstAccessMask = dst_access;
+        barrier.srcQueueFamilyIndex = is_required() ? src_family : VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = is_required() ? dst_family : VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = buffer;
+        barrier.offset = offset;
+        barrier.size = size;
+
+        return barrier;
+    }
+
+    VkImageMemoryBarrier QueueOwnershipTransfer::image_barrier(VkImage image, const VkImageSubresourceRange& range, VkImageLayout old_layout,
+            VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access) const {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = src_access;
+        barrier.dstAccessMask = dst_access;
+        barrier.oldLayout = old_layout;
+        barrier.newLayout = new_layout;
+        barrier.srcQueueFamilyIndex = is_required() ? src_family : VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = is_required() ? dst_family : VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = range;
+
+        return barrier;
+    }
+
+    SwapchainSupportDetails SwapchainSupportDetails::query(VkPhysicalDevice physical_device, VkSurfaceKHR surface) {
+        SwapchainSupportDetails support_details{};
+
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &support_details.capabilities);
+
+        uint32_t format_count = 0;
+        vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, nullptr);
+        if (format_count != 0) {
+            support_details.formats.resize(format_count);
+            vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, support_details.formats.data());
+
+            uint32_t present_mode_count = 0;
+            vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, nullptr);
+            if (present_mode_count != 0) {
+                support_details.present_modes.resize(present_mode_count);
+                vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, support_details.present_modes.data());
+            }
+        }
+
+        return support_details;
+    }
+
+    bool PhysicalDeviceCapabilities::supports_extension(const char* extension_name) const {
+        for (const VkExtensionProperties& extension : extensions) {
+            if (std::strcmp(extension_name, extension.extensionName) == 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool SwapchainSupportDetails::is_supported() const {
+        return !formats.empty() && !present_modes.empty();
+    }
+
+    VkSurfaceFormatKHR SwapchainSupportDetails::choose_surface_format() {
+        if (present_modes.size() == 0) {
+            std::cout << "cannot choose surface format from SwapchainSupportDetails as there is nothing in the vector formats\n";
+            std::exit(-1);
+        }
+
+        for (VkSurfaceFormatKHR& format : formats) {
+            if (format.format == VK_FORMAT_B8G8R8A8_SRGB && format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+                return format;
+            }
+        }
+
+        return formats[0];
+    }
+
+    VkPresentModeKHR SwapchainSupportDetails::choose_present_mode(PresentPolicy policy) {
+        if (present_modes.size() == 0) {
+            std::cout << "cannot choose surface present mode from SwapchainSupportDetails as there is nothing in the vector present_modes\n";
+            std::exit(-1);
+        }
+
+        // fifo is the only mode every surface has to support, so it ends every preference list
+        std::vector<VkPresentModeKHR> preferred{};
+        switch (policy) {
+            case PresentPolicy::LowLatency:
+                preferred = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR };
+                break;
+            case PresentPolicy::Throughput:
+                break;
+            default:
+                preferred = { VK_PRESENT_MODE_MAILBOX_KHR };
+                break;
+        }
+
+        for (VkPresentModeKHR preferred_mode : preferred) {
+            if (std::find(present_modes.begin(), present_modes.end(), preferred_mode) != present_modes.end()) {
+                return preferred_mode;
+            }
+        }
+
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+
+    uint32_t SwapchainSupportDetails::choose_image_count(PresentPolicy policy) const {
+        // mailbox needs a spare image to replace queued ones, so low latency can't go below two
+        uint32_t image_count = capabilities.minImageCount + 1; // recommended to go at least one over the minimum
+        if (policy == PresentPolicy::LowLatency) {
+            image_count = std::max(capabilities.minImageCount, 2u);
+        }
+        else if (policy == PresentPolicy::Throughput) {
+            image_count = capabilities.minImageCount + 2;
+        }
+
+        if (capabilities.maxImageCount > 0 && image_count > capabilities.maxImageCount) {
+            image_count = capabilities.maxImageCount;
+        }
+
+        return image_count;
+    }
+
+    VkExtent2D SwapchainSupportDetails::choose_swapchain_extent(VkExtent2D desired_extent) {
+        if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+            return capabilities.currentExtent;
+        }
+
+        VkExtent2D actual_size = desired_extent;
+        actual_size.width = std::clamp(actual_size.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+        actual_size.height = std::clamp(actual_size.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+
+        return actual_size;
+    }
+
+    VulkanDevice::VulkanDevice(Window* window, PresentPolicy present_policy) : m_window(window), m_present_policy(present_policy) {
+        _init();
+    }
+
+    VulkanDevice::VulkanDevice(const HeadlessInfo& headless_info, PresentPolicy present_policy)
+        : m_headless_info(headless_info), m_present_policy(present_policy) {
+        _init();
+    }
+
+    VulkanDevice::~VulkanDevice() {
+#if !defined(NDEBUG)
+        if (m_enable_validation_layers) {
+            if (m_instance_dispatch.vkDestroyDebugUtilsMessengerEXT != nullptr) {
+                m_instance_dispatch.vkDestroyDebugUtilsMessengerEXT(m_instance, m_debug_messenger, get_allocation_callbacks());
+            }
+            else {
+                std::cout << "vkDestroyDebugMessengerEXT function doesn't exist\n";
+            }
+        }
+#endif
+        if (m_pipeline_registry != nullptr) {
+            m_pipeline_registry->print_stats();
+            delete m_pipeline_registry;
+        }
+
+        delete m_bindless_descriptors;
+        delete m_shader_module_cache;
+
+        if (m_pipeline_cache != nullptr) {
+            m_pipeline_cache->save();
+            m_pipeline_cache->print_stats();
+            delete m_pipeline_cache;
+        }
+
+        // the device is idle by now, whatever is still queued goes before the allocator it was allocated from
+        delete m_deletion_queue;
+
+        for (QueueTimeline* timeline : m_timelines) {
+            delete timeline;
+        }
+
+        for (VkFramebuffer& framebuffer : m_framebuffers) {
+            vkDestroyFramebuffer(m_device, framebuffer, get_allocation_callbacks());
+        }
+        vkDestroyRenderPass(m_device, m_render_pass, get_allocation_callbacks());
+
+        vkDestroyImageView(m_device, m_depth_image_view, get_allocation_callbacks());
+        m_allocator->destroy_image(m_depth_image, m_depth_image_allocation);
+
+        for (VkImageView& image_view : m_swapchain_image_views) {
+            vkDestroyImageView(m_device, image_view, get_allocation_callbacks());
+        }
+
+        if (is_offscreen()) {
+            for (size_t i = 0; i < m_swapchain_images.size(); i++) {
+                m_allocator->destroy_image(m_swapchain_images[i], m_offscreen_image_allocations[i]);
+            }
+        }
+        else {
+            vkDestroySwapchainKHR(m_device, m_swapchain, get_allocation_callbacks());
+        }
+
+        m_allocator->print_stats();
+        delete m_allocator;
+
+        vkDestroyDevice(m_device, get_allocation_callbacks());
+
+        if (m_window != nullptr) {
+            m_window->destroy_surface(m_instance, get_allocation_callbacks());
+        }
+        else if (m_surface != nullptr) {
+            vkDestroySurfaceKHR(m_instance, m_surface, get_allocation_callbacks());
+        }
+        vkDestroyInstance(m_instance, get_allocation_callbacks());
+
+        m_host_allocator->print_stats();
+        delete m_host_allocator;
+    }
+
+    uint32_t VulkanDevice::find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties) const {
+        return m_allocator->find_memory_type(type_filter, properties);
+    }
+
+    VkQueue VulkanDevice::get_queue(QueueType type) {
+        switch (type) {
+            case QueueType::Present:
+                return m_present_queue;
+            case QueueType::Compute:
+                return m_compute_queue;
+            case QueueType::Transfer:
+                return m_transfer_queue;
+            default:
+                return m_graphics_queue;
+        }
+    }
+
+    QueueTimeline* VulkanDevice::get_timeline(QueueType type) {
+        VkQueue queue = get_queue(type);
+        for (QueueTimeline* timeline : m_timelines) {
+            if (timeline->get_queue() == queue) {
+                return timeline;
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool VulkanDevice::is_device_extension_enabled(const char* extension_name) const {
+        for (const char* enabled_extension : m_enabled_device_extensions) {
+            if (std::strcmp(enabled_extension, extension_name) == 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool VulkanDevice::recreate_swapchain(uint64_t retire_frame_number) {
+        if (is_offscreen()) {
+            return true;
+        }
+
+        VLK_PROFILE_SCOPE("VulkanDevice::recreate_swapchain");
+
+        // the surface extent follows the window, so this is the one capability that has to be queried again
+        SwapchainSupportDetails& support = m_capabilities.swapchain_support;
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_physical_device, m_surface, &support.capabilities);
+
+        VkExtent2D extent = support.choose_swapchain_extent(_get_desired_extent());
+        if (extent.width == 0 || extent.height == 0) {
+            return false;
+        }
+
+        // queued in the order they have to be destroyed, framebuffers before the views they reference and the swapchain
+        // after the views of its images
+        for (VkFramebuffer framebuffer : m_framebuffers) {
+            m_deletion_queue->destroy_framebuffer(framebuffer, retire_frame_number);
+        }
+        for (VkImageView image_view : m_swapchain_image_views) {
+            m_deletion_queue->destroy_image_view(image_view, retire_frame_number);
+        }
+        m_deletion_queue->destroy_image_view(m_depth_image_view, retire_frame_number);
+        m_deletion_queue->destroy_image(m_depth_image, m_depth_image_allocation, retire_frame_number);
+
+        VkSwapchainKHR old_swapchain = m_swapchain;
+        m_deletion_queue->destroy_swapchain(old_swapchain, retire_frame_number);
+
+        m_swapchain_images.clear();
+        m_swapchain_image_views.clear();
+        m_framebuffers.clear();
+
+        // the format is chosen from the same list as before, so the render pass stays compatible. the old swapchain is
+        // only destroyed by a later collect, so it is still valid here
+        _init_swapchain(old_swapchain);
+        _init_swapchain_images();
+        _init_depth_image();
+        _init_framebuffers();
+
+        return true;
+    }
+
+    VkResult VulkanDevice::acquire_next_image(VkSemaphore image_available, uint32_t* image_index) {
+        if (is_offscreen()) {
+            *image_index = m_offscreen_next_image;
+            m_offscreen_next_image = (m_offscreen_next_image + 1) % get_swapchain_image_count();
+            return VK_SUCCESS;
+        }
+
+        return m_dispatch.vkAcquireNextImageKHR(m_device, m_swapchain, std::numeric_limits<uint64_t>::max(), image_available, VK_NULL_HANDLE, image_index);
+    }
+
+    VkResult VulkanDevice::present(VkSemaphore render_finished, uint32_t image_index) {
+        if (is_offscreen()) {
+            return VK_SUCCESS;
+        }
+
+        VkPresentInfoKHR present_info{};
+        present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        present_info.waitSemaphoreCount = 1;
+        present_info.pWaitSemaphores = &render_finished;
+        present_info.swapchainCount = 1;
+        present_info.pSwapchains = &m_swapchain;
+        present_info.pImageIndices = &image_index;
+
+        return m_dispatch.vkQueuePresentKHR(m_present_queue, &present_info);
+    }
+
+    VkExtent2D VulkanDevice::_get_desired_extent() const {
+        if (is_headless()) {
+            return m_headless_info.extent;
+        }
+
+        int width, height;
+        glfwGetFramebufferSize(m_window->get_internal_window(), &width, &height);
+        return { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+    }
+
+    VkFormat VulkanDevice::_choose_depth_format() const {
+        // in order of preference, the depth has to be sampled as well as rendered to
+        const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT };
+        const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+
+        for (VkFormat format : candidates) {
+            VkFormatProperties properties{};
+            vkGetPhysicalDeviceFormatProperties(m_physical_device, format, &properties);
+
+            if ((properties.optimalTilingFeatures & required) == required) {
+                return format;
+            }
+        }
+
+        std::cout << "failed to find a sampleable depth format\n";
+        std::exit(-1);
+    }
+
+    void VulkanDevice::print_extension_support() const {
+        uint32_t extension_count = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
+        std::vector<VkExtensionProperties> extensions(extension_count);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, extensions.data());
+
+        std::cout << "list of available vulkan extensions that your devices supports:\n";
+        for (const VkExtensionProperties& extension : extensions) {
+            std::cout << "\t* (" << extension.specVersion << "):\t" << extension.extensionName << "\n";
+        }
+    }
+
+    void VulkanDevice::_populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT& create_info) {
+        create_info = {};
+        create_info.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+        create_info.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | 
+            VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+        create_info.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT |
+            VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
+        create_info.pfnUserCallback = debug_call_back;
+    }
+
+    bool VulkanDevice::_check_validation_layer_support() {
+        uint32_t layer_count = 0;
+        vkEnumerateInstanceLayerProperties(&layer_count, nullptr);
+        std::vector<VkLayerProperties> available_layers(layer_count);
+        vkEnumerateInstanceLayerProperties(&layer_count, available_layers.data());
+
+        std::cout << "checking available validation layers\n";
+        bool found_all_layers = true;
+        for (const char* layer_name : m_validation_layers) {
+            bool found_layer = false;
+            size_t layer_length = std::strlen(layer_name);
+
+            for (const VkLayerProperties& layer_property : available_layers) {
+                if (std::strncmp(layer_name, layer_property.layerName, layer_length) == 0) {
+                    found_layer = true;
+                    std::cout << "\t* " << layer_name << " found\n";
+                    break;
+                }
+            }
+
+            if (!found_layer) {
+                std::cout << "failed to find the validation layer: " << layer_name << " in available layers\n";
+                found_all_layers = false;
+            }
+        }
+
+        return found_all_layers;
+    }
+
+    bool VulkanDevice::_check_instance_extension_support(const char* extension_name) {
+        uint32_t extension_count = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
+        std::vector<VkExtensionProperties> extensions(extension_count);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, extensions.data());
+
+        for (const VkExtensionProperties& extension : extensions) {
+            if (std::strcmp(extension_name, extension.extensionName) == 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void VulkanDevice::_init() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init");
+
+        print_extension_support();
+
+        // every object below is created with these callbacks, so the allocator comes before the instance and goes after it
+        m_host_allocator = new HostAllocator();
+
+        _init_instance();
+        _init_debug_manager();
+        _init_surface();
+
+        // offscreen rendering never touches a swapchain, so it shouldn't be a requirement when picking a device
+        if (!is_offscreen()) {
+            m_enabled_device_extensions = m_device_extensions;
+        }
+        m_enabled_device_extensions.insert(m_enabled_device_extensions.end(), m_core_device_extensions.begin(),
+            m_core_device_extensions.end());
+
+        _init_physical_device();
+        _init_logical_device();
+        _init_timelines();
+        _init_allocator();
+
+        if (is_offscreen()) {
+            _init_offscreen_images();
+        }
+        else {
+            _init_swapchain();
+            _init_swapchain_images();
+        }
+
+        _init_depth_image();
+        _init_render_pass();
+        _init_framebuffers();
+        _init_pipeline_cache();
+        _init_bindless_descriptors();
+    }
+
+    void VulkanDevice::_init_instance() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_instance");
+
+        if (m_enable_validation_layers && !_check_validation_layer_support()) {
+            std::cout << "validation layer requested, but not available\n";
+            std::exit(-1);
+        }
+
+        VkApplicationInfo app_info{};
+        app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        app_info.pApplicationName = is_headless() ? "Learning Vulkan (headless)" : m_window->get_title().c_str();
+        app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+        app_info.pEngineName = "No Engine";
+        app_info.apiVersion = VK_API_VERSION_1_2; // timeline semaphores, plus features2 and properties2 from 1.1
+
+        VkInstanceCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        create_info.pApplicationInfo = &app_info;
+
+        std::vector<const char*> required_extensions = get_required_extensions(is_headless());
+        if (is_headless() && m_headless_info.allow_headless_surface && _check_instance_extension_support(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME)) {
+            m_use_headless_surface = true;
+            required_extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+            required_extensions.push_back(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+        }
+
+        create_info.enabledExtensionCount = static_cast<uint32_t>(required_extensions.size());
+        create_info.ppEnabledExtensionNames = required_extensions.data();
+
+        VkDebugUtilsMessengerCreateInfoEXT debug_create_info{};
+        if (m_enable_validation_layers) {
+            create_info.enabledLayerCount = static_cast<uint32_t>(m_validation_layers.size());
+            create_info.ppEnabledLayerNames = m_validation_layers.data();
+
+            _populate_debug_messenger_create_info(debug_create_info);
+            create_info.pNext = static_cast<VkDebugUtilsMessengerCreateInfoEXT*>(&debug_create_info);
+        }
+        else {
+            create_info.enabledLayerCount = 0;
+            create_info.ppEnabledLayerNames = nullptr;
+        }
+
+        if (vkCreateInstance(&create_info, get_allocation_callbacks(), &m_instance) != VK_SUCCESS) {
+            std::cout << "failed to create vulkan instance\n";
+            std::exit(-1);
+        }
+
+        m_instance_dispatch.load(m_instance);
+
+        std::cout << "successfully initialized vulkan instance with the extensions:\n";
+        for (const char* extension : required_extensions) {
+            std::cout << "\t* " << extension << "\n";
+        }
+    }
+
+    void VulkanDevice::_init_debug_manager() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_debug_manager");
+
+#if !defined(NDEBUG)
+        if (!m_enable_validation_layers) {
+            return;
+        }
+
+        VkDebugUtilsMessengerCreateInfoEXT create_info;
+        _populate_debug_messenger_create_info(create_info);
+
+        // it's an extension function, so the loader doesn't export it and it comes from the instance dispatch table
+        if (m_instance_dispatch.vkCreateDebugUtilsMessengerEXT != nullptr) {
+            if (m_instance_dispatch.vkCreateDebugUtilsMessengerEXT(m_instance, &create_info, get_allocation_callbacks(), &m_debug_messenger) != VK_SUCCESS) {
+                std::cout << "failed to call vkCreateDebugUtilsMessengerEXT pointer function\n";
+                std::exit(-1);
+            }
+        }
+        else {
+            std::cout << "vkCreateDebugUtilsMessengerEXT function doesn't exit\n";
+            std::exit(-1);
+        }
+
+        std::cout << "successfully initialized vulkan debug messenger ext\n";
+#endif
+    }
+
+    void VulkanDevice::_init_surface() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_surface");
+
+        if (!is_headless()) {
+            m_window->init_surface(m_instance, get_allocation_callbacks());
+            m_surface = m_window->get_surface();
+            return;
+        }
+
+        if (!m_use_headless_surface) {
+            std::cout << "VK_EXT_headless_surface is unavailable, rendering into offscreen images\n";
+            return;
+        }
+
+        VkHeadlessSurfaceCreateInfoEXT create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+
+        if (m_instance_dispatch.vkCreateHeadlessSurfaceEXT == nullptr ||
+            m_instance_dispatch.vkCreateHeadlessSurfaceEXT(m_instance, &create_info, get_allocation_callbacks(), &m_surface) != VK_SUCCESS) {
+            std::cout << "failed to create vulkan headless surface\n";
+            std::exit(-1);
+        }
+
+        std::cout << "successfully initialized vulkan headless surface\n";
+    }
+
+    void VulkanDevice::_init_physical_device() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_physical_device");
+
+        uint32_t device_count = 0;
+        vkEnumeratePhysicalDevices(m_instance, &device_count, nullptr);
+
+        if (device_count == 0) {
+            std::cout << "failed to find any physical devices capable of vulkan rendering\n";
+            std::exit(-1);
+        }
+
+        std::vector<VkPhysicalDevice> physical_devices(device_count);
+        vkEnumeratePhysicalDevices(m_instance, &device_count, physical_devices.data());
+
+        // every capability query happens exactly once per device in here, scoring and the rest of init read the snapshot
+        PhysicalDeviceCache cache(PhysicalDeviceCache::DEFAULT_PATH);
+
+        std::cout << "physical devices on system:\n";
+        int score_to_beat = 0;
+        for (VkPhysicalDevice physical_device : physical_devices) {
+            PhysicalDeviceCapabilities capabilities = cache.query(physical_device);
+            std::cout << "\t* " << capabilities.properties.deviceName << "\n";
+
+            bool has_required_extensions = true;
+            for (const char* required_extension : m_enabled_device_extensions) {
+                has_required_extensions = has_required_extensions && capabilities.supports_extension(required_extension);
+            }
+
+            if (!has_required_extensions || !capabilities.features.geometryShader || capabilities.properties.apiVersion < VK_API_VERSION_1_2) {
+                continue;
+            }
+
+            capabilities.queue_family_indices = QueueFamilyIndices::query(physical_device, m_surface, capabilities.queue_families);
+            if (!capabilities.queue_family_indices.supports_rendering()) {
+                continue;
+            }
+
+            if (!is_offscreen()) {
+                capabilities.swapchain_support = SwapchainSupportDetails::query(physical_device, m_surface);
+                if (!capabilities.swapchain_support.is_supported()) {
+                    continue;
+                }
+            }
+
+            int score = 0;
+            if (capabilities.properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
+                score += 1000;
+            }
+            score += capabilities.properties.limits.maxImageDimension2D;
+
+            if (score > score_to_beat) {
+                score_to_beat = score;
+                m_physical_device = physical_device;
+                m_capabilities = std::move(capabilities);
+            }
+        }
+
+        cache.save();
+        std::cout << "physical device capabilities: " << cache.get_hits() << " cached, " << cache.get_misses() << " queried\n";
+
+        if (m_physical_device == nullptr) {
+            std::cout << "something serious has happened when picking a physical device, cause this should never be called\n";
+            std::exit(-1);
+        }
+
+        for (const char* optional_extension : m_optional_device_extensions) {
+            if (m_capabilities.supports_extension(optional_extension)) {
+                m_enabled_device_extensions.push_back(optional_extension);
+            }
+        }
+
+        std::cout << "chosen physical device: " << m_capabilities.properties.deviceName << ", extensions enabled:\n";
+        for (const char* extension_name : m_enabled_device_extensions) {
+            std::cout << "\t* " << extension_name << "\n";
+        }
+    }
+
+    void VulkanDevice::_init_logical_device() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_logical_device");
+
+        const QueueFamilyIndices& indices = m_capabilities.queue_family_indices;
+
+        std::vector<VkDeviceQueueCreateInfo> queue_create_infos{};
+        std::set<uint32_t> queue_create_info_ids = {
+            indices.get_family(QueueType::Graphics), indices.get_family(QueueType::Present),
+            indices.get_family(QueueType::Compute), indices.get_family(QueueType::Transfer)
+        };
+
+        for (uint32_t queue_family_id : queue_create_info_ids) {
+            VkDeviceQueueCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            create_info.pQueuePriorities = &indices.priority;
+            create_info.queueFamilyIndex = queue_family_id;
+            create_info.queueCount = 1;
+            queue_create_infos.push_back(create_info);
+        }
+
+        // same policy as the core features, everything descriptor indexing the device supports gets turned on
+        m_descriptor_indexing_features = {};
+        m_descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+        // the 1.2 struct rather than VkPhysicalDeviceVulkan12Features, which can't be chained next to descriptor indexing's
+        m_timeline_semaphore_features = {};
+        m_timeline_semaphore_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        m_descriptor_indexing_features.pNext = &m_timeline_semaphore_features;
+
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &m_descriptor_indexing_features;
+        vkGetPhysicalDeviceFeatures2(m_physical_device, &features);
+        m_timeline_semaphore_features.pNext = nullptr;
+
+        // every submission is synchronized through queue timelines, there is no fence based fallback
+        if (!m_timeline_semaphore_features.timelineSemaphore) {
+            std::cout << "failed to create logical device, timeline semaphores are not supported\n";
+            std::exit(-1);
+        }
+
+        VkDeviceCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        create_info.pNext = &m_descriptor_indexing_features;
+        create_info.pEnabledFeatures = &m_capabilities.features;
+        create_info.pQueueCreateInfos = queue_create_infos.data();
+        create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
+
+        create_info.enabledExtensionCount = static_cast<uint32_t>(m_enabled_device_extensions.size());
+        create_info.ppEnabledExtensionNames = m_enabled_device_extensions.data();
+
+        // for older version of vulkan, newer versions will ignore this parameters
+        if (m_enable_validation_layers) {
+            create_info.enabledLayerCount = static_cast<uint32_t>(m_validation_layers.size());
+            create_info.ppEnabledLayerNames = m_validation_layers.data();
+        }
+        else {
+            create_info.enabledLayerCount = 0;
+        }
+
+        if (vkCreateDevice(m_physical_device, &create_info, get_allocation_callbacks(), &m_device) != VK_SUCCESS) {
+            std::cout << "failed to create logical device\n";
+            std::exit(-1);
+        }
+
+        m_dispatch.load(m_device);
+
+        vkGetDeviceQueue(m_device, indices.graphics_family.value(), 0, &m_graphics_queue);
+        vkGetDeviceQueue(m_device, indices.present_family.value(), 0, &m_present_queue);
+        vkGetDeviceQueue(m_device, indices.get_family(QueueType::Compute), 0, &m_compute_queue);
+        vkGetDeviceQueue(m_device, indices.get_family(QueueType::Transfer), 0, &m_transfer_queue);
+
+        std::cout << "successfully initialized vulkan logical device with queue families:\n";
+        std::cout << "\t* graphics: " << indices.graphics_family.value() << ", present: " << indices.present_family.value() << "\n";
+        std::cout << "\t* compute: " << indices.get_family(QueueType::Compute) << (indices.has_async_compute() ? " (async)" : " (shared with graphics)") << "\n";
+        std::cout << "\t* transfer: " << indices.get_family(QueueType::Transfer) << (indices.has_dedicated_transfer() ? " (dedicated)" : " (shared with graphics)") << "\n";
+    }
+
+    void VulkanDevice::_init_timelines() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_timelines");
+
+        // queue types without a dedicated family resolve to the same VkQueue, those have to share a timeline so values
+        // stay in submission order
+        const QueueType queue_types[] = { QueueType::Graphics, QueueType::Compute, QueueType::Transfer };
+        for (QueueType queue_type : queue_types) {
+            if (get_timeline(queue_type) == nullptr) {
+                m_timelines.push_back(new QueueTimeline(m_device, get_allocation_callbacks(), &m_dispatch, get_queue(queue_type)));
+            }
+        }
+    }
+
+    void VulkanDevice::_init_allocator() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_allocator");
+
+        m_allocator = new VulkanAllocator(m_device, get_allocation_callbacks(), m_capabilities.memory_properties, m_capabilities.properties.limits);
+        m_deletion_queue = new DeletionQueue(m_device, get_allocation_callbacks(), m_allocator);
+        std::cout << "successfully initialized vulkan memory allocator\n";
+    }
+
+    void VulkanDevice::_init_swapchain(VkSwapchainKHR old_swapchain) {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_swapchain");
+
+        SwapchainSupportDetails& support = m_capabilities.swapchain_support;
+
+        m_swapchain_surface_format = support.choose_surface_format();
+        m_swapchain_present_mode = support.choose_present_mode(m_present_policy);
+        m_swapchain_extent = support.choose_swapchain_extent(_get_desired_extent());
+
+        uint32_t image_count = support.choose_image_count(m_present_policy);
+
+        VkSwapchainCreateInfoKHR create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        create_info.surface = m_surface;
+        create_info.minImageCount = image_count;
+        create_info.imageFormat = m_swapchain_surface_format.format;
+        create_info.imageExtent = m_swapchain_extent;
+        create_info.imageArrayLayers = 1; // this should always be 1, unless trying to create stereoscopic 3D applications
+        create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; 
+
+        const QueueFamilyIndices& indices = m_capabilities.queue_family_indices;
+        uint32_t queue_family_indices[] = { indices.graphics_family.value(), indices.present_family.value() };
+
+        if (indices.graphics_family != indices.present_family) {
+            create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+            create_info.queueFamilyIndexCount = 2;
+            create_info.pQueueFamilyIndices = queue_family_indices;
+        }
+        else {
+            create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            create_info.queueFamilyIndexCount = 0;
+            create_info.pQueueFamilyIndices = nullptr;
+        }
+
+        create_info.preTransform = support.capabilities.currentTransform;
+        create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+        create_info.oldSwapchain = old_swapchain;
+
+        create_info.presentMode = m_swapchain_present_mode;
+        create_info.clipped = VK_TRUE;
+
+        if (vkCreateSwapchainKHR(m_device, &create_info, get_allocation_callbacks(), &m_swapchain) != VK_SUCCESS) {
+            std::cout << "failed to create vulkan swapchain\n";
+            std::exit(-1);
+        }
+
+        std::cout << "successfully initialized vulkan swapchain\n";
+    }
+
+    void VulkanDevice::_init_swapchain_images() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_swapchain_images");
+
+        uint32_t swapchain_image_count = 0;
+        vkGetSwapchainImagesKHR(m_device, m_swapchain, &swapchain_image_count, nullptr);
+        m_swapchain_images.resize(swapchain_image_count);
+        vkGetSwapchainImagesKHR(m_device, m_swapchain, &swapchain_image_count, m_swapchain_images.data());
+
+        m_swapchain_image_views.resize(m_swapchain_images.size());
+        for (size_t i = 0; i < m_swapchain_images.size(); i++) {
+            VkImageViewCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            create_info.image = m_swapchain_images[i];
+            create_info.format = m_swapchain_surface_format.format;
+            create_info.viewType =  VK_IMAGE_VIEW_TYPE_2D;
+
+            create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+            create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+            create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+            create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+            // TODO: learn mipmap stuff ...
+            create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            create_info.subresourceRange.baseMipLevel = 0;
+            create_info.subresourceRange.levelCount = 1;
+            create_info.subresourceRange.baseArrayLayer = 0;
+            create_info.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(m_device, &create_info, get_allocation_callbacks(), &m_swapchain_image_views[i]) != VK_SUCCESS) {
+                std::cout << "failed to create image views\n";
+                std::exit(-1);
+            }
+        }
+
+        std::cout << "successfully created swapchain image views\n";
+    }
+
+    void VulkanDevice::_init_offscreen_images() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_offscreen_images");
+
+        m_swapchain_surface_format = { OFFSCREEN_IMAGE_FORMAT, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+        m_swapchain_extent = m_headless_info.extent;
+
+        m_swapchain_images.resize(m_headless_info.image_count);
+        m_offscreen_image_allocations.resize(m_headless_info.image_count);
+        m_swapchain_image_views.resize(m_headless_info.image_count);
+
+        for (uint32_t i = 0; i < m_headless_info.image_count; i++) {
+            VkImageCreateInfo image_create_info{};
+            image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            image_create_info.imageType = VK_IMAGE_TYPE_2D;
+            image_create_info.format = m_swapchain_surface_format.format;
+            image_create_info.extent = { m_swapchain_extent.width, m_swapchain_extent.height, 1 };
+            image_create_info.mipLevels = 1;
+            image_create_info.arrayLayers = 1;
+            image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+            image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+            image_create_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT; // transfer src so frames can be read back
+            image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            m_swapchain_images[i] = m_allocator->create_image(image_create_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_offscreen_image_allocations[i]);
+
+            VkImageViewCreateInfo view_create_info{};
+            view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            view_create_info.image = m_swapchain_images[i];
+            view_create_info.format = m_swapchain_surface_format.format;
+            view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            view_create_info.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+            view_create_info.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+            if (vkCreateImageView(m_device, &view_create_info, get_allocation_callbacks(), &m_swapchain_image_views[i]) != VK_SUCCESS) {
+                std::cout << "failed to create offscreen image views\n";
+                std::exit(-1);
+            }
+        }
+
+        std::cout << "successfully created " << m_headless_info.image_count << " offscreen images\n";
+    }
+
+    void VulkanDevice::_init_depth_image() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_depth_image");
+
+        if (m_depth_format == VK_FORMAT_UNDEFINED) {
+            m_depth_format = _choose_depth_format();
+        }
+
+        VkImageCreateInfo image_create_info{};
+        image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_create_info.imageType = VK_IMAGE_TYPE_2D;
+        image_create_info.format = m_depth_format;
+        image_create_info.extent = { m_swapchain_extent.width, m_swapchain_extent.height, 1 };
+        image_create_info.mipLevels = 1;
+        image_create_info.arrayLayers = 1;
+        image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_create_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        m_depth_image = m_allocator->create_image(image_create_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_depth_image_allocation);
+
+        VkImageViewCreateInfo view_create_info{};
+        view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_create_info.image = m_depth_image;
+        view_create_info.format = m_depth_format;
+        view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_create_info.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+        view_create_info.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+
+        if (vkCreateImageView(m_device, &view_create_info, get_allocation_callbacks(), &m_depth_image_view) != VK_SUCCESS) {
+            std::cout << "failed to create depth image view\n";
+            std::exit(-1);
+        }
+
+        std::cout << "successfully created depth image\n";
+    }
+
+    void VulkanDevice::_init_render_pass() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_render_pass");
+
+        VkAttachmentDescription color_attachment{};
+        color_attachment.format = m_swapchain_surface_format.format;
+        color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // offscreen images are left ready to be copied out instead of presented
+        color_attachment.finalLayout = is_offscreen() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+        // stored and kept in the attachment layout, the render graph moves it in and out of it around the pass and orders
+        // its uses between frames
+        VkAttachmentDescription depth_attachment{};
+        depth_attachment.format = m_depth_format;
+        depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depth_attachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentDescription attachments[] = { color_attachment, depth_attachment };
+
+        VkAttachmentReference color_attachment_ref{};
+        color_attachment_ref.attachment = 0;
+        color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference depth_attachment_ref{};
+        depth_attachment_ref.attachment = 1;
+        depth_attachment_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &color_attachment_ref;
+        subpass.pDepthStencilAttachment = &depth_attachment_ref;
+
+        VkSubpassDependency dependencies[1]{};
+
+        // waits for the image to be released by the presentation engine (image available semaphore) before writing to it.
+        // depth is left out, the render graph records its barriers around the pass
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[0].srcAccessMask = 0;
+        dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+        VkRenderPassCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        create_info.attachmentCount = 2;
+        create_info.pAttachments = attachments;
+        create_info.subpassCount = 1;
+        create_info.pSubpasses = &subpass;
+        create_info.dependencyCount = 1;
+        create_info.pDependencies = dependencies;
+
+        if (vkCreateRenderPass(m_device, &create_info, get_allocation_callbacks(), &m_render_pass) != VK_SUCCESS) {
+            std::cout << "failed to create render pass\n";
+            std::exit(-1);
+        }
+
+        std::cout << "successfully created vulkan render pass\n";
+    }
+
+    void VulkanDevice::_init_framebuffers() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_framebuffers");
+
+        m_framebuffers.resize(m_swapchain_image_views.size());
+        for (size_t i = 0; i < m_swapchain_image_views.size(); i++) {
+            VkImageView attachments[] = { m_swapchain_image_views[i], m_depth_image_view };
+
+            VkFramebufferCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            create_info.renderPass = m_render_pass;
+            create_info.attachmentCount = 2;
+            create_info.pAttachments = attachments;
+            create_info.width = m_swapchain_extent.width;
+            create_info.height = m_swapchain_extent.height;
+            create_info.layers = 1;
+
+            if (vkCreateFramebuffer(m_device, &create_info, get_allocation_callbacks(), &m_framebuffers[i]) != VK_SUCCESS) {
+                std::cout << "failed to create framebuffer\n";
+                std::exit(-1);
+            }
+        }
+
+        std::cout << "successfully created swapchain framebuffers\n";
+    }
+
+    void VulkanDevice::_init_pipeline_cache() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_pipeline_cache");
+
+        m_pipeline_cache = new VulkanPipelineCache(m_device, get_allocation_callbacks(), m_capabilities.properties, VulkanPipelineCache::DEFAULT_PATH,
+            is_device_extension_enabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME));
+        m_shader_module_cache = new VulkanShaderModuleCache(m_device, get_allocation_callbacks());
+        m_pipeline_registry = new VulkanPipelineRegistry(m_device, get_allocation_callbacks(), m_pipeline_cache);
+    }
+
+    void VulkanDevice::_init_bindless_descriptors() {
+        VLK_PROFILE_SCOPE("VulkanDevice::_init_bindless_descriptors");
+
+        m_bindless_descriptors = new BindlessDescriptors(this);
+    }
+
+}
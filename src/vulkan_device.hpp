@@ -1,103 +1,296 @@
-#ifndef __VULKAN_DEVICE_HPP__
-#define __VULKAN_DEVICE_HPP__
-
-#include "window.hpp"
-#include <vulkan/vulkan.h>
-#include <vector>
-#include <optional>
-
-namespace vlk {
-
-    struct QueueFamilyIndices {
-        float priority{ 1.0f };
-        std::optional<uint32_t> graphics_family{};
-        std::optional<uint32_t> present_family{};
-
-        static QueueFamilyIndices query(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
-
-        inline bool supports_rendering() const {
-            return graphics_family.has_value() && present_family.has_value();
-        }
-    };
-
-    struct SwapchainSupportDetails {
-        VkSurfaceCapabilitiesKHR capabilities{};
-        std::vector<VkSurfaceFormatKHR> formats{};
-        std::vector<VkPresentModeKHR> present_modes{};
-
-        static SwapchainSupportDetails query(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
-
-        bool is_supported() const;
-        VkSurfaceFormatKHR choose_surface_format();
-        VkPresentModeKHR choose_present_mode();
-        VkExtent2D choose_swapchain_extent(Window* window);
-    };
-
-    class VulkanDevice {
-    public:
-        static std::vector<const char*> get_required_extensions();
-
-        VulkanDevice(Window* window);
-        ~VulkanDevice();
-
-        inline VkInstance get_instance() { return m_instance; }
-        inline VkDevice get_device() { return m_device; }
-        inline VkPhysicalDevice get_physical_device() { return m_physical_device; }
-        inline VkSwapchainKHR get_swapchain() { return m_swapchain; }
-        inline VkQueue get_graphics_queue() { return m_graphics_queue; }
-        inline VkQueue get_present_mode_queue() { return m_present_queue; }
-
-        inline const VkInstance get_instance() const { return m_instance; }
-        inline const VkDevice get_device() const { return m_device; }
-        inline const VkPhysicalDevice get_physical_device() const { return m_physical_device; }
-        inline const VkSwapchainKHR get_swapchain() const { return m_swapchain; }
-        inline const VkExtent2D& get_swapchain_extent() const { return m_swapchain_extent; }
-        inline const VkQueue get_graphics_queue() const { return m_graphics_queue; }
-        inline const VkQueue get_present_mode_queue() const { return m_present_queue; }
-        inline const VkPhysicalDeviceFeatures& get_physical_device_features() const { return m_physical_device_features; }
-
-        void print_extension_support() const;
-        void terminate();
-
-    private:
-        static void _populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT& create_info);
-        static bool _check_validation_layer_support();
-        static bool _check_physical_device_required_extensions_support(VkPhysicalDevice physical_device);
-
-        // initialization functions
-        void _init_instance();
-        void _init_debug_manager();
-        void _init_physical_device();
-        void _init_logical_device();
-        void _init_swapchain();
-        void _init_swapchain_images();
-
-    private:
-        static bool m_enable_validation_layers;
-        static std::vector<const char*> m_validation_layers;
-        static std::vector<const char*> m_device_extensions;
-
-        Window* m_window{ nullptr };
-        VkInstance m_instance{ nullptr };
-
-        VkPhysicalDevice m_physical_device{ nullptr };
-        VkPhysicalDeviceFeatures m_physical_device_features;
-        VkDevice m_device{ nullptr };
-        VkQueue m_graphics_queue{ nullptr };
-        VkQueue m_present_queue{ nullptr };
-
-        VkSwapchainKHR m_swapchain{ nullptr };
-        VkSurfaceFormatKHR m_swapchain_surface_format{};
-        VkPresentModeKHR m_swapchain_present_mode{};
-        VkExtent2D m_swapchain_extent{};
-        std::vector<VkImage> m_swapchain_images{};
-        std::vector<VkImageView> m_swapchain_image_views{};
-
-#if !defined(NDEBUG)
-        VkDebugUtilsMessengerEXT m_debug_messenger{ nullptr };
-#endif 
-    };
-
-}
-
+#ifndef __VULKAN_DEVICE_HPP__
+#define __VULKAN_DEVICE_HPP__
+
+#include "window.hpp"
+#include "vulkan_pipeline_cache.hpp"
+#include "vulkan_pipeline_registry.hpp"
+#include "vulkan_shader_module_cache.hpp"
+#include "vulkan_allocator.hpp"
+#include "deletion_queue.hpp"
+#include "host_allocator.hpp"
+#include "queue_timeline.hpp"
+#include "vulkan_dispatch.hpp"
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <optional>
+
+namespace vlk {
+
+    enum class QueueType {
+        Graphics,
+        Present,
+        Compute,
+        Transfer,
+    };
+
+    // how the swapchain trades latency against throughput
+    enum class PresentPolicy {
+        LowLatency,     // immediate or mailbox with as few images as the surface allows
+        Balanced,       // mailbox when available, one image over the minimum
+        Throughput,     // fifo with deeper queueing, never tears and never drops a frame
+    };
+
+    struct QueueFamilyIndices {
+        float priority{ 1.0f };
+        std::optional<uint32_t> graphics_family{};
+        std::optional<uint32_t> present_family{};
+        std::optional<uint32_t> compute_family{};   // only set for a compute family without graphics (async compute)
+        std::optional<uint32_t> transfer_family{};  // only set for a transfer family without graphics or compute (dma engine)
+
+        // when surface is null there is nothing to present to, so the graphics family doubles as the present family
+        static QueueFamilyIndices query(VkPhysicalDevice physical_device, VkSurfaceKHR surface,
+            const std::vector<VkQueueFamilyProperties>& queue_families);
+
+        inline bool supports_rendering() const {
+            return graphics_family.has_value() && present_family.has_value();
+        }
+
+        inline bool has_async_compute() const { return compute_family.has_value(); }
+        inline bool has_dedicated_transfer() const { return transfer_family.has_value(); }
+
+        // falls back to the graphics family when there is no dedicated family of that type
+        uint32_t get_family(QueueType type) const;
+    };
+
+    // moves an exclusively owned resource between queue families. the release barrier is recorded on the source queue, the
+    // matching acquire barrier (identical apart from the access masks) on the destination queue, and the acquire must be
+    // submitted after the release, usually by waiting on a semaphore or fence signaled by the release submission
+    struct QueueOwnershipTransfer {
+        uint32_t src_family{ VK_QUEUE_FAMILY_IGNORED };
+        uint32_t dst_family{ VK_QUEUE_FAMILY_IGNORED };
+
+        inline bool is_required() const { return src_family != dst_family; }
+
+        VkBufferMemoryBarrier buffer_barrier(VkBuffer buffer, VkAccessFlags src_access, VkAccessFlags dst_access,
+            VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+        VkImageMemoryBarrier image_barrier(VkImage image, const VkImageSubresourceRange& range, VkImageLayout old_layout,
+            VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access) const;
+    };
+
+    struct SwapchainSupportDetails {
+        VkSurfaceCapabilitiesKHR capabilities{};
+        std::vector<VkSurfaceFormatKHR> formats{};
+        std::vector<VkPresentModeKHR> present_modes{};
+
+        static SwapchainSupportDetails query(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
+
+        bool is_supported() const;
+        VkSurfaceFormatKHR choose_surface_format();
+        VkPresentModeKHR choose_present_mode(PresentPolicy policy);
+        uint32_t choose_image_count(PresentPolicy policy) const;
+        VkExtent2D choose_swapchain_extent(VkExtent2D desired_extent);
+    };
+
+    // everything device selection and the rest of init need to know about a physical device, queried once per device.
+    // the surface independent half can come from the PhysicalDeviceCache instead of the driver
+    struct PhysicalDeviceCapabilities {
+        VkPhysicalDevice physical_device{ nullptr };
+        VkPhysicalDeviceProperties properties{};
+        VkPhysicalDeviceFeatures features{};
+        VkPhysicalDeviceMemoryProperties memory_properties{};
+        std::vector<VkQueueFamilyProperties> queue_families{};
+        std::vector<VkExtensionProperties> extensions{};
+
+        // depend on the surface, so they are filled in every launch and never cached
+        QueueFamilyIndices queue_family_indices{};
+        SwapchainSupportDetails swapchain_support{};
+
+        bool supports_extension(const char* extension_name) const;
+    };
+
+    struct HeadlessInfo {
+        VkExtent2D extent{ 800, 600 };
+        uint32_t image_count{ 3 };
+        bool allow_headless_surface{ true }; // use VK_EXT_headless_surface when the driver has it, otherwise render offscreen
+    };
+
+    class BindlessDescriptors;
+
+    class VulkanDevice {
+    public:
+        static constexpr VkFormat OFFSCREEN_IMAGE_FORMAT = VK_FORMAT_B8G8R8A8_SRGB;
+
+        static std::vector<const char*> get_required_extensions(bool headless);
+
+        VulkanDevice(Window* window, PresentPolicy present_policy = PresentPolicy::Balanced);
+        VulkanDevice(const HeadlessInfo& headless_info, PresentPolicy present_policy = PresentPolicy::Balanced);
+        ~VulkanDevice();
+
+        inline VkInstance get_instance() { return m_instance; }
+        inline VkDevice get_device() { return m_device; }
+        inline VkPhysicalDevice get_physical_device() { return m_physical_device; }
+        inline VkSwapchainKHR get_swapchain() { return m_swapchain; }
+        inline VkQueue get_graphics_queue() { return m_graphics_queue; }
+        inline VkQueue get_present_mode_queue() { return m_present_queue; }
+        inline VkQueue get_compute_queue() { return m_compute_queue; }
+        inline VkQueue get_transfer_queue() { return m_transfer_queue; }
+
+        inline const VkInstance get_instance() const { return m_instance; }
+        // hot calls go through these instead of the loader, see vulkan_dispatch.hpp
+        inline const VulkanInstanceDispatch& get_instance_dispatch() const { return m_instance_dispatch; }
+        inline const VulkanDeviceDispatch& get_dispatch() const { return m_dispatch; }
+        inline const VkDevice get_device() const { return m_device; }
+        inline const VkPhysicalDevice get_physical_device() const { return m_physical_device; }
+        inline const VkSwapchainKHR get_swapchain() const { return m_swapchain; }
+        inline const VkExtent2D& get_swapchain_extent() const { return m_swapchain_extent; }
+        inline VkPresentModeKHR get_swapchain_present_mode() const { return m_swapchain_present_mode; }
+        inline PresentPolicy get_present_policy() const { return m_present_policy; }
+        inline const VkQueue get_graphics_queue() const { return m_graphics_queue; }
+        inline const VkQueue get_present_mode_queue() const { return m_present_queue; }
+        inline const VkQueue get_compute_queue() const { return m_compute_queue; }
+        inline const VkQueue get_transfer_queue() const { return m_transfer_queue; }
+        inline const PhysicalDeviceCapabilities& get_physical_device_capabilities() const { return m_capabilities; }
+        inline const VkPhysicalDeviceFeatures& get_physical_device_features() const { return m_capabilities.features; }
+        inline const VkPhysicalDeviceProperties& get_physical_device_properties() const { return m_capabilities.properties; }
+        inline const VkPhysicalDeviceDescriptorIndexingFeaturesEXT& get_descriptor_indexing_features() const { return m_descriptor_indexing_features; }
+        inline VulkanPipelineCache* get_pipeline_cache() { return m_pipeline_cache; }
+        inline const VulkanPipelineCache* get_pipeline_cache() const { return m_pipeline_cache; }
+        inline VulkanPipelineRegistry* get_pipeline_registry() { return m_pipeline_registry; }
+        inline const VulkanPipelineRegistry* get_pipeline_registry() const { return m_pipeline_registry; }
+        inline VulkanAllocator* get_allocator() { return m_allocator; }
+        inline const VulkanAllocator* get_allocator() const { return m_allocator; }
+        inline DeletionQueue* get_deletion_queue() { return m_deletion_queue; }
+        // host memory for every vulkan object the application creates, pass to each create and destroy call
+        inline const VkAllocationCallbacks* get_allocation_callbacks() const { return m_host_allocator->get_callbacks(); }
+        inline const HostAllocator* get_host_allocator() const { return m_host_allocator; }
+        inline VulkanShaderModuleCache* get_shader_module_cache() { return m_shader_module_cache; }
+        inline const VulkanShaderModuleCache* get_shader_module_cache() const { return m_shader_module_cache; }
+        inline BindlessDescriptors* get_bindless_descriptors() { return m_bindless_descriptors; }
+        inline const BindlessDescriptors* get_bindless_descriptors() const { return m_bindless_descriptors; }
+        inline const VkSurfaceFormatKHR& get_swapchain_surface_format() const { return m_swapchain_surface_format; }
+        inline const std::vector<VkImageView>& get_swapchain_image_views() const { return m_swapchain_image_views; }
+        inline uint32_t get_swapchain_image_count() const { return static_cast<uint32_t>(m_swapchain_images.size()); }
+        inline VkRenderPass get_render_pass() { return m_render_pass; }
+        inline const VkRenderPass get_render_pass() const { return m_render_pass; }
+        inline VkFormat get_depth_format() const { return m_depth_format; }
+        inline VkImage get_depth_image() { return m_depth_image; }
+        inline const VkImage get_depth_image() const { return m_depth_image; }
+        inline VkImageView get_depth_image_view() { return m_depth_image_view; }
+        inline const VkImageView get_depth_image_view() const { return m_depth_image_view; }
+        inline VkFramebuffer get_framebuffer(uint32_t image_index) { return m_framebuffers[image_index]; }
+        inline const VkFramebuffer get_framebuffer(uint32_t image_index) const { return m_framebuffers[image_index]; }
+        inline const QueueFamilyIndices& get_queue_family_indices() const { return m_capabilities.queue_family_indices; }
+
+        // headless devices either present to a VK_EXT_headless_surface or render into device owned offscreen images,
+        // in which case there is no swapchain and nothing to present
+        inline bool is_headless() const { return m_window == nullptr; }
+        inline bool is_offscreen() const { return m_surface == nullptr; }
+
+        uint32_t find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties) const;
+        bool is_device_extension_enabled(const char* extension_name) const;
+
+        // queues without a dedicated family resolve to the graphics queue
+        VkQueue get_queue(QueueType type);
+        // every submission signals its queue's timeline, queue types sharing a VkQueue share one. present has no timeline
+        // of its own unless it is the graphics queue
+        QueueTimeline* get_timeline(QueueType type);
+        inline uint32_t get_queue_family(QueueType type) const { return m_capabilities.queue_family_indices.get_family(type); }
+        inline QueueOwnershipTransfer get_ownership_transfer(QueueType src, QueueType dst) const {
+            return { get_queue_family(src), get_queue_family(dst) };
+        }
+
+        // rebuilds the swapchain for the surface's current extent, passing the old one as oldSwapchain so presentation
+        // carries on. the old swapchain, image views and framebuffers may still be in use by frames already submitted, so
+        // they go to the deletion queue and are destroyed once every frame before retire_frame_number has finished.
+        // returns false without touching anything while the window is minimized
+        bool recreate_swapchain(uint64_t retire_frame_number);
+        inline bool consume_window_resize() { return m_window != nullptr && m_window->consume_resized(); }
+
+        // offscreen devices hand out their images round robin, image_available is left unsignaled and presenting is a no-op
+        VkResult acquire_next_image(VkSemaphore image_available, uint32_t* image_index);
+        VkResult present(VkSemaphore render_finished, uint32_t image_index);
+
+        void print_extension_support() const;
+        void terminate();
+
+    private:
+        VkFormat _choose_depth_format() const;
+
+        VkExtent2D _get_desired_extent() const;
+
+        static void _populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT& create_info);
+        static bool _check_validation_layer_support();
+        static bool _check_instance_extension_support(const char* extension_name);
+
+        void _init();
+
+        // initialization functions
+        void _init_instance();
+        void _init_debug_manager();
+        void _init_surface();
+        void _init_physical_device();
+        void _init_logical_device();
+        void _init_timelines();
+        void _init_allocator();
+        void _init_swapchain(VkSwapchainKHR old_swapchain = VK_NULL_HANDLE);
+        void _init_swapchain_images();
+        void _init_offscreen_images();
+        void _init_depth_image();
+        void _init_render_pass();
+        void _init_framebuffers();
+        void _init_pipeline_cache();
+        void _init_bindless_descriptors();
+
+    private:
+        static bool m_enable_validation_layers;
+        static std::vector<const char*> m_validation_layers;
+        static std::vector<const char*> m_device_extensions;
+        static std::vector<const char*> m_core_device_extensions;     // required even when offscreen
+        static std::vector<const char*> m_optional_device_extensions; // enabled when the chosen physical device supports them
+
+        Window* m_window{ nullptr };
+        HeadlessInfo m_headless_info{};
+        PresentPolicy m_present_policy{ PresentPolicy::Balanced };
+        HostAllocator* m_host_allocator{ nullptr };
+        VkInstance m_instance{ nullptr };
+        VulkanInstanceDispatch m_instance_dispatch{};
+        VkSurfaceKHR m_surface{ nullptr };
+        bool m_use_headless_surface{ false };
+        std::vector<const char*> m_enabled_device_extensions{};
+
+        VkPhysicalDevice m_physical_device{ nullptr };
+        PhysicalDeviceCapabilities m_capabilities{}; // snapshot of m_physical_device, read by every init step after selection
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT m_descriptor_indexing_features{}; // as enabled on m_device
+        VkPhysicalDeviceTimelineSemaphoreFeatures m_timeline_semaphore_features{};
+        VkDevice m_device{ nullptr };
+        VulkanDeviceDispatch m_dispatch{};
+        VkQueue m_graphics_queue{ nullptr };
+        VkQueue m_present_queue{ nullptr };
+        VkQueue m_compute_queue{ nullptr };     // graphics queue when there is no async compute family
+        VkQueue m_transfer_queue{ nullptr };    // graphics queue when there is no dedicated transfer family
+
+        VkSwapchainKHR m_swapchain{ nullptr };
+        VkSurfaceFormatKHR m_swapchain_surface_format{};
+        VkPresentModeKHR m_swapchain_present_mode{};
+        VkExtent2D m_swapchain_extent{};
+        std::vector<VkImage> m_swapchain_images{};
+        std::vector<VkImageView> m_swapchain_image_views{};
+        std::vector<VulkanAllocation> m_offscreen_image_allocations{}; // only used when is_offscreen()
+        uint32_t m_offscreen_next_image{ 0 };
+
+        // one depth image is shared by every frame, the render graph orders its uses and moves it to a readable layout
+        // for anything sampling it after the pass, e.g. to build a hi-z pyramid
+        VkFormat m_depth_format{ VK_FORMAT_UNDEFINED };
+        VkImage m_depth_image{ nullptr };
+        VulkanAllocation m_depth_image_allocation{};
+        VkImageView m_depth_image_view{ nullptr };
+
+        VkRenderPass m_render_pass{ nullptr };
+        std::vector<VkFramebuffer> m_framebuffers{};
+
+        VulkanAllocator* m_allocator{ nullptr };
+        DeletionQueue* m_deletion_queue{ nullptr };
+        std::vector<QueueTimeline*> m_timelines{};
+        VulkanPipelineCache* m_pipeline_cache{ nullptr };
+        VulkanPipelineRegistry* m_pipeline_registry{ nullptr };
+        VulkanShaderModuleCache* m_shader_module_cache{ nullptr };
+        BindlessDescriptors* m_bindless_descriptors{ nullptr };
+
+#if !defined(NDEBUG)
+        VkDebugUtilsMessengerEXT m_debug_messenger{ nullptr };
+#endif 
+    };
+
+}
+
 #endif // __VULKAN_DEVICE_HPP__
\ No newline at end of file
@@ -0,0 +1,28 @@
+#include "vulkan_dispatch.hpp"
+
+#include <iostream>
+
+namespace vlk {
+
+    void VulkanInstanceDispatch::load(VkInstance instance) {
+#define VLK_LOAD_FUNCTION(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(instance, #name));
+        VLK_INSTANCE_FUNCTIONS(VLK_LOAD_FUNCTION)
+#undef VLK_LOAD_FUNCTION
+    }
+
+    void VulkanDeviceDispatch::load(VkDevice device) {
+        uint32_t loaded_count = 0;
+        uint32_t function_count = 0;
+
+#define VLK_LOAD_FUNCTION(name) \
+        name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name)); \
+        loaded_count += name != nullptr ? 1 : 0; \
+        function_count++;
+        VLK_DEVICE_FUNCTIONS(VLK_LOAD_FUNCTION)
+#undef VLK_LOAD_FUNCTION
+
+        // the swapchain functions are missing on offscreen devices, which never call them
+        std::cout << "successfully loaded " << loaded_count << " of " << function_count << " device functions\n";
+    }
+
+}
@@ -0,0 +1,65 @@
+#ifndef __VULKAN_DISPATCH_HPP__
+#define __VULKAN_DISPATCH_HPP__
+
+#include <vulkan/vulkan.h>
+
+namespace vlk {
+
+    // extension entry points the loader doesn't export, fetched once the instance exists
+#define VLK_INSTANCE_FUNCTIONS(X) \
+    X(vkCreateDebugUtilsMessengerEXT) \
+    X(vkDestroyDebugUtilsMessengerEXT) \
+    X(vkCreateHeadlessSurfaceEXT)
+
+    // everything called per frame or per draw. going through vkGetDeviceProcAddr skips the loader's trampoline, which
+    // has to look up the dispatch table hidden in the handle on every call. create and destroy calls aren't worth it
+#define VLK_DEVICE_FUNCTIONS(X) \
+    X(vkAcquireNextImageKHR) \
+    X(vkQueuePresentKHR) \
+    X(vkQueueSubmit) \
+    X(vkWaitSemaphores) \
+    X(vkGetSemaphoreCounterValue) \
+    X(vkGetQueryPoolResults) \
+    X(vkUpdateDescriptorSets) \
+    X(vkResetCommandPool) \
+    X(vkBeginCommandBuffer) \
+    X(vkEndCommandBuffer) \
+    X(vkCmdBeginRenderPass) \
+    X(vkCmdEndRenderPass) \
+    X(vkCmdExecuteCommands) \
+    X(vkCmdPipelineBarrier) \
+    X(vkCmdBindPipeline) \
+    X(vkCmdBindDescriptorSets) \
+    X(vkCmdBindVertexBuffers) \
+    X(vkCmdBindIndexBuffer) \
+    X(vkCmdPushConstants) \
+    X(vkCmdSetViewport) \
+    X(vkCmdSetScissor) \
+    X(vkCmdDrawIndexedIndirect) \
+    X(vkCmdDispatch) \
+    X(vkCmdCopyBuffer) \
+    X(vkCmdCopyBufferToImage) \
+    X(vkCmdResetQueryPool) \
+    X(vkCmdWriteTimestamp)
+
+#define VLK_DECLARE_FUNCTION(name) PFN_##name name{ nullptr };
+
+    // entries stay null when the driver doesn't have them, e.g. extensions that weren't enabled
+    struct VulkanInstanceDispatch {
+        VLK_INSTANCE_FUNCTIONS(VLK_DECLARE_FUNCTION)
+
+        void load(VkInstance instance);
+    };
+
+    // only valid for the device it was loaded from, and for command buffers and queues belonging to it
+    struct VulkanDeviceDispatch {
+        VLK_DEVICE_FUNCTIONS(VLK_DECLARE_FUNCTION)
+
+        void load(VkDevice device);
+    };
+
+#undef VLK_DECLARE_FUNCTION
+
+}
+
+#endif // __VULKAN_DISPATCH_HPP__
@@ -1,34 +1,76 @@
-#ifndef __VULKAN_PIPELINE_HPP__
-#define __VULKAN_PIPELINE_HPP__
-
-#include "vulkan_device.hpp"
-
-#include <string_view>
-#include <vector>
-
-namespace vlk {
-
-    class VulkanPipeline {
-    public:
-        VulkanPipeline(VulkanDevice* device);
-        ~VulkanPipeline();
-
-        inline static std::vector<VkDynamicState> get_dynamic_states() { return m_dynamic_states; }
-        inline VkPipelineLayout get_layout() { return m_layout; }
-        inline const VkPipelineLayout get_layout() const { return m_layout; }
-
-        std::vector<const char*> read_shader_source(std::string_view shader_path);
-        VkShaderModule create_shader_module(const std::vector<const char*>& shader_source);
-
-    private:
-        void _init_pipeline_layout();
-
-        static std::vector<VkDynamicState> m_dynamic_states;
-
-        VulkanDevice* m_device{ nullptr };
-        VkPipelineLayout m_layout{ nullptr };
-    };
-
-}
-
-#endif // __VULKAN_PIPELINE_HPP__
\ No newline at end of file
+#ifndef __VULKAN_PIPELINE_HPP__
+#define __VULKAN_PIPELINE_HPP__
+
+#include "vulkan_device.hpp"
+#include "vulkan_pipeline_registry.hpp"
+#include "thread_pool.hpp"
+
+#include <cstdint>
+
+namespace vlk {
+
+    // per frame state for the vertex shader, allocated from the renderer's uniform ring and read from set 1. laid out to
+    // match the std140 block in simple_shader.vert
+    struct FrameUniforms {
+        float view_projection[16]{}; // column major
+        float near_plane{ 0.0f };
+        float far_plane{ 0.0f };
+        float padding[2]{};
+    };
+
+    // per draw state for the vertex shader, small enough to live in push constants
+    struct DrawPushConstants {
+        uint32_t draw_instance_buffer{ 0 }; // bindless storage buffer slot of the DrawInstance array
+    };
+
+    // SHADING_MODE specialization constant of simple_shader.frag
+    enum class ShadingMode : uint32_t {
+        VertexColor = 0,
+        Depth = 1,          // linear view depth, handy for checking what the hi-z pyramid is built from
+    };
+
+    // the scene's graphics pipeline. the pipeline and its layout come from the device's pipeline registry, so any number of
+    // these with the same settings share one VkPipeline and nothing is destroyed with them
+    class VulkanPipeline {
+    public:
+        // uniform_set_layout is the layout of set 1, the renderer's uniform ring. without a compile pool the pipeline is
+        // created before this returns, with one it compiles in the background and fallback (which has to share the layout)
+        // is drawn with until then, or nothing at all without a fallback
+        VulkanPipeline(VulkanDevice* device, VkDescriptorSetLayout uniform_set_layout, ShadingMode shading = ShadingMode::VertexColor,
+            ThreadPool* compile_pool = nullptr, const VulkanPipeline* fallback = nullptr);
+
+        inline VkPipelineLayout get_layout() const { return m_layout; }
+        // null while a background compile is still running
+        inline VkPipeline get_pipeline() const { return m_pipeline; }
+        inline bool is_ready() const { return m_pipeline != nullptr; }
+        inline const GraphicsPipelineDescription& get_description() const { return m_description; }
+
+        // picks what bind uses for the frame about to be recorded, once per frame before any recording thread starts.
+        // returns whether the pipeline itself is ready
+        bool resolve();
+
+        // binds the pipeline (or the fallback) and the device's bindless descriptor set, once per command buffer is enough.
+        // returns false when there is nothing to draw with yet and the draws should be skipped
+        bool bind(VkCommandBuffer command_buffer);
+        void push_constants(VkCommandBuffer command_buffer, const DrawPushConstants& constants);
+
+    private:
+        void _init_pipeline_layout(VkDescriptorSetLayout uniform_set_layout);
+        void _init_pipeline(ShadingMode shading);
+
+        VulkanPipeline(const VulkanPipeline& other) = delete;
+        VulkanPipeline& operator=(const VulkanPipeline& other) = delete;
+
+        VulkanDevice* m_device{ nullptr };
+        const VulkanDeviceDispatch* m_dispatch{ nullptr };
+        ThreadPool* m_compile_pool{ nullptr };
+        const VulkanPipeline* m_fallback{ nullptr };
+        GraphicsPipelineDescription m_description{};
+        VkPipelineLayout m_layout{ nullptr };
+        VkPipeline m_pipeline{ nullptr };
+        VkPipeline m_bound_pipeline{ nullptr };  // m_pipeline or the fallback's, chosen by resolve
+    };
+
+}
+
+#endif // __VULKAN_PIPELINE_HPP__
@@ -0,0 +1,239 @@
+#include "vulkan_pipeline_cache.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace vlk {
+
+    static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    VulkanPipelineCache::VulkanPipelineCache(VkDevice device, const VkAllocationCallbacks* allocation_callbacks, const VkPhysicalDeviceProperties& properties,
+        std::string path, bool creation_feedback)
+        : m_device(device), m_allocation_callbacks(allocation_callbacks), m_properties(properties), m_path(std::move(path)), m_creation_feedback(creation_feedback) {
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<uint8_t> initial_data = _load_validated_data();
+
+        // no VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT, the driver locks the cache itself so compile workers
+        // can all create pipelines through it at once
+        VkPipelineCacheCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        create_info.initialDataSize = initial_data.size();
+        create_info.pInitialData = initial_data.empty() ? nullptr : initial_data.data();
+
+        VkResult result = vkCreatePipelineCache(m_device, &create_info, m_allocation_callbacks, &m_cache);
+        if (result != VK_SUCCESS && !initial_data.empty()) {
+            // the header matched but the driver still didn't like the blob, start from an empty cache instead
+            std::cout << "pipeline cache \"" << m_path << "\" was rejected by the driver, starting cold\n";
+            initial_data.clear();
+            create_info.initialDataSize = 0;
+            create_info.pInitialData = nullptr;
+            result = vkCreatePipelineCache(m_device, &create_info, m_allocation_callbacks, &m_cache);
+        }
+
+        if (result != VK_SUCCESS) {
+            std::cout << "failed to create pipeline cache\n";
+            std::exit(-1);
+        }
+
+        m_stats.loaded_from_disk = !initial_data.empty();
+        m_stats.loaded_size = initial_data.size();
+        m_stats.load_ms = elapsed_ms(start);
+
+        std::cout << "successfully initialized pipeline cache (" << (m_stats.loaded_from_disk ? "warm, " : "cold, ")
+            << m_stats.loaded_size << " bytes)\n";
+    }
+
+    VulkanPipelineCache::~VulkanPipelineCache() {
+        vkDestroyPipelineCache(m_device, m_cache, m_allocation_callbacks);
+    }
+
+    VkResult VulkanPipelineCache::create_graphics_pipelines(uint32_t create_info_count, const VkGraphicsPipelineCreateInfo* create_infos, VkPipeline* pipelines) {
+        std::vector<VkGraphicsPipelineCreateInfo> chained_create_infos(create_infos, create_infos + create_info_count);
+        std::vector<VkPipelineCreationFeedbackEXT> pipeline_feedbacks(create_info_count);
+        std::vector<std::vector<VkPipelineCreationFeedbackEXT>> stage_feedbacks(create_info_count);
+        std::vector<VkPipelineCreationFeedbackCreateInfoEXT> feedback_create_infos(create_info_count);
+
+        if (m_creation_feedback) {
+            for (uint32_t i = 0; i < create_info_count; i++) {
+                stage_feedbacks[i].resize(chained_create_infos[i].stageCount);
+
+                feedback_create_infos[i].sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+                feedback_create_infos[i].pNext = chained_create_infos[i].pNext;
+                feedback_create_infos[i].pPipelineCreationFeedback = &pipeline_feedbacks[i];
+                feedback_create_infos[i].pipelineStageCreationFeedbackCount = chained_create_infos[i].stageCount;
+                feedback_create_infos[i].pPipelineStageCreationFeedbacks = stage_feedbacks[i].data();
+
+                chained_create_infos[i].pNext = &feedback_create_infos[i];
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        VkResult result = vkCreateGraphicsPipelines(m_device, m_cache, create_info_count, chained_create_infos.data(), m_allocation_callbacks, pipelines);
+        double duration_ms = elapsed_ms(start);
+
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+
+        _record_feedback(pipeline_feedbacks, duration_ms);
+        return result;
+    }
+
+    VkResult VulkanPipelineCache::create_compute_pipelines(uint32_t create_info_count, const VkComputePipelineCreateInfo* create_infos, VkPipeline* pipelines) {
+        std::vector<VkComputePipelineCreateInfo> chained_create_infos(create_infos, create_infos + create_info_count);
+        std::vector<VkPipelineCreationFeedbackEXT> pipeline_feedbacks(create_info_count);
+        std::vector<VkPipelineCreationFeedbackEXT> stage_feedbacks(create_info_count); // compute pipelines have exactly one stage
+        std::vector<VkPipelineCreationFeedbackCreateInfoEXT> feedback_create_infos(create_info_count);
+
+        if (m_creation_feedback) {
+            for (uint32_t i = 0; i < create_info_count; i++) {
+                feedback_create_infos[i].sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+                feedback_create_infos[i].pNext = chained_create_infos[i].pNext;
+                feedback_create_infos[i].pPipelineCreationFeedback = &pipeline_feedbacks[i];
+                feedback_create_infos[i].pipelineStageCreationFeedbackCount = 1;
+                feedback_create_infos[i].pPipelineStageCreationFeedbacks = &stage_feedbacks[i];
+
+                chained_create_infos[i].pNext = &feedback_create_infos[i];
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        VkResult result = vkCreateComputePipelines(m_device, m_cache, create_info_count, chained_create_infos.data(), m_allocation_callbacks, pipelines);
+        double duration_ms = elapsed_ms(start);
+
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+
+        _record_feedback(pipeline_feedbacks, duration_ms);
+        return result;
+    }
+
+    PipelineCacheStats VulkanPipelineCache::get_stats() const {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        return m_stats;
+    }
+
+    void VulkanPipelineCache::_record_feedback(const std::vector<VkPipelineCreationFeedbackEXT>& pipeline_feedbacks, double duration_ms) {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+
+        // the call is timed as a whole, so the time is split evenly between the pipelines it created
+        double pipeline_ms = duration_ms / static_cast<double>(pipeline_feedbacks.size());
+        for (const VkPipelineCreationFeedbackEXT& feedback : pipeline_feedbacks) {
+            if (!m_creation_feedback || !(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT)) {
+                m_stats.unknown++;
+                m_stats.unknown_ms += pipeline_ms;
+            }
+            else if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT) {
+                m_stats.hits++;
+                m_stats.hit_ms += pipeline_ms;
+            }
+            else {
+                m_stats.misses++;
+                m_stats.miss_ms += pipeline_ms;
+            }
+        }
+    }
+
+    bool VulkanPipelineCache::save() {
+        auto start = std::chrono::steady_clock::now();
+
+        size_t data_size = 0;
+        if (vkGetPipelineCacheData(m_device, m_cache, &data_size, nullptr) != VK_SUCCESS || data_size == 0) {
+            std::cout << "failed to get pipeline cache data size\n";
+            return false;
+        }
+
+        std::vector<uint8_t> data(data_size);
+        if (vkGetPipelineCacheData(m_device, m_cache, &data_size, data.data()) != VK_SUCCESS) {
+            std::cout << "failed to get pipeline cache data\n";
+            return false;
+        }
+
+        std::string temporary_path = m_path + ".tmp";
+        std::FILE* file = std::fopen(temporary_path.c_str(), "wb");
+        if (file == nullptr) {
+            std::cout << "failed to open \"" << temporary_path << "\" to write the pipeline cache\n";
+            return false;
+        }
+
+        bool written = std::fwrite(data.data(), 1, data_size, file) == data_size;
+        written = std::fflush(file) == 0 && written;
+        std::fclose(file);
+
+        std::error_code error{};
+        if (!written) {
+            std::cout << "failed to write pipeline cache to \"" << temporary_path << "\"\n";
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+
+        std::filesystem::rename(temporary_path, m_path, error);
+        if (error) {
+            std::cout << "failed to replace pipeline cache \"" << m_path << "\": " << error.message() << "\n";
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_stats_mutex);
+            m_stats.save_ms = elapsed_ms(start);
+        }
+        std::cout << "saved pipeline cache to \"" << m_path << "\" (" << data_size << " bytes)\n";
+        return true;
+    }
+
+    void VulkanPipelineCache::print_stats() const {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        std::cout << "pipeline cache stats (" << (m_stats.loaded_from_disk ? "warm" : "cold") << " start):\n";
+        std::cout << "\t* load: " << m_stats.load_ms << "ms (" << m_stats.loaded_size << " bytes)\n";
+        std::cout << "\t* hits: " << m_stats.hits << " in " << m_stats.hit_ms << "ms\n";
+        std::cout << "\t* misses: " << m_stats.misses << " in " << m_stats.miss_ms << "ms\n";
+        std::cout << "\t* unknown: " << m_stats.unknown << " in " << m_stats.unknown_ms << "ms\n";
+        std::cout << "\t* save: " << m_stats.save_ms << "ms\n";
+    }
+
+    std::vector<uint8_t> VulkanPipelineCache::_load_validated_data() const {
+        std::FILE* file = std::fopen(m_path.c_str(), "rb");
+        if (file == nullptr) {
+            return {};
+        }
+
+        std::fseek(file, 0, SEEK_END);
+        long file_size = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+
+        std::vector<uint8_t> data{};
+        if (file_size > 0) {
+            data.resize(static_cast<size_t>(file_size));
+            if (std::fread(data.data(), 1, data.size(), file) != data.size()) {
+                data.clear();
+            }
+        }
+        std::fclose(file);
+
+        VkPipelineCacheHeaderVersionOne header{};
+        if (data.size() < sizeof(header)) {
+            std::cout << "pipeline cache \"" << m_path << "\" is too small to hold a header, ignoring it\n";
+            return {};
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        // a cache from a different driver or gpu is useless at best, so only hand over blobs made by this exact device
+        if (header.headerSize < sizeof(header) || header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+            header.vendorID != m_properties.vendorID || header.deviceID != m_properties.deviceID ||
+            std::memcmp(header.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+            std::cout << "pipeline cache \"" << m_path << "\" was made by a different device or driver, ignoring it\n";
+            return {};
+        }
+
+        return data;
+    }
+
+}
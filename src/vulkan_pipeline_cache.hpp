@@ -0,0 +1,67 @@
+#ifndef __VULKAN_PIPELINE_CACHE_HPP__
+#define __VULKAN_PIPELINE_CACHE_HPP__
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+namespace vlk {
+
+    struct PipelineCacheStats {
+        bool loaded_from_disk{ false };
+        size_t loaded_size{ 0 };
+        double load_ms{ 0.0 };
+        double save_ms{ 0.0 };
+
+        // hits and misses come from VK_EXT_pipeline_creation_feedback, without it every creation is counted as unknown
+        uint32_t hits{ 0 };
+        uint32_t misses{ 0 };
+        uint32_t unknown{ 0 };
+        double hit_ms{ 0.0 };
+        double miss_ms{ 0.0 };
+        double unknown_ms{ 0.0 };
+    };
+
+    class VulkanPipelineCache {
+    public:
+        static constexpr const char* DEFAULT_PATH = "pipeline_cache.bin";
+
+        VulkanPipelineCache(VkDevice device, const VkAllocationCallbacks* allocation_callbacks, const VkPhysicalDeviceProperties& properties, std::string path, bool creation_feedback);
+        ~VulkanPipelineCache();
+
+        inline VkPipelineCache get_cache() { return m_cache; }
+        inline const VkPipelineCache get_cache() const { return m_cache; }
+        PipelineCacheStats get_stats() const;
+
+        // thread safe, any number of threads can create pipelines through the cache at once
+        VkResult create_graphics_pipelines(uint32_t create_info_count, const VkGraphicsPipelineCreateInfo* create_infos, VkPipeline* pipelines);
+        VkResult create_compute_pipelines(uint32_t create_info_count, const VkComputePipelineCreateInfo* create_infos, VkPipeline* pipelines);
+
+        // writes to a temporary file first and renames it over the old cache, so a crash never leaves a half written cache behind
+        bool save();
+        void print_stats() const;
+
+    private:
+        std::vector<uint8_t> _load_validated_data() const;
+        void _record_feedback(const std::vector<VkPipelineCreationFeedbackEXT>& pipeline_feedbacks, double duration_ms);
+
+        VulkanPipelineCache(const VulkanPipelineCache& other) = delete;
+        VulkanPipelineCache& operator=(const VulkanPipelineCache& other) = delete;
+
+        VkDevice m_device{ nullptr };
+        const VkAllocationCallbacks* m_allocation_callbacks{ nullptr };
+        VkPhysicalDeviceProperties m_properties{};
+        std::string m_path{};
+        bool m_creation_feedback{ false };
+
+        VkPipelineCache m_cache{ nullptr };
+        PipelineCacheStats m_stats{};
+        mutable std::mutex m_stats_mutex{};
+    };
+
+}
+
+#endif // __VULKAN_PIPELINE_CACHE_HPP__
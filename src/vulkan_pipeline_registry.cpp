@@ -0,0 +1,443 @@
+#include "vulkan_pipeline_registry.hpp"
+#include "profiler.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+namespace vlk {
+
+    // 64 bit fnv-1a, fed one field at a time so padding never ends up in the hash
+    class DescriptionHasher {
+    public:
+        template<typename T>
+        inline void add(const T& value) {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+            for (size_t i = 0; i < sizeof(T); i++) {
+                m_hash ^= bytes[i];
+                m_hash *= 1099511628211ull;
+            }
+        }
+
+        inline uint64_t get() const { return m_hash; }
+
+    private:
+        uint64_t m_hash{ 14695981039346656037ull };
+    };
+
+    void GraphicsPipelineDescription::set_vertex_layout(const VkVertexInputBindingDescription& binding, const VkVertexInputAttributeDescription* attributes,
+        uint32_t count) {
+        if (count > MAX_VERTEX_ATTRIBUTES) {
+            std::cout << "failed to set vertex layout, " << count << " attributes is more than " << MAX_VERTEX_ATTRIBUTES << "\n";
+            std::exit(-1);
+        }
+
+        vertex_stride = binding.stride;
+        vertex_attribute_count = count;
+        for (uint32_t i = 0; i < count; i++) {
+            vertex_attributes[i] = attributes[i];
+        }
+    }
+
+    void GraphicsPipelineDescription::set_specialization(uint32_t constant_id, uint32_t value) {
+        for (uint32_t i = 0; i < specialization_count; i++) {
+            if (specialization_ids[i] == constant_id) {
+                specialization_values[i] = value;
+                return;
+            }
+        }
+
+        if (specialization_count == MAX_SPECIALIZATION_CONSTANTS) {
+            std::cout << "failed to set specialization constant " << constant_id << ", only " << MAX_SPECIALIZATION_CONSTANTS << " are supported\n";
+            std::exit(-1);
+        }
+
+        specialization_ids[specialization_count] = constant_id;
+        specialization_values[specialization_count] = value;
+        specialization_count++;
+    }
+
+    uint64_t GraphicsPipelineDescription::hash() const {
+        DescriptionHasher hasher{};
+        hasher.add(vertex_shader);
+        hasher.add(fragment_shader);
+        hasher.add(layout);
+        hasher.add(render_pass);
+        hasher.add(subpass);
+
+        hasher.add(vertex_stride);
+        hasher.add(vertex_attribute_count);
+        for (uint32_t i = 0; i < vertex_attribute_count; i++) {
+            hasher.add(vertex_attributes[i].location);
+            hasher.add(vertex_attributes[i].binding);
+            hasher.add(vertex_attributes[i].format);
+            hasher.add(vertex_attributes[i].offset);
+        }
+
+        hasher.add(topology);
+        hasher.add(polygon_mode);
+        hasher.add(cull_mode);
+        hasher.add(front_face);
+
+        hasher.add(depth_test);
+        hasher.add(depth_write);
+        hasher.add(depth_compare_op);
+
+        // blend factors don't matter when blending is off, leaving them out lets those descriptions share a pipeline
+        hasher.add(blend_enable);
+        if (blend_enable) {
+            hasher.add(src_color_blend_factor);
+            hasher.add(dst_color_blend_factor);
+            hasher.add(color_blend_op);
+            hasher.add(src_alpha_blend_factor);
+            hasher.add(dst_alpha_blend_factor);
+            hasher.add(alpha_blend_op);
+        }
+        hasher.add(color_write_mask);
+
+        hasher.add(color_format);
+        hasher.add(depth_format);
+        hasher.add(samples);
+
+        hasher.add(specialization_count);
+        for (uint32_t i = 0; i < specialization_count; i++) {
+            hasher.add(specialization_ids[i]);
+            hasher.add(specialization_values[i]);
+        }
+
+        return hasher.get();
+    }
+
+    bool GraphicsPipelineDescription::operator==(const GraphicsPipelineDescription& other) const {
+        if (vertex_shader != other.vertex_shader || fragment_shader != other.fragment_shader || layout != other.layout ||
+            render_pass != other.render_pass || subpass != other.subpass) {
+            return false;
+        }
+
+        if (vertex_stride != other.vertex_stride || vertex_attribute_count != other.vertex_attribute_count) {
+            return false;
+        }
+        for (uint32_t i = 0; i < vertex_attribute_count; i++) {
+            const VkVertexInputAttributeDescription& a = vertex_attributes[i];
+            const VkVertexInputAttributeDescription& b = other.vertex_attributes[i];
+            if (a.location != b.location || a.binding != b.binding || a.format != b.format || a.offset != b.offset) {
+                return false;
+            }
+        }
+
+        if (topology != other.topology || polygon_mode != other.polygon_mode || cull_mode != other.cull_mode || front_face != other.front_face) {
+            return false;
+        }
+
+        if (depth_test != other.depth_test || depth_write != other.depth_write || depth_compare_op != other.depth_compare_op) {
+            return false;
+        }
+
+        // same as hash(), blend factors only count when blending is on
+        if (blend_enable != other.blend_enable) {
+            return false;
+        }
+        if (blend_enable && (src_color_blend_factor != other.src_color_blend_factor || dst_color_blend_factor != other.dst_color_blend_factor ||
+            color_blend_op != other.color_blend_op || src_alpha_blend_factor != other.src_alpha_blend_factor ||
+            dst_alpha_blend_factor != other.dst_alpha_blend_factor || alpha_blend_op != other.alpha_blend_op)) {
+            return false;
+        }
+        if (color_write_mask != other.color_write_mask) {
+            return false;
+        }
+
+        if (color_format != other.color_format || depth_format != other.depth_format || samples != other.samples) {
+            return false;
+        }
+
+        if (specialization_count != other.specialization_count) {
+            return false;
+        }
+        for (uint32_t i = 0; i < specialization_count; i++) {
+            if (specialization_ids[i] != other.specialization_ids[i] || specialization_values[i] != other.specialization_values[i]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    uint64_t VulkanPipelineRegistry::LayoutKey::hash() const {
+        DescriptionHasher hasher{};
+        hasher.add(static_cast<uint32_t>(set_layouts.size()));
+        for (VkDescriptorSetLayout set_layout : set_layouts) {
+            hasher.add(set_layout);
+        }
+        hasher.add(push_constant_size);
+        hasher.add(push_constant_stages);
+
+        return hasher.get();
+    }
+
+    bool VulkanPipelineRegistry::LayoutKey::operator==(const LayoutKey& other) const {
+        return set_layouts == other.set_layouts && push_constant_size == other.push_constant_size &&
+            push_constant_stages == other.push_constant_stages;
+    }
+
+    VulkanPipelineRegistry::VulkanPipelineRegistry(VkDevice device, const VkAllocationCallbacks* allocation_callbacks, VulkanPipelineCache* cache)
+        : m_device(device), m_allocation_callbacks(allocation_callbacks), m_cache(cache) {
+    }
+
+    VulkanPipelineRegistry::~VulkanPipelineRegistry() {
+        wait_idle();
+
+        for (auto& [description, entry] : m_pipelines) {
+            vkDestroyPipeline(m_device, entry.pipeline, m_allocation_callbacks);
+        }
+
+        for (auto& [key, layout] : m_layouts) {
+            vkDestroyPipelineLayout(m_device, layout, m_allocation_callbacks);
+        }
+    }
+
+    PipelineRegistryStats VulkanPipelineRegistry::get_stats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        PipelineRegistryStats stats = m_stats;
+        stats.pipelines = m_pipelines.size();
+        stats.layouts = m_layouts.size();
+        return stats;
+    }
+
+    VkPipeline VulkanPipelineRegistry::get_or_create(const GraphicsPipelineDescription& description) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            auto found = m_pipelines.find(description);
+            if (found != m_pipelines.end()) {
+                // compiling it twice would just throw one away, wait for whoever got there first
+                PipelineEntry& entry = found->second;
+                m_pipeline_ready.wait(lock, [&]() { return !entry.pending; });
+                m_stats.hits++;
+                return entry.pipeline;
+            }
+
+            m_pipelines.emplace(description, PipelineEntry{});
+            m_stats.misses++;
+        }
+
+        VkPipeline pipeline = _create(description);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        _finish(description, pipeline);
+        return pipeline;
+    }
+
+    VkPipeline VulkanPipelineRegistry::request(const GraphicsPipelineDescription& description, ThreadPool* compile_pool, VkPipeline fallback) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_pipelines.find(description);
+        if (found != m_pipelines.end()) {
+            // still compiling counts too, the request will share it once it lands
+            m_stats.hits++;
+            return found->second.pending ? fallback : found->second.pipeline;
+        }
+
+        m_pipelines.emplace(description, PipelineEntry{});
+        m_stats.misses++;
+        m_stats.background_compiles++;
+        m_stats.pending++;
+        m_stats.peak_pending = std::max(m_stats.peak_pending, m_stats.pending);
+
+        // the description is flat, so the job gets its own copy and the caller's can go away
+        auto requested = std::chrono::steady_clock::now();
+        compile_pool->submit([this, description, requested](uint32_t) {
+            VkPipeline pipeline = _create(description);
+            double latency_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - requested).count();
+
+            // nothing of the registry is touched once the lock is released, it may be destroyed straight after
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.pending--;
+            m_stats.total_latency_ms += latency_ms;
+            m_stats.max_latency_ms = std::max(m_stats.max_latency_ms, latency_ms);
+            _finish(description, pipeline);
+        });
+
+        return fallback;
+    }
+
+    void VulkanPipelineRegistry::wait_idle() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_pipeline_ready.wait(lock, [&]() { return m_stats.pending == 0; });
+    }
+
+    void VulkanPipelineRegistry::_finish(const GraphicsPipelineDescription& description, VkPipeline pipeline) {
+        PipelineEntry& entry = m_pipelines[description];
+        entry.pipeline = pipeline;
+        entry.pending = false;
+        m_pipeline_ready.notify_all();
+    }
+
+    VkPipeline VulkanPipelineRegistry::_create(const GraphicsPipelineDescription& description) {
+        VLK_PROFILE_SCOPE("VulkanPipelineRegistry::_create");
+
+        VkSpecializationMapEntry map_entries[GraphicsPipelineDescription::MAX_SPECIALIZATION_CONSTANTS]{};
+        for (uint32_t i = 0; i < description.specialization_count; i++) {
+            map_entries[i].constantID = description.specialization_ids[i];
+            map_entries[i].offset = i * sizeof(uint32_t);
+            map_entries[i].size = sizeof(uint32_t);
+        }
+
+        VkSpecializationInfo specialization_info{};
+        specialization_info.mapEntryCount = description.specialization_count;
+        specialization_info.pMapEntries = map_entries;
+        specialization_info.dataSize = description.specialization_count * sizeof(uint32_t);
+        specialization_info.pData = description.specialization_values;
+
+        VkPipelineShaderStageCreateInfo stages[2]{};
+        stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        stages[0].module = description.vertex_shader;
+        stages[0].pName = "main";
+        stages[0].pSpecializationInfo = description.specialization_count > 0 ? &specialization_info : nullptr;
+
+        stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        stages[1].module = description.fragment_shader;
+        stages[1].pName = "main";
+        stages[1].pSpecializationInfo = stages[0].pSpecializationInfo;
+
+        VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+        VkPipelineDynamicStateCreateInfo dynamic_state{};
+        dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamic_state.dynamicStateCount = 2;
+        dynamic_state.pDynamicStates = dynamic_states;
+
+        VkVertexInputBindingDescription binding_description{};
+        binding_description.binding = 0;
+        binding_description.stride = description.vertex_stride;
+        binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        VkPipelineVertexInputStateCreateInfo vertex_input{};
+        vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertex_input.vertexBindingDescriptionCount = description.vertex_attribute_count > 0 ? 1 : 0;
+        vertex_input.pVertexBindingDescriptions = &binding_description;
+        vertex_input.vertexAttributeDescriptionCount = description.vertex_attribute_count;
+        vertex_input.pVertexAttributeDescriptions = description.vertex_attributes;
+
+        VkPipelineInputAssemblyStateCreateInfo input_assembly{};
+        input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        input_assembly.topology = description.topology;
+        input_assembly.primitiveRestartEnable = VK_FALSE;
+
+        // both dynamic, only the counts are read
+        VkPipelineViewportStateCreateInfo viewport_state{};
+        viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewport_state.viewportCount = 1;
+        viewport_state.scissorCount = 1;
+
+        VkPipelineRasterizationStateCreateInfo rasterizer{};
+        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizer.depthClampEnable = VK_FALSE;         // pushes everything further than the far culling point will be brought to that point, needs gpu feature enabled
+        rasterizer.rasterizerDiscardEnable = VK_FALSE;  // geometry never passes through the rasterizer basically disables the output to the framebuffer
+        rasterizer.polygonMode = description.polygon_mode;
+        rasterizer.lineWidth = 1.0f;
+        rasterizer.cullMode = description.cull_mode;
+        rasterizer.frontFace = description.front_face;
+        rasterizer.depthBiasEnable = VK_FALSE;
+
+        VkPipelineMultisampleStateCreateInfo multisampling{};
+        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampling.sampleShadingEnable = VK_FALSE;
+        multisampling.rasterizationSamples = description.samples;
+
+        VkPipelineDepthStencilStateCreateInfo depth_stencil{};
+        depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depth_stencil.depthTestEnable = description.depth_test;
+        depth_stencil.depthWriteEnable = description.depth_write;
+        depth_stencil.depthCompareOp = description.depth_compare_op;
+        depth_stencil.depthBoundsTestEnable = VK_FALSE;
+        depth_stencil.stencilTestEnable = VK_FALSE;
+
+        VkPipelineColorBlendAttachmentState color_blend_attachment_state{};
+        color_blend_attachment_state.colorWriteMask = description.color_write_mask;
+        color_blend_attachment_state.blendEnable = description.blend_enable;
+        color_blend_attachment_state.srcColorBlendFactor = description.src_color_blend_factor;
+        color_blend_attachment_state.dstColorBlendFactor = description.dst_color_blend_factor;
+        color_blend_attachment_state.colorBlendOp = description.color_blend_op;
+        color_blend_attachment_state.srcAlphaBlendFactor = description.src_alpha_blend_factor;
+        color_blend_attachment_state.dstAlphaBlendFactor = description.dst_alpha_blend_factor;
+        color_blend_attachment_state.alphaBlendOp = description.alpha_blend_op;
+
+        VkPipelineColorBlendStateCreateInfo color_blend_state{};
+        color_blend_state.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        color_blend_state.logicOpEnable = VK_FALSE;
+        color_blend_state.logicOp = VK_LOGIC_OP_COPY;
+        color_blend_state.attachmentCount = 1;
+        color_blend_state.pAttachments = &color_blend_attachment_state;
+
+        VkGraphicsPipelineCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        create_info.stageCount = 2;
+        create_info.pStages = stages;
+        create_info.pVertexInputState = &vertex_input;
+        create_info.pInputAssemblyState = &input_assembly;
+        create_info.pViewportState = &viewport_state;
+        create_info.pRasterizationState = &rasterizer;
+        create_info.pMultisampleState = &multisampling;
+        create_info.pDepthStencilState = &depth_stencil;
+        create_info.pColorBlendState = &color_blend_state;
+        create_info.pDynamicState = &dynamic_state;
+        create_info.layout = description.layout;
+        create_info.renderPass = description.render_pass;
+        create_info.subpass = description.subpass;
+
+        VkPipeline pipeline{};
+        if (m_cache->create_graphics_pipelines(1, &create_info, &pipeline) != VK_SUCCESS) {
+            std::cout << "failed to create graphics pipeline\n";
+            std::exit(-1);
+        }
+
+        return pipeline;
+    }
+
+    VkPipelineLayout VulkanPipelineRegistry::get_or_create_layout(const VkDescriptorSetLayout* set_layouts, uint32_t set_layout_count,
+        uint32_t push_constant_size, VkShaderStageFlags push_constant_stages) {
+        LayoutKey key{};
+        key.set_layouts.assign(set_layouts, set_layouts + set_layout_count);
+        key.push_constant_size = push_constant_size;
+        key.push_constant_stages = push_constant_stages;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_layouts.find(key);
+        if (found != m_layouts.end()) {
+            return found->second;
+        }
+
+        VkPushConstantRange push_constant_range{};
+        push_constant_range.stageFlags = push_constant_stages;
+        push_constant_range.offset = 0;
+        push_constant_range.size = push_constant_size;
+
+        VkPipelineLayoutCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        create_info.setLayoutCount = set_layout_count;
+        create_info.pSetLayouts = set_layouts;
+        create_info.pushConstantRangeCount = push_constant_size > 0 ? 1 : 0;
+        create_info.pPushConstantRanges = &push_constant_range;
+
+        VkPipelineLayout layout{};
+        if (vkCreatePipelineLayout(m_device, &create_info, m_allocation_callbacks, &layout) != VK_SUCCESS) {
+            std::cout << "failed to create pipeline layout\n";
+            std::exit(-1);
+        }
+
+        m_layouts.emplace(std::move(key), layout);
+        return layout;
+    }
+
+    void VulkanPipelineRegistry::print_stats() const {
+        PipelineRegistryStats stats = get_stats();
+        std::cout << "pipeline registry: " << stats.pipelines << " pipelines and " << stats.layouts << " layouts created, "
+            << stats.hits << " requests shared an existing pipeline\n";
+
+        if (stats.background_compiles > 0) {
+            std::cout << "\t* background compiles: " << stats.background_compiles << ", peak queue depth " << stats.peak_pending
+                << ", latency " << stats.total_latency_ms / stats.background_compiles << "ms average and " << stats.max_latency_ms << "ms max\n";
+        }
+    }
+
+}
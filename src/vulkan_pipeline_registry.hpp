@@ -0,0 +1,160 @@
+#ifndef __VULKAN_PIPELINE_REGISTRY_HPP__
+#define __VULKAN_PIPELINE_REGISTRY_HPP__
+
+#include "vulkan_pipeline_cache.hpp"
+#include "thread_pool.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+namespace vlk {
+
+    // everything that goes into a graphics pipeline, flat and fixed size so it can be hashed in one pass and copied around
+    // freely. viewport and scissor are always dynamic and there is a single interleaved vertex binding and color attachment.
+    // defaults are the opaque, depth tested, back face culled triangles the renderer draws
+    struct GraphicsPipelineDescription {
+        static constexpr uint32_t MAX_VERTEX_ATTRIBUTES = 8;
+        static constexpr uint32_t MAX_SPECIALIZATION_CONSTANTS = 8;
+
+        VkShaderModule vertex_shader{ nullptr };
+        VkShaderModule fragment_shader{ nullptr };
+        VkPipelineLayout layout{ nullptr };
+        VkRenderPass render_pass{ nullptr };
+        uint32_t subpass{ 0 };
+
+        // vertex layout
+        uint32_t vertex_stride{ 0 };
+        uint32_t vertex_attribute_count{ 0 };
+        VkVertexInputAttributeDescription vertex_attributes[MAX_VERTEX_ATTRIBUTES]{};
+
+        // raster
+        VkPrimitiveTopology topology{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST };
+        VkPolygonMode polygon_mode{ VK_POLYGON_MODE_FILL };
+        VkCullModeFlags cull_mode{ VK_CULL_MODE_BACK_BIT };
+        VkFrontFace front_face{ VK_FRONT_FACE_CLOCKWISE };
+
+        // depth
+        VkBool32 depth_test{ VK_TRUE };
+        VkBool32 depth_write{ VK_TRUE };
+        VkCompareOp depth_compare_op{ VK_COMPARE_OP_LESS };
+
+        // blend
+        VkBool32 blend_enable{ VK_TRUE };
+        VkBlendFactor src_color_blend_factor{ VK_BLEND_FACTOR_SRC_ALPHA };
+        VkBlendFactor dst_color_blend_factor{ VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA };
+        VkBlendOp color_blend_op{ VK_BLEND_OP_ADD };
+        VkBlendFactor src_alpha_blend_factor{ VK_BLEND_FACTOR_SRC_ALPHA };
+        VkBlendFactor dst_alpha_blend_factor{ VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA };
+        VkBlendOp alpha_blend_op{ VK_BLEND_OP_ADD };
+        VkColorComponentFlags color_write_mask{ VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                                VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT };
+
+        // attachments, have to match render_pass
+        VkFormat color_format{ VK_FORMAT_UNDEFINED };
+        VkFormat depth_format{ VK_FORMAT_UNDEFINED };
+        VkSampleCountFlagBits samples{ VK_SAMPLE_COUNT_1_BIT };
+
+        // 32 bit specialization constants handed to both stages, shader variants are picked with these instead of
+        // compiling more spir-v
+        uint32_t specialization_count{ 0 };
+        uint32_t specialization_ids[MAX_SPECIALIZATION_CONSTANTS]{};
+        uint32_t specialization_values[MAX_SPECIALIZATION_CONSTANTS]{};
+
+        void set_vertex_layout(const VkVertexInputBindingDescription& binding, const VkVertexInputAttributeDescription* attributes, uint32_t count);
+        void set_specialization(uint32_t constant_id, uint32_t value);
+
+        // only the used part of the arrays is hashed, so two descriptions asking for the same pipeline always match
+        uint64_t hash() const;
+        // compares exactly the fields hash() covers
+        bool operator==(const GraphicsPipelineDescription& other) const;
+        inline bool operator!=(const GraphicsPipelineDescription& other) const { return !(*this == other); }
+
+        struct Hasher {
+            inline size_t operator()(const GraphicsPipelineDescription& description) const { return static_cast<size_t>(description.hash()); }
+        };
+    };
+
+    struct PipelineRegistryStats {
+        size_t pipelines{ 0 };
+        size_t layouts{ 0 };
+        uint32_t hits{ 0 };                 // get_or_create and request calls that found it already there or compiling
+        uint32_t misses{ 0 };
+
+        // compiles queued by request, latency runs from the request to the pipeline being ready so it includes queueing
+        uint32_t background_compiles{ 0 };
+        uint32_t pending{ 0 };              // queued or compiling right now
+        uint32_t peak_pending{ 0 };
+        double total_latency_ms{ 0.0 };
+        double max_latency_ms{ 0.0 };
+    };
+
+    // pipelines and pipeline layouts keyed by what they were created from, so every identical request shares one object.
+    // lookups go through the hash and then compare the whole key, a collision never hands back the wrong object.
+    // everything lives as long as the registry, callers must not destroy what they get back. thread safe, pipelines can
+    // be created on the calling thread or compiled in the background on a thread pool
+    class VulkanPipelineRegistry {
+    public:
+        VulkanPipelineRegistry(VkDevice device, const VkAllocationCallbacks* allocation_callbacks, VulkanPipelineCache* cache);
+        ~VulkanPipelineRegistry();
+
+        PipelineRegistryStats get_stats() const;
+
+        // creates the pipeline on this thread, or waits for it when a background compile of it is already running
+        VkPipeline get_or_create(const GraphicsPipelineDescription& description);
+        // never blocks. returns the pipeline when it is ready, otherwise queues it on compile_pool (the first time it is
+        // asked for) and returns fallback, which may be null for the caller to skip the draw
+        VkPipeline request(const GraphicsPipelineDescription& description, ThreadPool* compile_pool, VkPipeline fallback = VK_NULL_HANDLE);
+        // blocks until every queued compile has finished
+        void wait_idle();
+
+        // a single push constant range starting at 0, push_constant_size 0 leaves it out
+        VkPipelineLayout get_or_create_layout(const VkDescriptorSetLayout* set_layouts, uint32_t set_layout_count,
+            uint32_t push_constant_size = 0, VkShaderStageFlags push_constant_stages = 0);
+
+        void print_stats() const;
+
+    private:
+        struct PipelineEntry {
+            VkPipeline pipeline{ nullptr };
+            bool pending{ true };           // being created by some thread, pipeline is still null
+        };
+
+        struct LayoutKey {
+            std::vector<VkDescriptorSetLayout> set_layouts{};
+            uint32_t push_constant_size{ 0 };
+            VkShaderStageFlags push_constant_stages{ 0 };
+
+            uint64_t hash() const;
+            bool operator==(const LayoutKey& other) const;
+
+            struct Hasher {
+                inline size_t operator()(const LayoutKey& key) const { return static_cast<size_t>(key.hash()); }
+            };
+        };
+
+        VkPipeline _create(const GraphicsPipelineDescription& description);
+        void _finish(const GraphicsPipelineDescription& description, VkPipeline pipeline); // with m_mutex held
+
+        VulkanPipelineRegistry(const VulkanPipelineRegistry& other) = delete;
+        VulkanPipelineRegistry& operator=(const VulkanPipelineRegistry& other) = delete;
+
+        VkDevice m_device{ nullptr };
+        const VkAllocationCallbacks* m_allocation_callbacks{ nullptr };
+        VulkanPipelineCache* m_cache{ nullptr };
+
+        mutable std::mutex m_mutex{};
+        std::condition_variable m_pipeline_ready{};
+        std::unordered_map<GraphicsPipelineDescription, PipelineEntry, GraphicsPipelineDescription::Hasher> m_pipelines{};
+        std::unordered_map<LayoutKey, VkPipelineLayout, LayoutKey::Hasher> m_layouts{};
+        PipelineRegistryStats m_stats{};
+    };
+
+}
+
+#endif // __VULKAN_PIPELINE_REGISTRY_HPP__
@@ -0,0 +1,83 @@
+#include "vulkan_shader_module_cache.hpp"
+
+#include <iostream>
+#include <cstring>
+
+namespace vlk {
+
+    VulkanShaderModuleCache::VulkanShaderModuleCache(VkDevice device, const VkAllocationCallbacks* allocation_callbacks)
+        : m_device(device), m_allocation_callbacks(allocation_callbacks) {}
+
+    VulkanShaderModuleCache::~VulkanShaderModuleCache() {
+        for (auto& [hash, entry] : m_modules) {
+            vkDestroyShaderModule(m_device, entry.module, m_allocation_callbacks);
+        }
+    }
+
+    bool VulkanShaderModuleCache::validate_spirv(const void* code, size_t code_size, std::string_view name) {
+        // spir-v is a stream of 32 bit words starting with a 5 word header, vkCreateShaderModule requires pCode to be 4 byte aligned
+        if (reinterpret_cast<uintptr_t>(code) % alignof(uint32_t) != 0) {
+            std::cout << "spir-v \"" << name << "\" is not 4 byte aligned\n";
+            return false;
+        }
+
+        if (code_size < 5 * sizeof(uint32_t) || code_size % sizeof(uint32_t) != 0) {
+            std::cout << "spir-v \"" << name << "\" has an invalid size of " << code_size << " bytes\n";
+            return false;
+        }
+
+        uint32_t magic_number = *static_cast<const uint32_t*>(code);
+        if (magic_number != SPIRV_MAGIC_NUMBER) {
+            std::cout << "spir-v \"" << name << "\" has an invalid magic number " << std::hex << magic_number << std::dec << "\n";
+            return false;
+        }
+
+        return true;
+    }
+
+    uint64_t VulkanShaderModuleCache::hash_spirv(const uint32_t* code, size_t code_size) {
+        // 64 bit fnv-1a over the words
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < code_size / sizeof(uint32_t); i++) {
+            hash ^= code[i];
+            hash *= 1099511628211ull;
+        }
+
+        return hash ^ code_size;
+    }
+
+    VkShaderModule VulkanShaderModuleCache::get_or_create(const uint32_t* code, size_t code_size, std::string_view name) {
+        if (!validate_spirv(code, code_size, name)) {
+            std::exit(-1);
+        }
+
+        uint64_t hash = hash_spirv(code, code_size);
+        auto [begin, end] = m_modules.equal_range(hash);
+        for (auto found = begin; found != end; found++) {
+            const std::vector<uint32_t>& cached = found->second.code;
+            if (cached.size() * sizeof(uint32_t) == code_size && std::memcmp(cached.data(), code, code_size) == 0) {
+                m_hits++;
+                return found->second.module;
+            }
+        }
+
+        VkShaderModuleCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        create_info.codeSize = code_size;
+        create_info.pCode = code;
+
+        VkShaderModule module{};
+        if (vkCreateShaderModule(m_device, &create_info, m_allocation_callbacks, &module) != VK_SUCCESS) {
+            std::cout << "failed to create shader module \"" << name << "\"\n";
+            std::exit(-1);
+        }
+
+        m_misses++;
+        Entry entry{};
+        entry.code.assign(code, code + code_size / sizeof(uint32_t));
+        entry.module = module;
+        m_modules.emplace(hash, std::move(entry));
+        return module;
+    }
+
+}
@@ -0,0 +1,52 @@
+#ifndef __VULKAN_SHADER_MODULE_CACHE_HPP__
+#define __VULKAN_SHADER_MODULE_CACHE_HPP__
+
+#include <vulkan/vulkan.h>
+
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace vlk {
+
+    // shader modules keyed by the hash of their spir-v, so pipelines sharing a shader share one module. a copy of the code
+    // is kept with each module and compared on a hit, so two shaders with the same hash never share a module. modules live
+    // as long as the cache, pipelines must not destroy them
+    class VulkanShaderModuleCache {
+    public:
+        static constexpr uint32_t SPIRV_MAGIC_NUMBER = 0x07230203;
+
+        VulkanShaderModuleCache(VkDevice device, const VkAllocationCallbacks* allocation_callbacks);
+        ~VulkanShaderModuleCache();
+
+        inline size_t get_module_count() const { return m_modules.size(); }
+        inline uint32_t get_hits() const { return m_hits; }
+        inline uint32_t get_misses() const { return m_misses; }
+
+        static bool validate_spirv(const void* code, size_t code_size, std::string_view name);
+        static uint64_t hash_spirv(const uint32_t* code, size_t code_size);
+
+        // code_size is in bytes, the same as VkShaderModuleCreateInfo::codeSize
+        VkShaderModule get_or_create(const uint32_t* code, size_t code_size, std::string_view name = "<memory>");
+
+    private:
+        struct Entry {
+            std::vector<uint32_t> code{};
+            VkShaderModule module{ nullptr };
+        };
+
+        VulkanShaderModuleCache(const VulkanShaderModuleCache& other) = delete;
+        VulkanShaderModuleCache& operator=(const VulkanShaderModuleCache& other) = delete;
+
+        VkDevice m_device{ nullptr };
+        const VkAllocationCallbacks* m_allocation_callbacks{ nullptr };
+        std::unordered_multimap<uint64_t, Entry> m_modules{};
+
+        uint32_t m_hits{ 0 };
+        uint32_t m_misses{ 0 };
+    };
+
+}
+
+#endif // __VULKAN_SHADER_MODULE_CACHE_HPP__
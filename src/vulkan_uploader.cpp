@@ -0,0 +1,360 @@
+#include "vulkan_uploader.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+namespace vlk {
+
+    VulkanUploader::VulkanUploader(VulkanDevice* device, VkDeviceSize staging_size) : m_device(device), m_dispatch(&device->get_dispatch()) {
+        m_timeline = m_device->get_timeline(QueueType::Transfer);
+        m_staging = new VulkanRingBuffer(m_device->get_allocator(), staging_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+        m_ownership = m_device->get_ownership_transfer(QueueType::Transfer, QueueType::Graphics);
+        m_copy_alignment = std::max<VkDeviceSize>(16, m_device->get_physical_device_properties().limits.optimalBufferCopyOffsetAlignment);
+
+        for (Batch& batch : m_batches) {
+            VkCommandPoolCreateInfo pool_create_info{};
+            pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            pool_create_info.queueFamilyIndex = m_device->get_queue_family(QueueType::Transfer);
+
+            if (vkCreateCommandPool(m_device->get_device(), &pool_create_info, m_device->get_allocation_callbacks(), &batch.command_pool) != VK_SUCCESS) {
+                std::cout << "failed to create upload command pool\n";
+                std::exit(-1);
+            }
+
+            VkCommandBufferAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.commandPool = batch.command_pool;
+            allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocate_info.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(m_device->get_device(), &allocate_info, &batch.command_buffer) != VK_SUCCESS) {
+                std::cout << "failed to allocate upload command buffer\n";
+                std::exit(-1);
+            }
+        }
+
+        std::cout << "successfully initialized uploader with " << staging_size << " bytes of staging memory"
+            << (m_ownership.is_required() ? " on a dedicated transfer queue\n" : "\n");
+    }
+
+    VulkanUploader::~VulkanUploader() {
+        wait_idle();
+
+        if (!m_pending.empty()) {
+            std::cout << "uploader destroyed with " << m_pending.size() << " uploads never submitted\n";
+        }
+
+        for (Batch& batch : m_batches) {
+            vkDestroyCommandPool(m_device->get_device(), batch.command_pool, m_device->get_allocation_callbacks());
+        }
+
+        delete m_staging;
+    }
+
+    UploadTicket VulkanUploader::upload_buffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size,
+            VkAccessFlags dst_access, VkPipelineStageFlags dst_stage) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        PendingUpload upload{};
+        upload.id = m_next_upload_id++;
+        upload.buffer = buffer;
+        upload.buffer_offset = offset;
+        upload.dst_access = dst_access;
+        upload.dst_stage = dst_stage;
+        upload.size = size;
+
+        // go straight into staging memory when nothing is queued ahead of it, otherwise keep a host copy until there is room
+        if (m_pending.empty() && m_staging->allocate(size, m_copy_alignment, &upload.staging_offset)) {
+            std::memcpy(m_staging->get_mapped() + upload.staging_offset, data, size);
+            upload.staged = size;
+        }
+        else {
+            upload.data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+        }
+
+        m_pending_bytes += size;
+        m_pending.push_back(std::move(upload));
+        return { m_pending.back().id };
+    }
+
+    UploadTicket VulkanUploader::upload_image(VkImage image, VkExtent3D extent, const VkImageSubresourceLayers& subresource, const void* data,
+            VkDeviceSize size, VkImageLayout final_layout, VkAccessFlags dst_access, VkPipelineStageFlags dst_stage) {
+        if (size > m_staging->get_capacity()) {
+            std::cout << "cannot upload a " << size << " byte image through a " << m_staging->get_capacity() << " byte staging ring\n";
+            std::exit(-1);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        PendingUpload upload{};
+        upload.id = m_next_upload_id++;
+        upload.is_image = true;
+        upload.image = image;
+        upload.image_extent = extent;
+        upload.image_subresource = subresource;
+        upload.final_layout = final_layout;
+        upload.dst_access = dst_access;
+        upload.dst_stage = dst_stage;
+        upload.size = size;
+
+        if (m_pending.empty() && m_staging->allocate(size, m_copy_alignment, &upload.staging_offset)) {
+            std::memcpy(m_staging->get_mapped() + upload.staging_offset, data, size);
+            upload.staged = size;
+        }
+        else {
+            upload.data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+        }
+
+        m_pending_bytes += size;
+        m_pending.push_back(std::move(upload));
+        return { m_pending.back().id };
+    }
+
+    void VulkanUploader::flush() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        _retire_batches(false);
+        if (m_pending.empty()) {
+            return;
+        }
+
+        // every batch is still on the gpu, leave the uploads queued for the next flush rather than waiting
+        Batch& batch = m_batches[m_next_batch];
+        if (batch.in_flight) {
+            return;
+        }
+
+        m_dispatch->vkResetCommandPool(m_device->get_device(), batch.command_pool, 0);
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        m_dispatch->vkBeginCommandBuffer(batch.command_buffer, &begin_info);
+
+        batch.serial = m_next_batch_serial++;
+        batch.last_upload = 0;
+        batch.buffer_acquires.clear();
+        batch.image_acquires.clear();
+        batch.acquire_stages = 0;
+
+        std::vector<VkBufferMemoryBarrier> buffer_barriers{};
+        std::vector<VkImageMemoryBarrier> image_barriers{};
+        VkPipelineStageFlags barrier_stages = 0;
+        bool recorded = false;
+
+        while (!m_pending.empty()) {
+            PendingUpload& upload = m_pending.front();
+            VkDeviceSize staged_before = upload.staged;
+            bool finished = _stage(upload, batch);
+            recorded = recorded || finished || upload.staged != staged_before;
+
+            if (!finished) {
+                break; // out of staging memory, the rest goes in a later batch once space retires
+            }
+
+            if (upload.is_image) {
+                VkImageSubresourceRange range{ upload.image_subresource.aspectMask, upload.image_subresource.mipLevel, 1,
+                    upload.image_subresource.baseArrayLayer, upload.image_subresource.layerCount };
+                image_barriers.push_back(m_ownership.image_barrier(upload.image, range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    upload.final_layout, VK_ACCESS_TRANSFER_WRITE_BIT, m_ownership.is_required() ? 0 : upload.dst_access));
+
+                if (m_ownership.is_required()) {
+                    batch.image_acquires.push_back(m_ownership.image_barrier(upload.image, range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        upload.final_layout, 0, upload.dst_access));
+                }
+            }
+            else {
+                buffer_barriers.push_back(m_ownership.buffer_barrier(upload.buffer, VK_ACCESS_TRANSFER_WRITE_BIT,
+                    m_ownership.is_required() ? 0 : upload.dst_access, upload.buffer_offset, upload.size));
+
+                if (m_ownership.is_required()) {
+                    batch.buffer_acquires.push_back(m_ownership.buffer_barrier(upload.buffer, 0, upload.dst_access,
+                        upload.buffer_offset, upload.size));
+                }
+            }
+
+            barrier_stages |= upload.dst_stage;
+            batch.acquire_stages |= upload.dst_stage;
+            batch.last_upload = upload.id;
+            m_pending_bytes -= upload.size;
+            m_pending.pop_front();
+        }
+
+        // one barrier for the whole batch. on a dedicated transfer queue this is the release half of the ownership transfer,
+        // which can't name graphics stages, otherwise it makes the copies visible to whatever reads them next
+        if (!buffer_barriers.empty() || !image_barriers.empty()) {
+            VkPipelineStageFlags dst_stages = m_ownership.is_required() ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : barrier_stages;
+            m_dispatch->vkCmdPipelineBarrier(batch.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stages, 0, 0, nullptr,
+                static_cast<uint32_t>(buffer_barriers.size()), buffer_barriers.data(),
+                static_cast<uint32_t>(image_barriers.size()), image_barriers.data());
+        }
+
+        m_dispatch->vkEndCommandBuffer(batch.command_buffer);
+
+        if (!recorded) {
+            return; // the ring is full of work that hasn't retired yet
+        }
+
+        batch.timeline_value = m_timeline->submit(&batch.command_buffer, 1);
+        if (batch.timeline_value == 0) {
+            std::cout << "failed to submit upload batch\n";
+            std::exit(-1);
+        }
+
+        m_staging->mark(batch.serial);
+        batch.in_flight = true;
+        m_next_batch = (m_next_batch + 1) % MAX_BATCHES_IN_FLIGHT;
+
+        // the acquiring submit waits on this batch's value, so the barriers can go in the very next frame
+        if (m_ownership.is_required()) {
+            m_ready_buffer_acquires.insert(m_ready_buffer_acquires.end(), batch.buffer_acquires.begin(), batch.buffer_acquires.end());
+            m_ready_image_acquires.insert(m_ready_image_acquires.end(), batch.image_acquires.begin(), batch.image_acquires.end());
+            m_ready_acquire_stages |= batch.acquire_stages;
+            m_ready_upload = std::max(m_ready_upload, batch.last_upload);
+            m_ready_timeline_value = batch.timeline_value;
+        }
+    }
+
+    TimelineWait VulkanUploader::record_acquire_barriers(VkCommandBuffer command_buffer) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        _retire_batches(false);
+        if (m_ready_buffer_acquires.empty() && m_ready_image_acquires.empty()) {
+            return {};
+        }
+
+        // the timeline wait blocks the same stages the barrier starts from, which chains the acquire after the release
+        m_dispatch->vkCmdPipelineBarrier(command_buffer, m_ready_acquire_stages, m_ready_acquire_stages, 0, 0, nullptr,
+            static_cast<uint32_t>(m_ready_buffer_acquires.size()), m_ready_buffer_acquires.data(),
+            static_cast<uint32_t>(m_ready_image_acquires.size()), m_ready_image_acquires.data());
+
+        TimelineWait wait = m_timeline->wait_for(m_ready_timeline_value, m_ready_acquire_stages);
+
+        m_ready_buffer_acquires.clear();
+        m_ready_image_acquires.clear();
+        m_ready_acquire_stages = 0;
+        m_completed_upload = std::max(m_completed_upload, m_ready_upload);
+        return wait;
+    }
+
+    bool VulkanUploader::is_complete(UploadTicket ticket) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        _retire_batches(false);
+        return ticket.id <= m_completed_upload;
+    }
+
+    void VulkanUploader::wait(UploadTicket ticket) {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                _retire_batches(false);
+                if (ticket.id <= m_retired_upload) {
+                    return;
+                }
+            }
+
+            flush();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            _retire_batches(true);
+        }
+    }
+
+    void VulkanUploader::wait_idle() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        _retire_batches(true);
+    }
+
+    void VulkanUploader::_retire_batches(bool wait) {
+        // batches finish in submission order, so walk from the oldest and stop at the first one still running
+        for (uint32_t i = 0; i < MAX_BATCHES_IN_FLIGHT; i++) {
+            Batch& batch = m_batches[(m_next_batch + i) % MAX_BATCHES_IN_FLIGHT];
+            if (!batch.in_flight) {
+                continue;
+            }
+
+            if (wait) {
+                m_timeline->wait(batch.timeline_value);
+            }
+            else if (!m_timeline->is_complete(batch.timeline_value)) {
+                break;
+            }
+
+            batch.in_flight = false;
+            m_staging->release(batch.serial);
+            m_retired_upload = std::max(m_retired_upload, batch.last_upload);
+
+            // with a dedicated transfer queue the upload only completes once its acquire barrier has been recorded
+            if (!m_ownership.is_required()) {
+                m_completed_upload = std::max(m_completed_upload, batch.last_upload);
+            }
+        }
+    }
+
+    bool VulkanUploader::_stage(PendingUpload& upload, Batch& batch) {
+        if (upload.is_image) {
+            if (upload.staged != upload.size) {
+                if (!m_staging->allocate(upload.size, m_copy_alignment, &upload.staging_offset)) {
+                    return false;
+                }
+                std::memcpy(m_staging->get_mapped() + upload.staging_offset, upload.data.data(), upload.size);
+                upload.staged = upload.size;
+            }
+
+            VkImageSubresourceRange range{ upload.image_subresource.aspectMask, upload.image_subresource.mipLevel, 1,
+                upload.image_subresource.baseArrayLayer, upload.image_subresource.layerCount };
+
+            VkImageMemoryBarrier to_transfer{};
+            to_transfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            to_transfer.srcAccessMask = 0;
+            to_transfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            to_transfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            to_transfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            to_transfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            to_transfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            to_transfer.image = upload.image;
+            to_transfer.subresourceRange = range;
+
+            m_dispatch->vkCmdPipelineBarrier(batch.command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                0, nullptr, 0, nullptr, 1, &to_transfer);
+
+            VkBufferImageCopy region{};
+            region.bufferOffset = upload.staging_offset;
+            region.imageSubresource = upload.image_subresource;
+            region.imageExtent = upload.image_extent;
+
+            m_dispatch->vkCmdCopyBufferToImage(batch.command_buffer, m_staging->get_buffer(), upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+            return true;
+        }
+
+        if (upload.data.empty()) {
+            // staged in full when it was queued
+            VkBufferCopy region{ upload.staging_offset, upload.buffer_offset, upload.size };
+            m_dispatch->vkCmdCopyBuffer(batch.command_buffer, m_staging->get_buffer(), upload.buffer, 1, &region);
+            return true;
+        }
+
+        // large buffers are streamed through the ring in chunks across as many batches as it takes
+        VkDeviceSize max_chunk = std::max<VkDeviceSize>(m_staging->get_capacity() / 4, m_copy_alignment);
+        while (upload.staged < upload.size) {
+            VkDeviceSize chunk = std::min(upload.size - upload.staged, max_chunk);
+            VkDeviceSize staging_offset = 0;
+            if (!m_staging->allocate(chunk, m_copy_alignment, &staging_offset)) {
+                return false;
+            }
+
+            std::memcpy(m_staging->get_mapped() + staging_offset, upload.data.data() + upload.staged, chunk);
+
+            VkBufferCopy region{ staging_offset, upload.buffer_offset + upload.staged, chunk };
+            m_dispatch->vkCmdCopyBuffer(batch.command_buffer, m_staging->get_buffer(), upload.buffer, 1, &region);
+            upload.staged += chunk;
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,121 @@
+#ifndef __VULKAN_UPLOADER_HPP__
+#define __VULKAN_UPLOADER_HPP__
+
+#include "vulkan_device.hpp"
+#include "vulkan_allocator.hpp"
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <cstdint>
+
+namespace vlk {
+
+    struct UploadTicket {
+        uint64_t id{ 0 }; // 0 is never handed out, so a default ticket is always complete
+    };
+
+    // streams buffer and image data to the gpu through a persistently mapped staging ring. uploads are batched into one
+    // command buffer per flush and submitted on the transfer queue, uploads that don't fit are carried over to later flushes
+    // instead of stalling. when the transfer queue is dedicated, the render loop must call record_acquire_barriers so the
+    // graphics queue takes ownership of the submitted resources, and make the frame's submit wait on what it returns
+    class VulkanUploader {
+    public:
+        static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 32ull * 1024 * 1024;
+        static constexpr uint32_t MAX_BATCHES_IN_FLIGHT = 4;
+
+        VulkanUploader(VulkanDevice* device, VkDeviceSize staging_size = DEFAULT_STAGING_SIZE);
+        ~VulkanUploader();
+
+        inline VkDeviceSize get_pending_bytes() const { return m_pending_bytes; }
+
+        // the data is copied before returning, so the caller can free it straight away
+        UploadTicket upload_buffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size,
+            VkAccessFlags dst_access, VkPipelineStageFlags dst_stage);
+        // uploads one mip level of a color image and leaves it in final_layout, the image must fit in the staging ring
+        UploadTicket upload_image(VkImage image, VkExtent3D extent, const VkImageSubresourceLayers& subresource, const void* data,
+            VkDeviceSize size, VkImageLayout final_layout, VkAccessFlags dst_access, VkPipelineStageFlags dst_stage);
+
+        // submits everything queued since the last flush that fits in the ring as a single batch, never blocks. call once a frame
+        void flush();
+        // records the graphics queue half of the ownership transfers for submitted batches, does nothing without a dedicated
+        // transfer queue. must be recorded outside of a render pass. the returned transfer timeline wait has to be added to
+        // the submit of command_buffer, it is empty when nothing was recorded
+        TimelineWait record_acquire_barriers(VkCommandBuffer command_buffer);
+
+        bool is_complete(UploadTicket ticket);
+        // blocks until the copies for the ticket have finished on the gpu, meant for loading screens and shutdown
+        void wait(UploadTicket ticket);
+        void wait_idle();
+
+    private:
+        struct PendingUpload {
+            uint64_t id{ 0 };
+            bool is_image{ false };
+
+            VkBuffer buffer{ nullptr };
+            VkDeviceSize buffer_offset{ 0 };
+
+            VkImage image{ nullptr };
+            VkExtent3D image_extent{};
+            VkImageSubresourceLayers image_subresource{};
+            VkImageLayout final_layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+
+            VkAccessFlags dst_access{ 0 };
+            VkPipelineStageFlags dst_stage{ 0 };
+
+            std::vector<uint8_t> data{}; // host copy, only used when the upload couldn't go straight into staging memory
+            VkDeviceSize size{ 0 };
+            VkDeviceSize staged{ 0 };    // bytes already copied into the ring
+            VkDeviceSize staging_offset{ 0 };
+        };
+
+        struct Batch {
+            VkCommandPool command_pool{ nullptr };
+            VkCommandBuffer command_buffer{ nullptr };
+            uint64_t timeline_value{ 0 }; // transfer timeline value signaled once the copies finish
+            bool in_flight{ false };
+            uint64_t serial{ 0 };
+            uint64_t last_upload{ 0 }; // highest upload id that is fully contained in this batch or an earlier one
+
+            std::vector<VkBufferMemoryBarrier> buffer_acquires{};
+            std::vector<VkImageMemoryBarrier> image_acquires{};
+            VkPipelineStageFlags acquire_stages{ 0 };
+        };
+
+        void _retire_batches(bool wait);
+        // copies the upload into staging memory and records its copy commands, returns false if it ran out of staging memory
+        bool _stage(PendingUpload& upload, Batch& batch);
+
+        VulkanUploader(const VulkanUploader& other) = delete;
+        VulkanUploader& operator=(const VulkanUploader& other) = delete;
+
+        VulkanDevice* m_device{ nullptr };
+        const VulkanDeviceDispatch* m_dispatch{ nullptr };
+        QueueTimeline* m_timeline{ nullptr };
+        VulkanRingBuffer* m_staging{ nullptr };
+        QueueOwnershipTransfer m_ownership{};
+        VkDeviceSize m_copy_alignment{ 16 };
+
+        std::mutex m_mutex{};
+        std::deque<PendingUpload> m_pending{};
+        VkDeviceSize m_pending_bytes{ 0 };
+        Batch m_batches[MAX_BATCHES_IN_FLIGHT]{};
+        uint32_t m_next_batch{ 0 };
+        uint64_t m_next_upload_id{ 1 };
+        uint64_t m_next_batch_serial{ 1 };
+        uint64_t m_completed_upload{ 0 };
+        uint64_t m_retired_upload{ 0 }; // copies finished on the gpu and staging memory released
+
+        // submitted batches whose acquire barriers still have to be recorded on the graphics queue. the graphics submit
+        // waits on the transfer timeline instead of the cpu waiting for the copies to finish
+        std::vector<VkBufferMemoryBarrier> m_ready_buffer_acquires{};
+        std::vector<VkImageMemoryBarrier> m_ready_image_acquires{};
+        VkPipelineStageFlags m_ready_acquire_stages{ 0 };
+        uint64_t m_ready_upload{ 0 };
+        uint64_t m_ready_timeline_value{ 0 };
+    };
+
+}
+
+#endif // __VULKAN_UPLOADER_HPP__